@@ -0,0 +1,294 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# ©2011 Massachusetts Institute of Technology
+
+# Turns qemu_data.defines_uses into the descriptors in iferret_du.h.
+# make_du_table.py writes them out as a C table.
+#
+# The lambdas in defines_uses are run on stand-in args.  A stand-in
+# formats as SENTINEL+k, so "REGS_%d" % args[0] comes out as a name
+# with a number we can spot, and memrange/field_from_env are swapped
+# for ones that just say which arg they were given.  Where a lambda
+# looks at an arg (args[1] != 0xffffffff, "if args[1]") it gets run
+# both ways, and whatever only shows up one way gets that as a guard.
+
+import qemu_data
+
+SENTINEL = 0x7ff00000
+
+# location ids.  memory bytes are their addresses, everything else
+# is a slot (IFERRET_DU_SLOT in iferret_du.h)
+SLOT_BASE = 1 << 40
+
+# what (IFERRET_DU_IS_*)
+DU_SLOT = 0
+DU_SLOT_ARG = 1
+DU_ENV = 2
+DU_MEM = 3
+
+# guard (IFERRET_DU_GUARD_*)
+GUARD_NONE = 0
+GUARD_NE = 1
+GUARD_EQ = 2
+
+NO_SIZE_ARG = 0xff
+
+# slots for names like REGS_n.  anything past these isn't a location.
+FAMILY_SIZE = 256
+FAMILY_SIZES = { 'IO_%x': 0x10000 }
+
+# most descriptors an op can have (IFERRET_DU_MAX)
+DU_MAX = 64
+
+class Du(object):
+    """iferret_du_t"""
+    def __init__(self, what=DU_SLOT, arg=0, size_arg=NO_SIZE_ARG,
+                 guard=GUARD_NONE, guard_arg=0, guard_val=0, slot=0, num=0):
+        self.what, self.arg, self.size_arg = what, arg, size_arg
+        self.guard, self.guard_arg, self.guard_val = guard, guard_arg, guard_val
+        self.slot, self.num = slot, num
+
+class CantCompile(Exception):
+    pass
+
+# Stand-ins
+
+class Shift(object):
+    """1 << args[k]"""
+    def __init__(self, k):
+        self.k = k
+
+class Mem(object):
+    def __init__(self, k, size):
+        self.k = k
+        self.size = size
+
+class Env(object):
+    def __init__(self, k):
+        self.k = k
+
+class Arg(object):
+    def __init__(self, run, k):
+        self.run = run
+        self.k = k
+    def __int__(self):
+        return SENTINEL + self.k
+    __index__ = __int__
+    __long__ = __int__
+    def __nonzero__(self):
+        return self.run.ask(('bool', self.k))
+    __bool__ = __nonzero__
+    def __ne__(self, other):
+        return self.run.ask(('ne', self.k, other))
+    def __eq__(self, other):
+        return not self.run.ask(('ne', self.k, other))
+    def __hash__(self):
+        return hash(self.k)
+    def __rlshift__(self, other):
+        if other != 1: raise CantCompile("%d << arg" % other)
+        return Shift(self.k)
+
+class Args(object):
+    def __init__(self, run):
+        self.run = run
+    def __getitem__(self, k):
+        if not isinstance(k, int): raise CantCompile("args[%r]" % (k,))
+        return Arg(self.run, k)
+
+class Run(object):
+    """One way through a lambda: answers to whatever it asks about its args"""
+    def __init__(self, answers):
+        self.answers = answers
+        self.new = None
+    def ask(self, q):
+        if q in self.answers:
+            return self.answers[q]
+        if self.new is None:
+            self.new = q
+        return False
+
+def fake_memrange(start, length):
+    if not isinstance(start, Arg): raise CantCompile("memrange of %r" % (start,))
+    if isinstance(length, Shift):
+        return [Mem(start.k, length)]
+    if isinstance(length, Arg): raise CantCompile("memrange of arg length")
+    return [Mem(start.k, int(length))]
+
+def fake_field_from_env(off):
+    if not isinstance(off, Arg): raise CantCompile("env field of %r" % (off,))
+    return [Env(off.k)]
+
+def ways(f):
+    """[(answers, what f returns)] for every way through f"""
+    done = []
+    todo = [{}]
+    while todo:
+        answers = todo.pop()
+        run = Run(answers)
+        out = f(Args(run))
+        if run.new is not None:
+            for v in False, True:
+                a = dict(answers)
+                a[run.new] = v
+                todo.append(a)
+            continue
+        done.append((answers, out))
+    return done
+
+def flatten(out):
+    for x in out:
+        # field_from_env's stand-in is a list, and ends up inside one
+        if isinstance(x, list):
+            for y in x: yield y
+        else:
+            yield x
+
+class Slots(object):
+    """Slot numbers for everything that isn't memory"""
+    def __init__(self):
+        self.slot = {}
+        self.family = {}
+        self.num = 0
+        # (name, 1) or (family, its size), in slot order
+        self.order = []
+    @classmethod
+    def from_table(cls, table):
+        """the same slots again, from what order was"""
+        slots = cls()
+        for name, n in table:
+            if n > 1: slots.add_family(name, n)
+            else: slots.new(name)
+        return slots
+    def new(self, name):
+        if name not in self.slot:
+            self.slot[name] = self.num
+            self.order.append((name, 1))
+            self.num += 1
+        return self.slot[name]
+    def add_family(self, fmt, n=None):
+        if fmt in self.family: return self.family[fmt]
+        if n is None: n = FAMILY_SIZES.get(fmt, FAMILY_SIZE)
+        base = self.num
+        for i in range(n):
+            name = fmt % i
+            # a name on its own can't have got a slot before its family
+            if name in self.slot:
+                raise CantCompile("%s is already a slot" % name)
+            self.slot[name] = base + i
+        self.num += n
+        self.order.append((fmt, n))
+        self.family[fmt] = (base, n)
+        return self.family[fmt]
+    def id(self, name):
+        if name.startswith('MEM_'):
+            return int(name[4:], 16)
+        return SLOT_BASE + self.new(name)
+    def ranges(self, names):
+        """names as coalesced [lo, hi) pairs"""
+        ids = sorted(set(self.id(n) for n in names))
+        r = []
+        for i in ids:
+            if r and r[-1][1] == i:
+                r[-1][1] = i + 1
+            else:
+                r.append([i, i + 1])
+        return r
+
+def name_key(x):
+    """something to tell equal defs and uses apart by, and (fmt, k) for names with an arg in"""
+    if isinstance(x, Mem):
+        if isinstance(x.size, Shift): return ('mem', x.k, None, x.size.k)
+        return ('mem', x.k, x.size, None)
+    if isinstance(x, Env):
+        return ('env', x.k)
+    if not isinstance(x, str):
+        raise CantCompile("don't know what %r is" % (x,))
+    for k in range(8):
+        for fmt in '%d', '%x':
+            s = fmt % (SENTINEL + k)
+            if s in x:
+                return ('family', x.replace(s, fmt), k)
+    if str(SENTINEL)[:4] in x or ('%x' % SENTINEL)[:4] in x:
+        raise CantCompile("can't tell which arg is in %s" % x)
+    return ('name', x)
+
+def guard_of(item, ways_in, ways_all):
+    """the one answer that decides whether item is there.  ways are indices into ways_all."""
+    if len(ways_in) == len(ways_all):
+        return (GUARD_NONE, 0, 0)
+    qs = set()
+    for a, _ in ways_all: qs.update(a.keys())
+    for q in qs:
+        for v in False, True:
+            has = set(i for i, w in enumerate(ways_all) if w[0].get(q) == v)
+            if has == set(ways_in):
+                val = 0 if q[0] == 'bool' else q[2]
+                return ((GUARD_NE if v else GUARD_EQ), q[1], val)
+    raise CantCompile("no one thing decides %r" % (item,))
+
+def items_of(f):
+    """[(key, guard)] for what f returns"""
+    ws = ways(f)
+    keys = []
+    seen = {}
+    for i, w in enumerate(ws):
+        for x in flatten(w[1]):
+            key = name_key(x)
+            if key not in seen:
+                seen[key] = set()
+                keys.append(key)
+            seen[key].add(i)
+    return [(key, guard_of(key, seen[key], ws)) for key in keys]
+
+def descriptors(items, slots):
+    du = []
+    for key, (guard, guard_arg, guard_val) in items:
+        d = Du(guard=guard, guard_arg=guard_arg, guard_val=guard_val)
+        if key[0] == 'mem':
+            d.what, d.arg = DU_MEM, key[1]
+            if key[3] is not None: d.size_arg = key[3]
+            else: d.num = key[2]
+        elif key[0] == 'env':
+            d.what, d.arg = DU_ENV, key[1]
+        elif key[0] == 'family':
+            d.what, d.arg = DU_SLOT_ARG, key[2]
+            d.slot, d.num = slots.family[key[1]]
+        else:
+            d.what = DU_SLOT
+            d.slot = slots.new(key[1])
+        du.append(d)
+    return du
+
+def compile_ops(ops, slots):
+    """{op name: (defs, uses)} for the ops in defines_uses that are in ops,
+    and the ones of those whose lambdas do things we can't follow"""
+    saved = qemu_data.memrange, qemu_data.field_from_env
+    qemu_data.memrange, qemu_data.field_from_env = fake_memrange, fake_field_from_env
+    try:
+        items = {}
+        failed = set()
+        for name, (d, u) in qemu_data.defines_uses.items():
+            if name not in ops: continue
+            try:
+                items[name] = (items_of(d), items_of(u))
+            except (CantCompile, TypeError, ValueError):
+                failed.add(name)
+                continue
+            if len(items[name][0]) + len(items[name][1]) > DU_MAX:
+                del items[name]
+                failed.add(name)
+    finally:
+        qemu_data.memrange, qemu_data.field_from_env = saved
+    # families first, so REGS_0 on its own is the same slot as REGS_%d with 0
+    for name in sorted(items):
+        for key, _ in items[name][0] + items[name][1]:
+            if key[0] == 'family': slots.add_family(key[1])
+    out = {}
+    for name in sorted(items):
+        out[name] = (descriptors(items[name][0], slots), descriptors(items[name][1], slots))
+    return out, failed
+
+def env_table(slots):
+    """where env fields start, and their slots"""
+    return ([c[0] for c in qemu_data.CPUX86State_ranges],
+            [slots.new(c[2]) for c in qemu_data.CPUX86State_ranges])
@@ -4,7 +4,10 @@
 
 import sys
 from immutablelist import ImmutableList
+import iferret_ops
 from iferret_ops import iferret_log_op_enum_r
+import du_compile
+from qemu_data import defines_uses, defines, uses
 from ctypes import *
 
 iferret = cdll.LoadLibrary("./iferret.so")
@@ -20,6 +23,35 @@ OP_IS_VALID  = 0x1
 OP_IN_SLICE  = 0x2
 OP_IS_OUTPUT = 0x4 
 
+# see op_arr_next_access in iferret.c
+ACCESS_LD   = 0x1
+ACCESS_ST   = 0x2
+ACCESS_VIRT = 0x4
+
+# ops that aren't valid are filed under this (OP_POST_INVALID)
+OP_INVALID = 'IFLO_DUMMY_LAST'
+
+def op_num(op):
+    if isinstance(op, str):
+        return getattr(iferret_ops, op)
+    return op
+
+def is_access(e, addr, how):
+    """Does python-side op e get at addr?  Same rules as op_mem in iferret.c."""
+    if not e or not e.op.startswith('IFLO_OPS_MEM_'): return False
+    st = e.op.startswith('IFLO_OPS_MEM_ST')
+    if not how & (ACCESS_ST if st else ACCESS_LD): return False
+    if e.op.endswith('_ENV_A0'):
+        return not how & ACCESS_VIRT and e.args[2] == addr
+    return e.args[2 if how & ACCESS_VIRT else 1] == addr
+
+# IFERRET_POST_NONE
+POST_NONE = 2**64 - 1
+
+def none_if_none(i):
+    if i == POST_NONE: return None
+    return i
+
 class CArray(object):
     def __init__(self, cptr, n):
         self.cptr = cptr
@@ -38,54 +70,50 @@ class CArray(object):
     def __repr__(self):
         return repr(list(self))
 
-class ValUnion(Union):
-    _fields_ = [
-        ("u8", c_ubyte),
-        ("u16", c_ushort),
-        ("u32", c_uint),
-        ("u64", c_ulong),
-        ("str", c_char_p),
-    ]
+iferret.iferret_log_arg_fmt.restype = c_char_p
 
-class iferret_op_arg_t(Structure):
-    _fields_ = [
-        ("typ", c_uint),
-        ("_val", ValUnion),
-    ]
+# op number -> format of its args
+arg_fmts = {}
+
+def arg_fmt(num):
+    if num not in arg_fmts:
+        arg_fmts[num] = iferret.iferret_log_arg_fmt(num)
+    return arg_fmts[num]
+
+# args are stored as 8-byte ints.  strings are pointers to interned C strings.
+def arg_val(fmt, v):
+    if fmt == 's':
+        return string_at(v)
+    return v
+
+def arg_repr(fmt, v):
+    if fmt == 's':
+        return "'" + arg_val(fmt, v) + "'"
+    else:
+        return "%#x" % v
+
+class iferret_op_t(object):
+    """View of op i of an op_arr_t's store (not of its trace)."""
+
+    def __init__(self, arr, i):
+        self.arr = arr
+        self.i = i
 
     @property
-    def val(self):
-        if self.typ == IFLAT_UI8:
-            return self._val.u8
-        elif self.typ == IFLAT_UI16:
-            return self._val.u16
-        elif self.typ == IFLAT_UI32:
-            return self._val.u32
-        elif self.typ == IFLAT_UI64:
-            return self._val.u64
-        elif self.typ == IFLAT_STR:
-            return self._val.str
+    def num(self):
+        return self.arr._opnum[self.i]
 
-    def __str__(self):
-        if self.typ == IFLAT_STR:
-            return self.val
-        else:
-            return "%#x" % self.val
+    @property
+    def num_args(self):
+        return self.arr._num_args[self.i]
 
-    def __repr__(self):
-        if self.typ == IFLAT_STR:
-            return "'" + self.val + "'"
-        else:
-            return "%#x" % self.val
+    @property
+    def flags(self):
+        return self.arr._flags[self.i]
 
-class iferret_op_t(Structure):
-    _fields_ = [
-        ("num", c_uint),
-        ("_args", POINTER(iferret_op_arg_t)),
-        ("num_args", c_uint),
-        ("flags", c_uint),
-        ("syscall", c_void_p),
-    ]
+    @flags.setter
+    def flags(self, value):
+        self.arr._flags[self.i] = value
 
     @property
     def in_slice(self):
@@ -120,9 +148,13 @@ class iferret_op_t(Structure):
         else:
             self.flags &= ~OP_IS_OUTPUT
 
+    def _raw_args(self):
+        off = self.arr._arg_off[self.i]
+        return zip(arg_fmt(self.num), self.arr._arg[off:off+self.num_args])
+
     @property
     def args(self):
-        return [a.val for a in CArray(self._args, self.num_args)]
+        return [arg_val(f, v) for f, v in self._raw_args()]
 
     @property
     def op(self):
@@ -139,54 +171,81 @@ class iferret_op_t(Structure):
         return repr(self)
 
     def __repr__(self):
-        return "%s(%s)" % (self.op, ",".join(repr(x) for x in CArray(self._args, self.num_args)))
+        return "%s(%s)" % (self.op, ",".join(arg_repr(f, v) for f, v in self._raw_args()))
 
+# see op_arr_t in iferret.c.  indices are into the trace, 
+# which the C side maps to the store.
 class op_arr_t(Structure):
     _fields_ = [
         ("num", c_ulong),
         ("max", c_ulong),
-        ("_ops", POINTER(iferret_op_t)),
+        ("_opnum", POINTER(c_uint)),
+        ("_flags", POINTER(c_ubyte)),
+        ("_num_args", POINTER(c_ubyte)),
+        ("_arg_off", POINTER(c_ulong)),
+        ("_arg", POINTER(c_ulong)),
+        ("num_arg", c_ulong),
+        ("max_arg", c_ulong),
     ]
 
     def __getitem__(self, i):
-        if i < 0: i = self.num + i
-        if not 0 <= i < self.num: raise IndexError(i)
+        n = len(self)
+        if i < 0: i = n + i
+        if not 0 <= i < n: raise IndexError(i)
+
+        return iferret_op_t(self, iferret.op_arr_at(byref(self), i))
 
-        return self._ops[i]
+    def splice(self, i, j, n):
+        """Replace ops i..j-1 with n cleared ones.
+        Returns where in the store the first of them is."""
+        return iferret.op_arr_splice(byref(self), i, j, n)
 
     def __setitem__(self, i, v):
         #print "Setting", i, "to", `v`
-        iferret.op_arr_clear(byref(self), i, 1)
+        self.splice(i, i+1, 1)
 
     def __setslice__(self, i, j, seq):
         #print "Setting %d-%d to %s" % (i,j,seq)
-        n = len(seq)
-
-        if j - i < n:
-            iferret.op_arr_movedown(byref(self), j, n-(j-i))
-
-        iferret.op_arr_clear(byref(self), i, n)
-
-        if j - i > n:
-            iferret.op_arr_moveup(byref(self), j, (j - i) - n)
+        self.splice(i, j, len(seq))
 
     def __delitem__(self, i):
         del self[i:i+1]    
 
     def __delslice__(self, i, j):
-        if i < 0: i = self.num + i
-        if j > self.num: j = self.num
-        if not 0 <= i < self.num: raise IndexError(i)
+        n = len(self)
+        if i < 0: i = n + i
+        if j > n: j = n
+        if not 0 <= i < n: raise IndexError(i)
         #print "Deleting from %d-%d" % (i,j)
 
-        iferret.op_arr_moveup(byref(self), j, j-i)
+        self.splice(i, j, 0)
 
     def __len__(self):
-        return self.num
+        return iferret.op_arr_len(byref(self))
 
     def optimize(self):
         iferret.op_arr_fit(byref(self))
 
+    # these find things through the posting lists (see op_arr_post).
+    # None if there's nothing to find.
+
+    def next_op(self, i, op):
+        """First op at or after i that's an op"""
+        return none_if_none(iferret.op_arr_next_op(byref(self), i, op_num(op)))
+
+    def prev_op(self, i, op):
+        """Last op at or before i that's an op"""
+        return none_if_none(iferret.op_arr_prev_op(byref(self), i, op_num(op)))
+
+    def next_access(self, i, addr, how):
+        """First access to addr at or after i.
+        how is ACCESS_LD and/or ACCESS_ST, maybe with ACCESS_VIRT."""
+        return none_if_none(iferret.op_arr_next_access(byref(self), i, addr, how))
+
+    def prev_access(self, i, addr, how):
+        """Last access to addr at or before i"""
+        return none_if_none(iferret.op_arr_prev_access(byref(self), i, addr, how))
+
     def find_interrupts(self):
         ints = []
         a, b = c_int(), c_int()
@@ -210,10 +269,25 @@ class op_arr_t(Structure):
             ret = iferret.op_arr_find_input(byref(self), ret+1, addr, pointer(t))
         return ins
 
+iferret.op_arr_len.argtypes = [POINTER(op_arr_t)]
+iferret.op_arr_len.restype = c_ulong
+iferret.op_arr_at.argtypes = [POINTER(op_arr_t), c_ulong]
+iferret.op_arr_at.restype = c_ulong
+iferret.op_arr_splice.argtypes = [POINTER(op_arr_t), c_ulong, c_ulong, c_ulong]
+iferret.op_arr_splice.restype = c_ulong
+for f in ["next_op", "prev_op"]:
+    getattr(iferret, "op_arr_" + f).argtypes = [POINTER(op_arr_t), c_ulong, c_uint]
+    getattr(iferret, "op_arr_" + f).restype = c_ulong
+for f in ["next_access", "prev_access"]:
+    getattr(iferret, "op_arr_" + f).argtypes = [POINTER(op_arr_t), c_ulong, c_uint, c_int]
+    getattr(iferret, "op_arr_" + f).restype = c_ulong
+
+# ops put in from python are kept in shadow, 
+# by where their cleared stand-ins are in the store
 class py_op_arr:
     def __init__(self, trace):
         self.trace = trace
-        self.shadow = [0]*len(trace)
+        self.shadow = {}
     def __getitem__(self, i):
         if isinstance(i, slice):
             start, stop, step = i.start, i.stop, i.step
@@ -226,29 +300,182 @@ class py_op_arr:
         if e.is_valid:
             return e
         else:
-            return self.shadow[i]
+            return self.shadow.get(e.i, 0)
     def __setitem__(self, i, v):
-        self.trace[i] = v
-        self.shadow[i] = v
+        self.shadow[self.trace.splice(i, i+1, 1)] = v
     def __delitem__(self, i):
         del self[i:i+1]    
     def __setslice__(self, i, j, seq):
-        self.trace[i:j] = seq
-        self.shadow[i:j] = seq
+        k = self.trace.splice(i, j, len(seq))
+        for v in seq:
+            self.shadow[k] = v
+            k += 1
     def __delslice__(self, i, j):
         del self.trace[i:j]
-        del self.shadow[i:j]
     def __len__(self):
         return len(self.trace)
     def optimize(self):
         self.trace.optimize()
+    # the store doesn't know about the ops kept here, which sit where 
+    # the trace's ops aren't valid.  k is the store's answer.
+    def _next(self, i, k, match):
+        j = self.trace.next_op(i, OP_INVALID)
+        while j is not None and (k is None or j < k):
+            if match(self.shadow.get(self.trace[j].i, 0)):
+                return j
+            j = self.trace.next_op(j+1, OP_INVALID)
+        return k
+    def _prev(self, i, k, match):
+        j = self.trace.prev_op(i, OP_INVALID)
+        while j is not None and (k is None or j > k):
+            if match(self.shadow.get(self.trace[j].i, 0)):
+                return j
+            j = self.trace.prev_op(j-1, OP_INVALID) if j > 0 else None
+        return k
+    def next_op(self, i, op):
+        op = iferret_log_op_enum_r[op_num(op)]
+        return self._next(i, self.trace.next_op(i, op), lambda e: e and e.op == op)
+    def prev_op(self, i, op):
+        op = iferret_log_op_enum_r[op_num(op)]
+        return self._prev(i, self.trace.prev_op(i, op), lambda e: e and e.op == op)
+    def next_access(self, i, addr, how):
+        return self._next(i, self.trace.next_access(i, addr, how), lambda e: is_access(e, addr, how))
+    def prev_access(self, i, addr, how):
+        return self._prev(i, self.trace.prev_access(i, addr, how), lambda e: is_access(e, addr, how))
     def find_interrupts(self):
         return self.trace.find_interrupts()
     def find_inputs(self, addr):
         return self.trace.find_inputs(addr)
+    def _slice_new(self):
+        """A slicer in iferret.c for this trace, told about the ops kept here"""
+        slots = slice_setup()
+        s = iferret.iferret_slice_new(byref(self.trace))
+        def extra(k, e):
+            if e.op not in defines_uses:
+                iferret.iferret_slice_extra(s, k, None, -1, 0)
+                return
+            d, u = slots.ranges(defines(e)), slots.ranges(uses(e))
+            r = [x for lohi in d + u for x in lohi]
+            iferret.iferret_slice_extra(s, k, (c_ulong * len(r))(*r), len(d), len(u))
+        for k, e in self.shadow.items():
+            if not e: continue
+            extra(k, e)
+            if e.in_slice:
+                iferret_op_t(self.trace, k).in_slice = True
+        for op in slice_python_ops:
+            i = self.trace.next_op(0, op)
+            while i is not None:
+                e = self.trace[i]
+                extra(e.i, e)
+                i = self.trace.next_op(i+1, op)
+        return s
+    def _slice_done(self, s):
+        iferret.iferret_slice_free(s)
+        # the slicer marked the stand-ins for the ops kept here
+        for k, e in self.shadow.items():
+            if not e: continue
+            flags = iferret_op_t(self.trace, k).flags
+            if flags & OP_IN_SLICE:
+                e.mark()
+            if flags & OP_IS_OUTPUT:
+                e.set_output_label("out")
+    def _slice_bad(self, s):
+        i = iferret.iferret_slice_bad(s)
+        if i == POST_NONE: return
+        print self[i].op, "not defined"
+        sys.exit(1)
+    def slice(self, worklist, output_track=False):
+        """newslice.multislice, done by the slicer in iferret.c"""
+        slots = slice_setup()
+        s = self._slice_new()
+        try:
+            for i, bufs in worklist:
+                if i == -1: i = len(self) - 1
+                for lo, hi in slots.ranges(bufs):
+                    iferret.iferret_slice_add(s, i, lo, hi)
+            if iferret.iferret_slice_run(s, output_track) == -1:
+                self._slice_bad(s)
+        finally:
+            self._slice_done(s)
     def __hash__(self):
         return id(self)
 
+# see "Slicing." in iferret.c
+iferret.iferret_slice_new.argtypes = [POINTER(op_arr_t)]
+iferret.iferret_slice_new.restype = c_void_p
+iferret.iferret_slice_free.argtypes = [c_void_p]
+iferret.iferret_slice_add.argtypes = [c_void_p, c_ulong, c_ulong, c_ulong]
+iferret.iferret_slice_extra.argtypes = [c_void_p, c_ulong, POINTER(c_ulong), c_int, c_uint]
+iferret.iferret_slice_run.argtypes = [c_void_p, c_int]
+iferret.iferret_slice_bad.argtypes = [c_void_p]
+iferret.iferret_slice_bad.restype = c_ulong
+
+# see iferret_du.h
+class iferret_op_du_t(Structure):
+    _fields_ = [
+        ("off", c_uint),
+        ("num_def", c_ushort),
+        ("num_use", c_ushort),
+        ("known", c_ubyte),
+    ]
+
+class iferret_du_slot_t(Structure):
+    _fields_ = [
+        ("name", c_char_p),
+        ("n", c_uint),
+    ]
+
+# slot numbers for the slicer's locations, and ops it has to be told 
+# about one at a time.  set up the first time we slice.
+slice_slots = None
+slice_python_ops = set()
+
+def slice_setup():
+    """Get the slots iferret.so's def/use table uses"""
+    global slice_slots
+    if slice_slots is not None: return slice_slots
+    n = c_uint.in_dll(iferret, "iferret_du_num_slots").value
+    table = (iferret_du_slot_t * n).in_dll(iferret, "iferret_du_slots")
+    slots = du_compile.Slots.from_table([(t.name, t.n) for t in table])
+    op_du = (iferret_op_du_t * iferret_ops.IFLO_DUMMY_LAST).in_dll(iferret, "iferret_op_du")
+    for name in defines_uses:
+        if hasattr(iferret_ops, name) and not op_du[op_num(name)].known:
+            slice_python_ops.add(name)
+    slice_slots = slots
+    return slots
+
+# see "Slice closure." in iferret.c
+iferret.iferret_closure_new.restype = c_void_p
+iferret.iferret_closure_free.argtypes = [c_void_p]
+iferret.iferret_closure_add.argtypes = [c_void_p, c_void_p, c_uint, c_ulong, c_ulong]
+iferret.iferret_closure_run.argtypes = [c_void_p, POINTER(c_ulong), POINTER(c_ulong)]
+
+def slice_closure(groups):
+    """newslice.slice_closure, done in iferret.c.  groups is a list of
+    lists of (py_op_arr, start, end), one list per TB.
+    Returns how many rounds of slicing it took, and how many ops
+    went in the slice to make instances agree."""
+    slicers = {}
+    c = iferret.iferret_closure_new()
+    try:
+        for g, insts in enumerate(groups):
+            for trace, start, end in insts:
+                if trace not in slicers:
+                    slicers[trace] = trace._slice_new()
+                iferret.iferret_closure_add(c, slicers[trace], g, start, end)
+        rounds, num_new = c_ulong(), c_ulong()
+        ret = iferret.iferret_closure_run(c, byref(rounds), byref(num_new))
+        iferret.iferret_closure_free(c)
+        c = None
+        if ret == -1:
+            for trace, s in slicers.items():
+                trace._slice_bad(s)
+        return rounds.value, num_new.value
+    finally:
+        if c is not None: iferret.iferret_closure_free(c)
+        for trace, s in slicers.items():
+            trace._slice_done(s)
+
 def load_trace(base, start=0, num=1):
     iferret.init.restype = POINTER(op_arr_t)
     oa = iferret.init(base, start, num)
@@ -257,6 +484,93 @@ def load_trace(base, start=0, num=1):
     trace = py_op_arr(oa.contents)
     return trace
 
+# see iferret_cursor_t in iferret.c
+iferret.iferret_cursor_open.restype = c_void_p
+for f in ["close", "seek", "next", "prev", "filter", "pos", "store", "index", "num",
+          "find_tb", "find_label"]:
+    getattr(iferret, "iferret_cursor_" + f).argtypes = [c_void_p]
+iferret.iferret_cursor_seek.argtypes = [c_void_p, c_ulong]
+iferret.iferret_cursor_filter.argtypes = [c_void_p, POINTER(c_uint), c_int]
+iferret.iferret_cursor_pos.restype = c_ulong
+iferret.iferret_cursor_store.restype = POINTER(op_arr_t)
+iferret.iferret_cursor_index.restype = c_ulong
+iferret.iferret_cursor_num.restype = c_ulong
+iferret.iferret_cursor_find_tb.argtypes = [c_void_p, c_uint, c_ulong]
+iferret.iferret_cursor_find_tb.restype = c_ulong
+iferret.iferret_cursor_find_label.argtypes = [c_void_p, c_uint, c_ulong]
+iferret.iferret_cursor_find_label.restype = c_ulong
+CURSOR_NONE = 2**64 - 1
+
+class cursor(object):
+    """Walks a trace an op at a time, without loading it.
+    An op it hands back is only good until the cursor moves."""
+
+    def __init__(self, base, start=0, num=1):
+        self.c = iferret.iferret_cursor_open(base, start, num)
+
+    def close(self):
+        if self.c:
+            iferret.iferret_cursor_close(self.c)
+            self.c = None
+
+    def __del__(self):
+        self.close()
+
+    def op(self):
+        return iferret_op_t(iferret.iferret_cursor_store(self.c).contents,
+                            iferret.iferret_cursor_index(self.c))
+
+    def next(self):
+        if iferret.iferret_cursor_next(self.c):
+            return self.op()
+        return None
+
+    def prev(self):
+        if iferret.iferret_cursor_prev(self.c):
+            return self.op()
+        return None
+
+    def seek(self, i):
+        if iferret.iferret_cursor_seek(self.c, i):
+            return self.op()
+        return None
+
+    def pos(self):
+        return iferret.iferret_cursor_pos(self.c)
+
+    def filter(self, ops):
+        """Only stop at ops numbered in ops.  [] stops at all of them."""
+        a = (c_uint * len(ops))(*ops)
+        iferret.iferret_cursor_filter(self.c, a, len(ops))
+
+    def __len__(self):
+        return iferret.iferret_cursor_num(self.c)
+
+    # these go by the trace's index, building it first if need be
+
+    def find_tb(self, eip, i=0):
+        """Index of the first IFLO_TB_HEAD_EIP for eip at or after op i, or None."""
+        j = iferret.iferret_cursor_find_tb(self.c, eip, i)
+        return None if j == CURSOR_NONE else j
+
+    def find_label(self, num, i=0):
+        """Index of the first op numbered num (IFLO_LABEL_INPUT or 
+        IFLO_LABEL_OUTPUT) at or after op i, or None."""
+        j = iferret.iferret_cursor_find_label(self.c, num, i)
+        return None if j == CURSOR_NONE else j
+
+def scan(base, start=0, num=1, ops=None):
+    """(index, op) for each op in a trace, in order, without loading it.
+    If ops is given, only for ops numbered in it."""
+    c = cursor(base, start, num)
+    if ops is not None:
+        c.filter(ops)
+    op = c.next()
+    while op is not None:
+        yield c.pos(), op
+        op = c.next()
+    c.close()
+
 if __name__ == "__main__":
     trace = load_trace(sys.argv[1], int(sys.argv[2]), int(sys.argv[3]))
     import IPython
@@ -0,0 +1,85 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# ©2011 Massachusetts Institute of Technology
+
+# Writes qemu_data.defines_uses out as a C table, for the slicer in
+# iferret.so and anything else native that wants to know what an op
+# defines and uses (see iferret_du.h).  Run it after
+# make_iferret_code.pl, and again whenever qemu_data.py changes.
+
+import os, sys
+
+import iferret_ops
+import qemu_data
+import du_compile
+
+if 'IFERRET_DIR' not in os.environ:
+    sys.exit("IFERRET_DIR env variable not available.")
+
+out = os.path.join(os.environ['IFERRET_DIR'], 'target-i386', 'iferret_du_table.h')
+
+enum = iferret_ops.iferret_log_op_enum_r
+slots = du_compile.Slots()
+ops, failed = du_compile.compile_ops(set(enum), slots)
+env_off, env_slot = du_compile.env_table(slots)
+
+def du_str(d):
+    return "{%d, %d, %#x, %d, %d, %#x, %d, %#x}" % (
+        d.what, d.arg, d.size_arg, d.guard, d.guard_arg, d.guard_val, d.slot, d.num)
+
+f = open(out, "w")
+f.write("// NB: This code is auto-generated by make_du_table.py (in dynslicer). \n")
+f.write("// It contains what each info-flow op defines and uses, from \n")
+f.write("// qemu_data.defines_uses.  See iferret_du.h.\n")
+f.write("#ifndef __IFERRET_DU_TABLE_H_ \n")
+f.write("#define __IFERRET_DU_TABLE_H_ \n")
+f.write("\n")
+f.write("// {what, arg, size_arg, guard, guard_arg, guard_val, slot, num}\n")
+f.write("iferret_du_t iferret_du[] = {\n")
+off = {}
+n = 0
+for name in sorted(ops):
+    d, u = ops[name]
+    off[name] = n
+    f.write("  // %s: %d defs, %d uses\n" % (name, len(d), len(u)))
+    for x in d + u:
+        f.write("  %s,\n" % du_str(x))
+    n += len(d) + len(u)
+# so it isn't empty
+f.write("  {0, 0, 0, 0, 0, 0, 0, 0}\n")
+f.write("};\n")
+f.write("\n")
+f.write("// {off, num_def, num_use, known}, by op.  the rest aren't known.\n")
+f.write("iferret_op_du_t iferret_op_du[IFLO_DUMMY_LAST] = {\n")
+for name in enum:
+    if name not in ops: continue
+    d, u = ops[name]
+    f.write("  [%s] = {%d, %d, %d, 1},\n" % (name, off[name], len(d), len(u)))
+f.write("};\n")
+f.write("\n")
+f.write("// {name, n}, in slot order\n")
+f.write("iferret_du_slot_t iferret_du_slots[] = {\n")
+for name, k in slots.order:
+    f.write("  {\"%s\", %d},\n" % (name, k))
+f.write("};\n")
+f.write("uint32_t iferret_du_num_slots = %d;\n" % len(slots.order))
+f.write("\n")
+f.write("// CPUX86State fields: where they start, and their slots\n")
+f.write("uint32_t iferret_du_env_off[] = {\n")
+for i in range(0, len(env_off), 8):
+    f.write("  %s,\n" % ", ".join(str(x) for x in env_off[i:i+8]))
+f.write("};\n")
+f.write("uint32_t iferret_du_env_slot[] = {\n")
+for i in range(0, len(env_slot), 8):
+    f.write("  %s,\n" % ", ".join(str(x) for x in env_slot[i:i+8]))
+f.write("};\n")
+f.write("uint32_t iferret_du_env_num = %d;\n" % len(env_off))
+f.write("\n")
+f.write("#endif\n")
+f.close()
+
+print "%s: %d ops, %d slots" % (out, len(ops), slots.num)
+for name in sorted(failed):
+    print "left to python:", name
+for name in sorted(qemu_data.defines_uses):
+    if name not in enum: print "not an op:", name
@@ -87,6 +87,10 @@ def dynslice(insns, bufs, start=-1, output_track=False, debug=False):
     multislice(insns, [ (start, bufs) ], output_track, debug)
 
 def multislice(insns, worklist, output_track=False, debug=False):
+    if isinstance(insns, iferretpy.py_op_arr) and not debug:
+        insns.slice(worklist, output_track)
+        return
+
     wlist = worklist[:]
     wlist.sort()
     start, bufs = wlist.pop()
@@ -278,12 +282,14 @@ def get_tb_retval(tb):
     return None
 
 def get_last_write(trace, addr, site):
-    i = site
-    while i > 0:
-        if (trace[i].op.startswith('IFLO_OPS_MEM_ST') and
-            trace[i].args[2] == addr):
-            return trace[i]
-        i -= 1
+    """Last store to virtual address addr before site.
+       *_ENV_A0 stores (64- and 128-bit) only log a physical
+       address, so they are never found here.  Matching their args[2],
+       as this used to, compared that physical address to addr, and
+       their args[-1] is not the value stored."""
+    i = trace.prev_access(site, addr, iferretpy.ACCESS_ST | iferretpy.ACCESS_VIRT)
+    if i:
+        return trace[i]
     return None
 
 def get_function_arg(trace, arg, esp, callsite):
@@ -381,7 +387,12 @@ def slice_closure(tbdict):
     print "Performing slice closure..."
     fp_iterations = 0
     outerst = time.time()
-    while True:
+    native = all(isinstance(t.trace, iferretpy.py_op_arr) for tbs in tbdict.values() for t in tbs)
+    if native:
+        groups = [[(t.trace, t.start, t.end) for t in tbs] for tbs in tbdict.values()]
+        fp_iterations, num_new = iferretpy.slice_closure(groups)
+        print "Sliced %d new instructions" % num_new
+    while not native:
         innerst = time.time()
         wlist = defaultdict(list)
         for t in tbdict:
@@ -887,27 +898,28 @@ def tracedbg(trace, fname):
             memdbg(f, e)
     f.close()
 
+def next_stl(trace, i, addr):
+    i = trace.next_access(i, addr, iferretpy.ACCESS_ST)
+    while i is not None and not trace[i].op.startswith('IFLO_OPS_MEM_STL'):
+        i = trace.next_access(i+1, addr, iferretpy.ACCESS_ST)
+    return i
+
 def find_self_interrupts(trace, apic_base=0xfee00000):
     apic_icr = apic_base + 0x300
     apic_tpr = apic_base + 0x80
     selfints = []
-    SELFINT, TPRSET, INTSTART, INTEND = range(4)
-    state = SELFINT
-    self_int, tpr_set, int_start, int_end = (0,0,0,0)
-    for i,e in enumerate(trace):
-        if state == SELFINT and e.op.startswith('IFLO_OPS_MEM_STL') and e.args[1] == apic_icr:
-            self_int = i
-            state = TPRSET
-        elif state == TPRSET and e.op.startswith('IFLO_OPS_MEM_STL') and e.args[1] == apic_tpr:
-            tpr_set = i
-            state = INTSTART
-        elif state == INTSTART and e.op == 'IFLO_INTERRUPT':
-            int_start = i
-            state = INTEND
-        elif state == INTEND and e.op == 'IFLO_IRET_PROTECTED':
-            int_end = i
-            selfints.append( (self_int, tpr_set, int_start, int_end) )
-            state = SELFINT
+    i = 0
+    while True:
+        self_int = next_stl(trace, i, apic_icr)
+        if self_int is None: break
+        tpr_set = next_stl(trace, self_int+1, apic_tpr)
+        if tpr_set is None: break
+        int_start = trace.next_op(tpr_set+1, 'IFLO_INTERRUPT')
+        if int_start is None: break
+        int_end = trace.next_op(int_start+1, 'IFLO_IRET_PROTECTED')
+        if int_end is None: break
+        selfints.append( (self_int, tpr_set, int_start, int_end) )
+        i = int_end+1
 
     return selfints
 
@@ -5,7 +5,10 @@ export IFERRET_DIR=`pwd`
 cd target-i386
 ./make_iferret_code.pl
 
-cd ..
+cd ../../dynslicer
+./make_du_table.py
+
+cd $IFERRET_DIR
 ./configure --disable-kqemu --prefix=$IFERRET_DIR/install --target-list=i386-softmmu  --disable-linux-user --disable-darwin-user
 #-DIFERRET_INFO_FLOW" 
 
@@ -37,9 +37,8 @@
 
 int tb_invalidated_flag;
 
-uint8_t iferret_says_flush = 1;
-
 void check_rollup(char *label);
+extern uint8_t iferret_log_full;
 
 //#define DEBUG_EXEC
 //#define DEBUG_SIGNAL
@@ -154,7 +153,8 @@ static TranslationBlock *tb_find_slow(target_ulong pc,
         if (tb->pc == pc &&
             tb->page_addr[0] == phys_page1 &&
             tb->cs_base == cs_base &&
-            tb->flags == flags) {
+            tb->flags == flags &&
+            (tb->cflags & CF_IFERRET_MASK) == iferret_tb_cflags(pc)) {
             /* check next page if needed */
             if (tb->page_addr[1] != -1) {
                 virt_page2 = (pc & TARGET_PAGE_MASK) +
@@ -172,7 +172,6 @@ static TranslationBlock *tb_find_slow(target_ulong pc,
     /* if no translated code available, then translate it now */
     tb = tb_alloc(pc);
     if (!tb) {
-      iferret_says_flush = 0;
         /* flush must be done */
         tb_flush(env);
         /* cannot fail at this point */
@@ -184,6 +183,7 @@ static TranslationBlock *tb_find_slow(target_ulong pc,
     tb->tc_ptr = tc_ptr;
     tb->cs_base = cs_base;
     tb->flags = flags;
+    tb->cflags = iferret_tb_cflags(pc);
     SAVE_GLOBALS();
     cpu_gen_code(env, tb, &code_gen_size);
     RESTORE_GLOBALS();
@@ -270,23 +270,10 @@ static inline TranslationBlock *tb_find_fast(void)
 #error unsupported CPU
 #endif
 
-    // TRL 2009 10 29.  Why is this here instead of earlier in fn? 
-    // because it needs the value of pc, you idiot, which we now have.
-    
-    if (iferret_says_flush==1) {
-      iferret_says_flush = 0;  
-      /* flush must be done */
-      tb_flush(env);
-      /* cannot fail at this point */
-      tb = tb_alloc(pc);
-      /* don't forget to invalidate previous TB info */
-      tb_invalidated_flag = 1;
-      printf ("TB cache flushed by request. \n");
-    }
-
     tb = env->tb_jmp_cache[tb_jmp_cache_hash_func(pc)];
     if (__builtin_expect(!tb || tb->pc != pc || tb->cs_base != cs_base ||
-                         tb->flags != flags, 0)) {
+                         tb->flags != flags ||
+                         (tb->cflags & CF_IFERRET_MASK) != iferret_tb_cflags(pc), 0)) {
         tb = tb_find_slow(pc, cs_base, flags);
         /* Note: we do it here to avoid a gcc bug on Mac OS X when
            doing it in tb_find_slow */
@@ -699,13 +686,15 @@ int cpu_exec(CPUState *env1)
 
 
 
-	 	check_rollup("cpu_exec.c 1 ");
+		if (iferret_log_full)
+		    check_rollup("cpu_exec.c 1 ");
 	    
 
                 gen_func();
 
 
-	 	check_rollup("cpu_exec.c 2 ");
+		if (iferret_log_full)
+		    check_rollup("cpu_exec.c 2 ");
 
 #endif
                 env->current_tb = NULL;
@@ -160,6 +160,9 @@ typedef struct TranslationBlock {
 #define CF_TB_FP_USED  0x0002 /* fp ops are used in the TB */
 #define CF_FP_USED     0x0004 /* fp ops are used in the TB or in a chained TB */
 #define CF_SINGLE_INSN 0x0008 /* compile only a single instruction */
+#define CF_IFERRET_INFO_FLOW 0x0010 /* compiled from the info-flow logging ops */
+#define CF_IFERRET_PROC 0x0020 /* translated in a process the trace filter picked */
+#define CF_IFERRET_MASK (CF_IFERRET_INFO_FLOW | CF_IFERRET_PROC)
 
     uint8_t *tc_ptr;    /* pointer to the translated code */
     /* next matching tb for physical address. */
@@ -183,6 +186,8 @@ typedef struct TranslationBlock {
        jmp_first */
     struct TranslationBlock *jmp_next[2];
     struct TranslationBlock *jmp_first;
+    /* id of iferret log template for this tb */
+    uint32_t iferret_schema;
 } TranslationBlock;
 
 static inline unsigned int tb_jmp_cache_hash_page(target_ulong pc)
@@ -515,6 +520,34 @@ extern spinlock_t tb_lock;
 
 extern int tb_invalidated_flag;
 
+/* the iferret info-flow logging mode is part of the TB lookup key, so
+   TBs for both modes can be cached at once and switching needs no
+   tb_flush. It lives in cflags since the i386 flags use all 64 bits.
+   With a trace filter (target-i386/iferret_filter.c) only the TBs the
+   filter picks get the logging ops. Whether the current process was
+   picked is part of the key too, so a chain set up in one process never
+   leads into code translated for another. */
+extern uint8_t iferret_info_flow;
+extern uint8_t iferret_filter_proc;
+extern int iferret_filter_num_ranges;
+int iferret_filter_pc(target_ulong pc);
+
+static inline int iferret_tb_cflags(target_ulong pc)
+{
+    if (!iferret_info_flow || !iferret_filter_proc)
+        return 0;
+    if (iferret_filter_num_ranges > 0 && !iferret_filter_pc(pc))
+        return CF_IFERRET_PROC;
+    return CF_IFERRET_PROC | CF_IFERRET_INFO_FLOW;
+}
+
+/* for helpers, which log outside of the TB's ops and so can only go by
+   the process filter */
+static inline int iferret_tracing(void)
+{
+    return iferret_info_flow && iferret_filter_proc;
+}
+
 #if !defined(CONFIG_USER_ONLY)
 
 void tlb_fill(target_ulong addr, int is_write, int mmu_idx,
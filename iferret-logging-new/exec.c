@@ -394,6 +394,7 @@ void tb_flush(CPUState *env1)
     /* XXX: flush processor icache at this point if cache flush is
        expensive */
     tb_flush_count++;
+    iferret_log_tb_flush();
 }
 
 #ifdef DEBUG_TB_CHECK
@@ -783,7 +784,7 @@ void tb_invalidate_phys_page_range(target_ulong start, target_ulong end,
            itself */
         env->current_tb = NULL;
         tb_gen_code(env, current_pc, current_cs_base, current_flags,
-                    CF_SINGLE_INSN);
+                    CF_SINGLE_INSN | iferret_tb_cflags(current_pc));
         cpu_resume_from_signal(env, NULL);
     }
 #endif
@@ -880,7 +881,7 @@ static void tb_invalidate_phys_page(target_ulong addr,
            itself */
         env->current_tb = NULL;
         tb_gen_code(env, current_pc, current_cs_base, current_flags,
-                    CF_SINGLE_INSN);
+                    CF_SINGLE_INSN | iferret_tb_cflags(current_pc));
         cpu_resume_from_signal(env, puc);
     }
 #endif
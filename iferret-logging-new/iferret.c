@@ -11,9 +11,19 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <ctype.h>
+#include <zlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/time.h>
 
 #include "iferret.h"
 #include "iferret_log.h"
+#include "iferret_arena.h"
+#include "iferret_piece.h"
+#include "iferret_post.h"
+#include "iferret_locset.h"
+#include "iferret_du.h"
+#include "iferret_info_flow.h"
 #include "target-i386/iferret_ops.h"
 
 #define TRUE 1
@@ -26,14 +36,9 @@
 uint64_t phys_ram_base;
 uint64_t iferret_target_os;
 
-unsigned long long ifregaddr[16];
-
-// ptr to first byte of info flow log
-extern char *iferret_log_base;      
-
-// ptr to next byte to be written in info flow log
-extern char *iferret_log_ptr;      
-
+// set from each chunk's preamble by decoder_regs_set, or by the offline info 
+// flow (see flow_put).  ifregaddr is in iferret_log.c
+extern uint64_t ifregaddr[];
 
 uint8_t iferret_debug = 0; 
 
@@ -47,118 +52,914 @@ typedef struct op_pos_arr_struct {
   op_pos_t *pos; 
 } op_pos_arr_t;
 
+// The op store.  
+// Ops are kept column-wise: op i is opnum[i], with flags[i] and 
+// num_args[i] args starting at arg[arg_off[i]].  Each arg takes 8 bytes 
+// whatever its type, which comes from the op's format (iferret_log_arg_fmt).  
+// String args are interned, and the arg holds the char *.  
+// Ops are only ever added to the end of the store.  Once the trace has been 
+// spliced (op_arr_splice), its order is given by a piece table over the 
+// store, and op i of the trace is op op_arr_at(op_arr,i) of the store.
+// Posting lists for finding ops in the trace (see op_arr_post) are built 
+// when the trace is loaded, and again whenever they're wanted after it 
+// has changed.
+// NB: dynslicer/iferretpy.py has a ctypes view of this.  keep them in step.
 typedef struct op_arr_struct {
-  uint64_t num;
-  uint64_t max;
-  iferret_op_t *ops;
+  uint64_t num;                 // number of ops in the store
+  uint64_t max;                 // room in the per-op columns
+  uint32_t *opnum;
+  uint8_t *flags;               // OP_IS_VALID &c
+  uint8_t *num_args;
+  uint64_t *arg_off;
+  uint64_t *arg;                // args of all ops, packed
+  uint64_t num_arg;             // number of args in arg
+  uint64_t max_arg;             // room in arg
+  iferret_str_tab_t str;        // string args
+  iferret_piece_tab_t *piece;   // trace order, or NULL if it's store order
+  struct op_post_struct *post;  // posting lists, or NULL if there aren't any
 } op_arr_t;
 
+// arg j of op i of the store
+#define OP_ARR_ARG(op_arr,i,j) ((op_arr)->arg[(op_arr)->arg_off[i] + (j)])
+
+static void op_arr_post_free(op_arr_t *op_arr);
+
 //op_arr_t op_arr;
 
+static void op_arr_resize(op_arr_t *op_arr, uint64_t max) {
+    op_arr->max = max;
+    op_arr->opnum = (uint32_t *) realloc(op_arr->opnum, max * sizeof(uint32_t));
+    op_arr->flags = (uint8_t *) realloc(op_arr->flags, max * sizeof(uint8_t));
+    op_arr->num_args = (uint8_t *) realloc(op_arr->num_args, max * sizeof(uint8_t));
+    op_arr->arg_off = (uint64_t *) realloc(op_arr->arg_off, max * sizeof(uint64_t));
+}
+
+static void op_arr_arg_resize(op_arr_t *op_arr, uint64_t max) {
+    op_arr->max_arg = max;
+    op_arr->arg = (uint64_t *) realloc(op_arr->arg, max * sizeof(uint64_t));
+}
+
 op_arr_t * op_arr_init() {
-    op_arr_t *op_arr = (op_arr_t *) malloc(sizeof(op_arr_t));
-    op_arr->num = 0;
-    op_arr->max = INITIAL_OP_ARR_SIZE;
-    op_arr->ops = (iferret_op_t *) calloc(INITIAL_OP_ARR_SIZE, sizeof (iferret_op_t));
+    op_arr_t *op_arr = (op_arr_t *) calloc(1, sizeof(op_arr_t));
+    op_arr_resize(op_arr, INITIAL_OP_ARR_SIZE);
+    op_arr_arg_resize(op_arr, 4 * INITIAL_OP_ARR_SIZE);
     return op_arr;
 }
 
 void op_arr_grow(op_arr_t *op_arr) {
-    op_arr->max *= 2;
-    //printf("Growing log to %ld entries (%ld bytes)\n", op_arr.max, op_arr.max*sizeof (iferret_op_t));
-    op_arr->ops = (iferret_op_t *) realloc(op_arr->ops, op_arr->max*sizeof (iferret_op_t));
+    //printf("Growing log to %ld entries\n", 2 * op_arr->max);
+    op_arr_resize(op_arr, 2 * op_arr->max);
 }
 
 void op_arr_fit(op_arr_t *op_arr) {
-    op_arr->ops = (iferret_op_t *) realloc(op_arr->ops, op_arr->num*sizeof (iferret_op_t));
-    op_arr->max = op_arr->num;
+    op_arr_resize(op_arr, (op_arr->num > 0) ? op_arr->num : 1);
+    op_arr_arg_resize(op_arr, (op_arr->num_arg > 0) ? op_arr->num_arg : 1);
 }
 
-void op_arr_clear(op_arr_t *op_arr, int s, int n) {
-    //printf("Zeroing out %d entries starting at %d\n", n, s);
-    memset(&op_arr->ops[s], 0, sizeof(iferret_op_t)*n);
+// append op, copying its args into the store
+void op_arr_add(op_arr_t *op_arr, iferret_op_t *op) {
+    uint64_t i, *a;
+    uint32_t j;
+
+    if (op_arr->num >= op_arr->max)
+        op_arr_grow(op_arr);
+    while (op_arr->num_arg + op->num_args > op_arr->max_arg)
+        op_arr_arg_resize(op_arr, 2 * op_arr->max_arg);
+    i = op_arr->num;
+    op_arr->opnum[i] = op->num;
+    op_arr->flags[i] = op->flags;
+    op_arr->num_args[i] = op->num_args;
+    op_arr->arg_off[i] = op_arr->num_arg;
+    a = &op_arr->arg[op_arr->num_arg];
+    for (j=0; j<op->num_args; j++) {
+        switch (op->arg[j].type) {
+            case IFLAT_UI8:  a[j] = op->arg[j].val.u8; break;
+            case IFLAT_UI16: a[j] = op->arg[j].val.u16; break;
+            case IFLAT_UI32: a[j] = op->arg[j].val.u32; break;
+            case IFLAT_UI64: a[j] = op->arg[j].val.u64; break;
+            case IFLAT_STR:
+                a[j] = (uint64_t) (uintptr_t) iferret_str_intern(&op_arr->str, op->arg[j].val.str);
+                break;
+            default:         a[j] = 0; break;
+        }
+    }
+    op_arr->num_arg += op->num_args;
+    op_arr->num ++;
+    if (op_arr->piece)
+        iferret_piece_append(op_arr->piece, i, 1);
+    op_arr_post_free(op_arr);
 }
 
-void op_arr_movedown(op_arr_t *op_arr, int s, int n) {
-    int i;
+// number of ops in the trace
+uint64_t op_arr_len(op_arr_t *op_arr) {
+    return (op_arr->piece ? iferret_piece_len(op_arr->piece) : op_arr->num);
+}
 
-    if (op_arr->num + n > op_arr->max) {
-        op_arr_grow(op_arr);
+// where op i of the trace is in the store, or ~0 if there's no op i
+uint64_t op_arr_at(op_arr_t *op_arr, uint64_t i) {
+    if (i >= op_arr_len(op_arr)) return ~((uint64_t) 0);
+    return (op_arr->piece ? iferret_piece_at(op_arr->piece, i) : i);
+}
+
+// same, for i < the length, and in *before how many ops before i 
+// are just before it in the store too
+static inline uint64_t op_arr_at_run(op_arr_t *op_arr, uint64_t i, uint64_t *before) {
+    if (op_arr->piece == NULL) {
+        *before = i;
+        return i;
     }
+    return iferret_piece_at_run(op_arr->piece, i, before);
+}
 
-    memmove(&op_arr->ops[s+n], &op_arr->ops[s], (op_arr->num - s)*sizeof(iferret_op_t));
+// replace ops s..e-1 of the trace with n new ones.  
+// they have no args and aren't valid.  
+// returns where in the store the first of them is.
+uint64_t op_arr_splice(op_arr_t *op_arr, uint64_t s, uint64_t e, uint64_t n) {
+    uint64_t first = op_arr->num;
 
+    if (op_arr->piece == NULL)
+        op_arr->piece = iferret_piece_tab_create(op_arr->num);
+    while (op_arr->num + n > op_arr->max)
+        op_arr_grow(op_arr);
+    memset(&op_arr->opnum[first], 0, sizeof(uint32_t)*n);
+    memset(&op_arr->flags[first], 0, sizeof(uint8_t)*n);
+    memset(&op_arr->num_args[first], 0, sizeof(uint8_t)*n);
+    memset(&op_arr->arg_off[first], 0, sizeof(uint64_t)*n);
     op_arr->num += n;
+    iferret_piece_splice(op_arr->piece, s, e, first, n);
+    op_arr_post_free(op_arr);
+    return first;
 }
 
-void op_arr_moveup(op_arr_t *op_arr, int s, int n) {
-    int i;
+// cleared ops have no args and aren't valid
+void op_arr_clear(op_arr_t *op_arr, int s, int n) {
+    //printf("Zeroing out %d entries starting at %d\n", n, s);
+    op_arr_splice(op_arr, s, s+n, n);
+}
 
-    memmove(&op_arr->ops[s-n], &op_arr->ops[s], (op_arr->num - s)*sizeof(iferret_op_t));
+// make room for n (cleared) ops at s
+void op_arr_movedown(op_arr_t *op_arr, int s, int n) {
+    op_arr_splice(op_arr, s, s, n);
+}
 
-    op_arr->num -= n;     
+// get rid of the n ops before s
+void op_arr_moveup(op_arr_t *op_arr, int s, int n) {
+    op_arr_splice(op_arr, s-n, s, 0);
 }
 
+static void op_arr_free_columns(op_arr_t *op_arr) {
+    free(op_arr->opnum);
+    free(op_arr->flags);
+    free(op_arr->num_args);
+    free(op_arr->arg_off);
+    free(op_arr->arg);
+}
+
+// everything goes at once.  no per-op frees.
 void op_arr_destroy(op_arr_t *op_arr) {
-    free(op_arr->ops);
+    op_arr_free_columns(op_arr);
+    iferret_str_tab_free(&op_arr->str);
+    if (op_arr->piece)
+        iferret_piece_tab_destroy(op_arr->piece);
+    op_arr_post_free(op_arr);
     free(op_arr);
 }
 
+// Posting lists over the trace.
+// Each op is filed under its opnum (ops that aren't valid, under 
+// OP_POST_INVALID), and each memory op under the page it touches, once 
+// by physical and once by virtual address, with loads and stores apart.  
+// Positions are trace positions, so any change to the trace makes them 
+// stale.  They're thrown away then, and rebuilt the next time they're 
+// wanted.
+
+#define OP_POST_INVALID IFLO_DUMMY_LAST
+
+// how to match an access
+#define OP_ACCESS_LD    1
+#define OP_ACCESS_ST    2
+#define OP_ACCESS_VIRT  4       // addr is virtual, not physical
+
+typedef struct op_post_struct {
+  iferret_post_t op[OP_POST_INVALID + 1];
+  iferret_post_tab_t page[2];   // physical, virtual
+} op_post_t;
+
+// page key.  loads and stores go in different lists
+#define OP_POST_PAGE(addr,st) ((((uint64_t) (addr) >> 12) << 1) | (st))
+
+// if opnum is a memory op, which of its args are its physical and 
+// virtual addresses (-1 for none), and whether it's a store.  
+// returns 0 if it isn't one.
+static int op_mem(uint32_t opnum, int *phys, int *virt, int *st) {
+    switch (opnum) {
+        case IFLO_OPS_MEM_LDUB_T0_A0: case IFLO_OPS_MEM_LDSB_T0_A0:
+        case IFLO_OPS_MEM_LDUW_T0_A0: case IFLO_OPS_MEM_LDSW_T0_A0:
+        case IFLO_OPS_MEM_LDL_T0_A0:
+        case IFLO_OPS_MEM_LDUB_T1_A0: case IFLO_OPS_MEM_LDSB_T1_A0:
+        case IFLO_OPS_MEM_LDUW_T1_A0: case IFLO_OPS_MEM_LDSW_T1_A0:
+        case IFLO_OPS_MEM_LDL_T1_A0:
+            *phys = 1; *virt = 2; *st = 0;
+            return 1;
+        case IFLO_OPS_MEM_STB_T0_A0: case IFLO_OPS_MEM_STW_T0_A0:
+        case IFLO_OPS_MEM_STL_T0_A0:
+        case IFLO_OPS_MEM_STW_T1_A0: case IFLO_OPS_MEM_STL_T1_A0:
+            *phys = 1; *virt = 2; *st = 1;
+            return 1;
+        // arg 1 of these is where in env it goes.  
+        // they have no virtual address, so OP_ACCESS_VIRT never matches them.
+        case IFLO_OPS_MEM_LDQ_ENV_A0: case IFLO_OPS_MEM_LDO_ENV_A0:
+            *phys = 2; *virt = -1; *st = 0;
+            return 1;
+        case IFLO_OPS_MEM_STQ_ENV_A0: case IFLO_OPS_MEM_STO_ENV_A0:
+            *phys = 2; *virt = -1; *st = 1;
+            return 1;
+    }
+    return 0;
+}
+
+static void op_arr_post_free(op_arr_t *op_arr) {
+    op_post_t *post = op_arr->post;
+    int j;
+
+    if (post == NULL) return;
+    for (j=0; j<=OP_POST_INVALID; j++)
+        iferret_post_free(&post->op[j]);
+    iferret_post_tab_free(&post->page[0]);
+    iferret_post_tab_free(&post->page[1]);
+    free(post);
+    op_arr->post = NULL;
+}
+
+// op_arr's posting lists, built if need be
+static op_post_t *op_arr_post(op_arr_t *op_arr) {
+    op_post_t *post;
+    uint64_t i, k, n;
+    uint32_t opnum;
+    int phys, virt, st;
+
+    if (op_arr->post) return op_arr->post;
+    post = (op_post_t *) calloc(1, sizeof(op_post_t));
+    assert (post != NULL);
+    n = op_arr_len(op_arr);
+    for (i=0; i<n; i++) {
+        k = op_arr_at(op_arr, i);
+        opnum = op_arr->opnum[k];
+        if (!(op_arr->flags[k] & OP_IS_VALID) || opnum >= OP_POST_INVALID) {
+            iferret_post_add(&post->op[OP_POST_INVALID], i);
+            continue;
+        }
+        iferret_post_add(&post->op[opnum], i);
+        if (op_mem(opnum, &phys, &virt, &st)) {
+            iferret_post_add(iferret_post_tab_get(&post->page[0], 
+                OP_POST_PAGE((uint32_t) OP_ARR_ARG(op_arr,k,phys), st)), i);
+            if (virt >= 0)
+                iferret_post_add(iferret_post_tab_get(&post->page[1], 
+                    OP_POST_PAGE((uint32_t) OP_ARR_ARG(op_arr,k,virt), st)), i);
+        }
+    }
+    op_arr->post = post;
+    return post;
+}
+
+// first op at or after i that's an opnum (or OP_POST_INVALID), 
+// or ~0 if there isn't one
+uint64_t op_arr_next_op(op_arr_t *op_arr, uint64_t i, uint32_t opnum) {
+    if (opnum > OP_POST_INVALID) return IFERRET_POST_NONE;
+    return iferret_post_next(&op_arr_post(op_arr)->op[opnum], i);
+}
+
+// last op at or before i that's an opnum, or ~0 if there isn't one
+uint64_t op_arr_prev_op(op_arr_t *op_arr, uint64_t i, uint32_t opnum) {
+    if (opnum > OP_POST_INVALID) return IFERRET_POST_NONE;
+    return iferret_post_prev(&op_arr_post(op_arr)->op[opnum], i);
+}
+
+// does trace op x get at addr?
+static inline int op_arr_is_access(op_arr_t *op_arr, uint64_t x, uint32_t addr, int how) {
+    uint64_t k = op_arr_at(op_arr, x);
+    int phys, virt, st;
+
+    if (!op_mem(op_arr->opnum[k], &phys, &virt, &st)) return 0;
+    if (how & OP_ACCESS_VIRT) phys = virt;
+    return (phys >= 0 && (uint32_t) OP_ARR_ARG(op_arr,k,phys) == addr);
+}
+
+// first access to addr at or after i, or ~0 if there isn't one.
+// how is OP_ACCESS_LD and/or OP_ACCESS_ST, maybe with OP_ACCESS_VIRT.
+uint64_t op_arr_next_access(op_arr_t *op_arr, uint64_t i, uint32_t addr, int how) {
+    iferret_post_tab_t *tab = &op_arr_post(op_arr)->page[(how & OP_ACCESS_VIRT) ? 1 : 0];
+    iferret_post_t *p;
+    uint64_t x, best = IFERRET_POST_NONE;
+    int st;
+
+    for (st=0; st<2; st++) {
+        if (!(how & (st ? OP_ACCESS_ST : OP_ACCESS_LD))) continue;
+        p = iferret_post_tab_find(tab, OP_POST_PAGE(addr, st));
+        if (p == NULL) continue;
+        for (x = iferret_post_next(p, i); x < best; x = iferret_post_next(p, x + 1)) {
+            if (op_arr_is_access(op_arr, x, addr, how)) {
+                best = x;
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+// last access to addr at or before i, or ~0 if there isn't one
+uint64_t op_arr_prev_access(op_arr_t *op_arr, uint64_t i, uint32_t addr, int how) {
+    iferret_post_tab_t *tab = &op_arr_post(op_arr)->page[(how & OP_ACCESS_VIRT) ? 1 : 0];
+    iferret_post_t *p;
+    uint64_t x, best = IFERRET_POST_NONE;
+    int st;
+
+    for (st=0; st<2; st++) {
+        if (!(how & (st ? OP_ACCESS_ST : OP_ACCESS_LD))) continue;
+        p = iferret_post_tab_find(tab, OP_POST_PAGE(addr, st));
+        if (p == NULL) continue;
+        for (x = iferret_post_prev(p, i); 
+             x != IFERRET_POST_NONE && (best == IFERRET_POST_NONE || x > best);
+             x = (x > 0) ? iferret_post_prev(p, x - 1) : IFERRET_POST_NONE) {
+            if (op_arr_is_access(op_arr, x, addr, how)) {
+                best = x;
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+// these go in trace order
+
+// the first interrupt at or after s, from where it's raised (*start) to 
+// the head of the block it returns to (*end).  interrupts the trace 
+// sends itself through the APIC since s don't count.
 int op_arr_find_interrupt(op_arr_t *op_arr, int s, int *start, int *end) {
-    int i;
+    uint64_t i, j, k, w;
     int balance;
-    unsigned char self_vec = 0;
+    unsigned char self_vec;
     uint32_t addr;
-    for (i=s; i < op_arr->num; i++) {
-        if (op_arr->ops[i].num == IFLO_INTERRUPT && op_arr->ops[i].arg[0].val.u32 != self_vec) {
-            balance = 1;
-            addr = op_arr->ops[i].arg[1].val.u32;
-            *start = i;
-            while(i < op_arr->num) {
-                i++;
-                if (op_arr->ops[i].num == IFLO_INTERRUPT) balance++;
-                else if (op_arr->ops[i].num == IFLO_IRET_PROTECTED) balance--;
-                if (balance == 0) break;
+
+    for (i = op_arr_next_op(op_arr, s, IFLO_INTERRUPT); i != IFERRET_POST_NONE; 
+         i = op_arr_next_op(op_arr, i+1, IFLO_INTERRUPT)) {
+        // the vector of the last self-interrupt before this one
+        self_vec = 0;
+        for (w = (i > 0) ? op_arr_prev_access(op_arr, i-1, 0xfee00300, OP_ACCESS_ST) : IFERRET_POST_NONE;
+             w != IFERRET_POST_NONE && w >= s;
+             w = (w > 0) ? op_arr_prev_access(op_arr, w-1, 0xfee00300, OP_ACCESS_ST) : IFERRET_POST_NONE) {
+            k = op_arr_at(op_arr, w);
+            if (op_arr->opnum[k] == IFLO_OPS_MEM_STL_T0_A0) {
+                self_vec = OP_ARR_ARG(op_arr,k,6) & 0xff;
+                break;
             }
-            while (i < op_arr->num) {
-                i++;
-                if (op_arr->ops[i].num == IFLO_TB_HEAD_EIP &&
-                    op_arr->ops[i].arg[0].val.u32 == addr) {
-                    *end = i;
-                    return 1;   // Success
-                }
+        }
+        k = op_arr_at(op_arr, i);
+        if ((uint32_t) OP_ARR_ARG(op_arr,k,0) == self_vec) continue;
+
+        balance = 1;
+        addr = OP_ARR_ARG(op_arr,k,1);
+        *start = i;
+        while (balance > 0) {
+            j = op_arr_next_op(op_arr, i+1, IFLO_INTERRUPT);
+            i = op_arr_next_op(op_arr, i+1, IFLO_IRET_PROTECTED);
+            if (j == IFERRET_POST_NONE && i == IFERRET_POST_NONE) 
+                return -1;  // Unbalanced interrupts
+            if (j < i) {
+                i = j;
+                balance++;
             }
-            return -1;  // Unbalanced interrupts
+            else balance--;
         }
-        else if (op_arr->ops[i].num == IFLO_OPS_MEM_STL_T0_A0 && op_arr->ops[i].arg[1].val.u32 == 0xfee00300) {
-            self_vec = op_arr->ops[i].arg[6].val.u32 & 0xff;
+        for (i = op_arr_next_op(op_arr, i+1, IFLO_TB_HEAD_EIP); i != IFERRET_POST_NONE; 
+             i = op_arr_next_op(op_arr, i+1, IFLO_TB_HEAD_EIP)) {
+            k = op_arr_at(op_arr, i);
+            if ((uint32_t) OP_ARR_ARG(op_arr,k,0) == addr) {
+                *end = i;
+                return 1;   // Success
+            }
         }
+        return -1;  // Unbalanced interrupts
     }
     return 0; // No more interrupts
 }
 
+// the first 32-bit load from physical address addr at or after s, 
+// or -1.  *t is which of T0 and T1 it loads.
 int op_arr_find_input(op_arr_t *op_arr, int s, uint32_t addr, int *t) {
-    int i;
-    for (i=s; i < op_arr->num; i++) {
-        switch (op_arr->ops[i].num) {
+    uint64_t i, k;
+
+    for (i = op_arr_next_access(op_arr, s, addr, OP_ACCESS_LD); i != IFERRET_POST_NONE; 
+         i = op_arr_next_access(op_arr, i+1, addr, OP_ACCESS_LD)) {
+        k = op_arr_at(op_arr, i);
+        switch (op_arr->opnum[k]) {
             case IFLO_OPS_MEM_LDL_T0_A0:
-                if (op_arr->ops[i].arg[1].val.u32 == addr) {
-                    *t = 0;
-                    return i;
-                }
-                break;
+                *t = 0;
+                return i;
             case IFLO_OPS_MEM_LDL_T1_A0:
-                if (op_arr->ops[i].arg[1].val.u32 == addr) {
-                    *t = 1;
-                    return i;
-                }
-                break;
+                *t = 1;
+                return i;
         }
     }
     return -1;
 }
 
-op_pos_arr_t *op_pos_arr = NULL;
+// Slicing.
+// A backwards dynamic data slice of the trace, as multislice in 
+// dynslicer/newslice.py does it, but over the store: an op that defines 
+// anything in the working set is in the slice, and what it defines is 
+// swapped in the working set for what it uses.  
+// What an op defines and uses comes from the table in iferret_du.h.  
+// Ops that aren't valid stand in for ops on the python side, which 
+// python describes one at a time, as it does ops the table doesn't know.
+
+typedef struct slice_range_struct {
+  uint64_t lo, hi;              // locations lo..hi-1
+} slice_range_t;
+
+// locations to add to the working set when we get to pos
+typedef struct slice_work_struct {
+  uint64_t pos;
+  slice_range_t r;
+} slice_work_t;
+
+// an op on the python side, by the op standing in for it in the store.
+// it defines range[off..off+num_def-1] and uses the num_use after those
+typedef struct slice_extra_struct {
+  uint64_t k;
+  uint64_t off;
+  uint32_t num_def, num_use;
+  uint32_t known;               // 0 if python doesn't know what it does
+} slice_extra_t;
+
+typedef struct iferret_slice_struct {
+  op_arr_t *op_arr;
+  iferret_locset_t work;
+  iferret_locset_t out;         // output not accounted for yet
+  slice_work_t *w;
+  uint64_t num_w, max_w;
+  slice_extra_t *extra;
+  uint64_t num_extra, max_extra;
+  slice_range_t *range;         // the extras' defs and uses
+  uint64_t num_range, max_range;
+  uint64_t bad;                 // the op we didn't know what to do with, or ~0
+  int record;                   // keep track of what gets marked?
+  uint64_t *marked;             // if so, where, since it was last looked at
+  uint64_t num_marked, max_marked;
+} iferret_slice_t;
+
+// so there's room for need in *p
+static void *slice_grow(void *p, uint64_t *max, uint64_t need, size_t size) {
+  if (need <= *max) return p;
+  while (*max < need)
+    *max = (*max == 0) ? 64 : 2 * *max;
+  p = realloc(p, *max * size);
+  assert (p != NULL);
+  return p;
+}
+
+iferret_slice_t *iferret_slice_new(op_arr_t *op_arr) {
+  iferret_slice_t *s;
+
+  s = (iferret_slice_t *) calloc(1, sizeof(iferret_slice_t));
+  assert (s != NULL);
+  s->op_arr = op_arr;
+  s->bad = ~((uint64_t) 0);
+  return s;
+}
+
+void iferret_slice_free(iferret_slice_t *s) {
+  iferret_locset_free(&s->work);
+  iferret_locset_free(&s->out);
+  free(s->w);
+  free(s->extra);
+  free(s->range);
+  free(s->marked);
+  free(s);
+}
+
+// add locations lo..hi-1 to the working set at trace position pos
+void iferret_slice_add(iferret_slice_t *s, uint64_t pos, uint64_t lo, uint64_t hi) {
+  s->w = (slice_work_t *) slice_grow(s->w, &s->max_w, s->num_w + 1, sizeof(slice_work_t));
+  s->w[s->num_w].pos = pos;
+  s->w[s->num_w].r.lo = lo;
+  s->w[s->num_w].r.hi = hi;
+  s->num_w ++;
+}
+
+// store op k (a stand-in for a python-side op, or an op we have no 
+// descriptors for) defines the first num_def of the ranges in r 
+// (lo, hi pairs) and uses the num_use after.  
+// num_def < 0 means python doesn't know what it does either.
+void iferret_slice_extra(iferret_slice_t *s, uint64_t k, uint64_t *r, int32_t num_def, uint32_t num_use) {
+  slice_extra_t *e;
+  uint32_t j, n;
+
+  s->extra = (slice_extra_t *) slice_grow(s->extra, &s->max_extra, s->num_extra + 1, sizeof(slice_extra_t));
+  e = &s->extra[s->num_extra++];
+  e->k = k;
+  e->off = s->num_range;
+  e->known = (num_def >= 0);
+  e->num_def = e->known ? num_def : 0;
+  e->num_use = e->known ? num_use : 0;
+  n = e->num_def + e->num_use;
+  s->range = (slice_range_t *) slice_grow(s->range, &s->max_range, s->num_range + n, sizeof(slice_range_t));
+  for (j=0; j<n; j++) {
+    s->range[s->num_range].lo = r[2*j];
+    s->range[s->num_range].hi = r[2*j+1];
+    s->num_range ++;
+  }
+}
+
+uint64_t iferret_slice_bad(iferret_slice_t *s) {
+  return s->bad;
+}
+
+static int slice_extra_cmp(const void *a, const void *b) {
+  uint64_t x = ((slice_extra_t *) a)->k, y = ((slice_extra_t *) b)->k;
+  return (x > y) - (x < y);
+}
+
+// last first
+static int slice_work_cmp(const void *a, const void *b) {
+  uint64_t x = ((slice_work_t *) a)->pos, y = ((slice_work_t *) b)->pos;
+  return (x < y) - (x > y);
+}
+
+// op k's defs and uses, in buf or the extras.  NULL if we don't know them
+static slice_range_t *slice_op_ranges(iferret_slice_t *s, uint64_t k, slice_range_t *buf, 
+                                      uint32_t *num_def, uint32_t *num_use) {
+  op_arr_t *op_arr = s->op_arr;
+  iferret_op_du_t *d = NULL;
+  iferret_du_t *du;
+  slice_extra_t *e;
+  uint64_t lo, hi, m, *args;
+  uint32_t j, n, num_args;
+
+  if ((op_arr->flags[k] & OP_IS_VALID) && op_arr->opnum[k] < OP_POST_INVALID)
+    d = &iferret_op_du[op_arr->opnum[k]];
+  if (d != NULL && d->known) {
+    du = &iferret_du[d->off];
+    args = &OP_ARR_ARG(op_arr,k,0);
+    num_args = op_arr->num_args[k];
+    for (n = 0, j = 0; j < d->num_def; j++)
+      n += iferret_du_range(&du[j], args, num_args, &buf[n].lo, &buf[n].hi);
+    *num_def = n;
+    for (; j < d->num_def + d->num_use; j++)
+      n += iferret_du_range(&du[j], args, num_args, &buf[n].lo, &buf[n].hi);
+    *num_use = n - *num_def;
+    return buf;
+  }
+  // python has to tell us
+  for (lo = 0, hi = s->num_extra; lo < hi; ) {
+    m = (lo + hi) / 2;
+    if (s->extra[m].k < k) lo = m + 1;
+    else hi = m;
+  }
+  *num_def = *num_use = 0;
+  if (lo == s->num_extra || s->extra[lo].k != k) {
+    // a stand-in for nothing does nothing
+    return (d == NULL) ? buf : NULL;
+  }
+  e = &s->extra[lo];
+  if (!e->known) return NULL;
+  *num_def = e->num_def;
+  *num_use = e->num_use;
+  return &s->range[e->off];
+}
+
+// slice back from the last place anything was added.  
+// ops in the slice get OP_IN_SLICE, and if output_track, those that 
+// define some of what was added there get OP_IS_OUTPUT too.
+// returns -1 if we get to an op we don't know what to do with (which 
+// iferret_slice_bad says where it is), else 0.  either way, the working 
+// set and what was added are gone after.
+int iferret_slice_run(iferret_slice_t *s, int output_track) {
+  op_arr_t *op_arr = s->op_arr;
+  slice_range_t buf[IFERRET_DU_MAX], *r;
+  uint64_t i, j, k = 0, before = 0, start, n;
+  uint32_t num_def, num_use, d;
+  int hit, ret = 0;
+
+  n = op_arr_len(op_arr);
+  qsort(s->extra, s->num_extra, sizeof(slice_extra_t), slice_extra_cmp);
+  qsort(s->w, s->num_w, sizeof(slice_work_t), slice_work_cmp);
+  start = (s->num_w > 0) ? s->w[0].pos : 0;
+  if (start >= n) start = n - 1;
+  if (output_track) {
+    for (j = 0; j < s->num_w && s->w[j].pos == s->w[0].pos; j++)
+      iferret_locset_add(&s->out, s->w[j].r.lo, s->w[j].r.hi);
+  }
+  j = 0;
+  for (i = start + 1; s->num_w > 0 && i-- > 0; ) {
+    if (i == start || before == 0) {
+      k = op_arr_at_run(op_arr, i, &before);
+    }
+    else {
+      k--;
+      before--;
+    }
+    for (; j < s->num_w && s->w[j].pos >= i; j++)
+      iferret_locset_add(&s->work, s->w[j].r.lo, s->w[j].r.hi);
+    // nothing left to find
+    if (iferret_locset_empty(&s->work) && j == s->num_w) break;
+
+    r = slice_op_ranges(s, k, buf, &num_def, &num_use);
+    if (r == NULL) {
+      s->bad = i;
+      ret = -1;
+      break;
+    }
+    for (hit = 0, d = 0; d < num_def && !hit; d++)
+      hit = iferret_locset_any(&s->work, r[d].lo, r[d].hi);
+    if (!hit) continue;
+    for (d = 0; d < num_def; d++)
+      iferret_locset_del(&s->work, r[d].lo, r[d].hi);
+    for (d = num_def; d < num_def + num_use; d++)
+      iferret_locset_add(&s->work, r[d].lo, r[d].hi);
+    if (s->record && !(op_arr->flags[k] & OP_IN_SLICE)) {
+      s->marked = (uint64_t *) slice_grow(s->marked, &s->max_marked, s->num_marked + 1, sizeof(uint64_t));
+      s->marked[s->num_marked++] = i;
+    }
+    op_arr->flags[k] |= OP_IN_SLICE;
+    if (output_track) {
+      for (hit = 0, d = 0; d < num_def && !hit; d++)
+        hit = iferret_locset_any(&s->out, r[d].lo, r[d].hi);
+      if (hit) {
+        for (d = 0; d < num_def; d++)
+          iferret_locset_del(&s->out, r[d].lo, r[d].hi);
+        op_arr->flags[k] |= OP_IS_OUTPUT;
+      }
+    }
+  }
+  iferret_locset_free(&s->work);
+  iferret_locset_free(&s->out);
+  s->num_w = 0;
+  return ret;
+}
+
+// Slice closure.
+// slice_closure in dynslicer/newslice.py: instances of the same TB should 
+// agree on which of their ops are in the slice, so if any instance has 
+// its nth op in, every instance's nth op goes in, and what it uses gets 
+// sliced for in its trace.  Until nothing changes.  
+// Python tells us the instances (trace, start, end) and which group (TB) 
+// each is in.  An offset into a group that has been taken care of is 
+// marked done, so after a first look at every instance, all we ever look 
+// at is what the last round of slicing marked.
+
+typedef struct closure_inst_struct {
+  iferret_slice_t *s;           // its trace's slicer
+  uint32_t group;
+  uint64_t start, end;
+} closure_inst_t;
+
+typedef struct iferret_closure_struct {
+  closure_inst_t *inst;
+  uint64_t num_inst, max_inst;
+  uint32_t num_groups;
+  uint64_t *by_pos;             // instances by slicer, then start
+  uint64_t *by_group;           // instances by group
+  uint64_t *group_off;          // group g's are by_group[group_off[g]..group_off[g+1]-1]
+  uint64_t *group_len;          // how long its shortest instance is
+  uint64_t *done_off;           // where its offsets start in done
+  uint64_t *done;               // bit per offset into each group
+  iferret_slice_t **slice;      // every slicer, once
+  uint64_t num_slices;
+  uint64_t num_new;             // ops we put in the slice
+} iferret_closure_t;
+
+iferret_closure_t *iferret_closure_new(void) {
+  iferret_closure_t *c;
+
+  c = (iferret_closure_t *) calloc(1, sizeof(iferret_closure_t));
+  assert (c != NULL);
+  return c;
+}
+
+void iferret_closure_free(iferret_closure_t *c) {
+  uint64_t j;
+
+  for (j=0; j<c->num_slices; j++) {
+    c->slice[j]->record = 0;
+    c->slice[j]->num_marked = 0;
+  }
+  free(c->inst);
+  free(c->by_pos);
+  free(c->by_group);
+  free(c->group_off);
+  free(c->group_len);
+  free(c->done_off);
+  free(c->done);
+  free(c->slice);
+  free(c);
+}
+
+// ops start..end-1 of the trace s slices are an instance of group
+void iferret_closure_add(iferret_closure_t *c, iferret_slice_t *s, uint32_t group, 
+                         uint64_t start, uint64_t end) {
+  closure_inst_t *t;
+
+  c->inst = (closure_inst_t *) slice_grow(c->inst, &c->max_inst, c->num_inst + 1, sizeof(closure_inst_t));
+  t = &c->inst[c->num_inst++];
+  t->s = s;
+  t->group = group;
+  t->start = start;
+  t->end = end;
+  if (group >= c->num_groups) 
+    c->num_groups = group + 1;
+}
+
+// for qsort_r-less sorting of by_pos
+static closure_inst_t *closure_sort_inst;
+
+static int closure_pos_cmp(const void *a, const void *b) {
+  closure_inst_t *x = &closure_sort_inst[*(uint64_t *) a];
+  closure_inst_t *y = &closure_sort_inst[*(uint64_t *) b];
+  uintptr_t xs = (uintptr_t) x->s, ys = (uintptr_t) y->s;
+
+  if (xs != ys) return (xs > ys) - (xs < ys);
+  return (x->start > y->start) - (x->start < y->start);
+}
+
+static void closure_setup(iferret_closure_t *c) {
+  uint64_t j, g, n;
+
+  c->by_pos = (uint64_t *) malloc((c->num_inst + 1) * sizeof(uint64_t));
+  c->by_group = (uint64_t *) malloc((c->num_inst + 1) * sizeof(uint64_t));
+  c->group_off = (uint64_t *) calloc(c->num_groups + 1, sizeof(uint64_t));
+  c->group_len = (uint64_t *) malloc((c->num_groups + 1) * sizeof(uint64_t));
+  c->done_off = (uint64_t *) malloc((c->num_groups + 1) * sizeof(uint64_t));
+  c->slice = (iferret_slice_t **) malloc((c->num_inst + 1) * sizeof(iferret_slice_t *));
+  assert (c->by_pos && c->by_group && c->group_off && c->group_len && c->done_off && c->slice);
+  for (g=0; g<c->num_groups; g++) 
+    c->group_len[g] = ~((uint64_t) 0);
+  for (j=0; j<c->num_inst; j++) {
+    c->by_pos[j] = j;
+    c->group_off[c->inst[j].group + 1] ++;
+    g = c->inst[j].group;
+    n = c->inst[j].end - c->inst[j].start;
+    if (n < c->group_len[g]) c->group_len[g] = n;
+  }
+  for (g=0; g<c->num_groups; g++) {
+    c->group_off[g+1] += c->group_off[g];
+    if (c->group_off[g+1] == c->group_off[g]) c->group_len[g] = 0;
+  }
+  // counting sort by group
+  memcpy(c->done_off, c->group_off, c->num_groups * sizeof(uint64_t));
+  for (j=0; j<c->num_inst; j++) 
+    c->by_group[c->done_off[c->inst[j].group]++] = j;
+  for (n=0, g=0; g<c->num_groups; g++) {
+    c->done_off[g] = n;
+    n += c->group_len[g];
+  }
+  c->done = (uint64_t *) calloc(n / 64 + 1, sizeof(uint64_t));
+  assert (c->done != NULL);
+  closure_sort_inst = c->inst;
+  qsort(c->by_pos, c->num_inst, sizeof(uint64_t), closure_pos_cmp);
+  for (j=0; j<c->num_inst; j++) {
+    iferret_slice_t *s = c->inst[c->by_pos[j]].s;
+    if (c->num_slices == 0 || c->slice[c->num_slices-1] != s) {
+      c->slice[c->num_slices++] = s;
+      s->record = 1;
+      s->num_marked = 0;
+      // slice_op_ranges looks for them before any slicing
+      qsort(s->extra, s->num_extra, sizeof(slice_extra_t), slice_extra_cmp);
+    }
+  }
+}
+
+// the instance with trace position i in s in it, or ~0
+static uint64_t closure_find(iferret_closure_t *c, iferret_slice_t *s, uint64_t i) {
+  uint64_t lo = 0, hi = c->num_inst, m;
+  closure_inst_t *t;
+
+  // first one after (s, i)
+  while (lo < hi) {
+    m = (lo + hi) / 2;
+    t = &c->inst[c->by_pos[m]];
+    if ((uintptr_t) t->s < (uintptr_t) s || (t->s == s && t->start <= i)) lo = m + 1;
+    else hi = m;
+  }
+  if (lo == 0) return ~((uint64_t) 0);
+  t = &c->inst[c->by_pos[lo-1]];
+  if (t->s != s || i >= t->end) return ~((uint64_t) 0);
+  return c->by_pos[lo-1];
+}
+
+// put op p of every instance of group g in the slice, and slice for 
+// what the ones that weren't use.  -1 if we don't know what one uses.
+static int closure_spread(iferret_closure_t *c, uint64_t g, uint64_t p) {
+  slice_range_t buf[IFERRET_DU_MAX], *r;
+  uint32_t num_def, num_use, d;
+  closure_inst_t *t;
+  uint64_t j, i, k, bit;
+
+  bit = c->done_off[g] + p;
+  c->done[bit / 64] |= ((uint64_t) 1) << (bit % 64);
+  for (j = c->group_off[g]; j < c->group_off[g+1]; j++) {
+    t = &c->inst[c->by_group[j]];
+    i = t->start + p;
+    k = op_arr_at(t->s->op_arr, i);
+    if (t->s->op_arr->flags[k] & OP_IN_SLICE) continue;
+    r = slice_op_ranges(t->s, k, buf, &num_def, &num_use);
+    if (r == NULL) {
+      t->s->bad = i;
+      return -1;
+    }
+    for (d = num_def; d < num_def + num_use; d++)
+      iferret_slice_add(t->s, i, r[d].lo, r[d].hi);
+    t->s->op_arr->flags[k] |= OP_IN_SLICE;
+    c->num_new ++;
+  }
+  return 0;
+}
+
+static inline int closure_is_done(iferret_closure_t *c, uint64_t g, uint64_t p) {
+  uint64_t bit = c->done_off[g] + p;
+  return (c->done[bit / 64] >> (bit % 64)) & 1;
+}
+
+// the first look, at every instance.  
+// offsets that some instances have in the slice and some don't get spread.
+static int closure_first(iferret_closure_t *c) {
+  uint32_t *count;
+  uint64_t g, j, p, n, k = 0, before = 0, max_len = 0;
+  closure_inst_t *t;
+  int ret = 0;
+
+  for (g=0; g<c->num_groups; g++)
+    if (c->group_len[g] > max_len) max_len = c->group_len[g];
+  count = (uint32_t *) malloc((max_len + 1) * sizeof(uint32_t));
+  assert (count != NULL);
+  for (g=0; g<c->num_groups && ret == 0; g++) {
+    n = c->group_off[g+1] - c->group_off[g];
+    memset(count, 0, c->group_len[g] * sizeof(uint32_t));
+    for (j = c->group_off[g]; j < c->group_off[g+1]; j++) {
+      t = &c->inst[c->by_group[j]];
+      // runs go backwards from where op_arr_at_run lands, so walk back
+      for (p = c->group_len[g]; p-- > 0; ) {
+        if (p == c->group_len[g] - 1 || before == 0) {
+          k = op_arr_at_run(t->s->op_arr, t->start + p, &before);
+        }
+        else {
+          k--;
+          before--;
+        }
+        if (t->s->op_arr->flags[k] & OP_IN_SLICE) count[p] ++;
+      }
+    }
+    for (p = 0; p < c->group_len[g] && ret == 0; p++) {
+      if (count[p] == 0) continue;
+      if (count[p] < n) ret = closure_spread(c, g, p);
+      else {
+        j = c->done_off[g] + p;
+        c->done[j / 64] |= ((uint64_t) 1) << (j % 64);
+      }
+    }
+  }
+  free(count);
+  return ret;
+}
+
+// slice to a fixed point.  *rounds is how many rounds of slicing that 
+// took, and *num_new how many ops we put in the slice to make instances 
+// agree.  -1 if we hit an op we don't know what to do with (which 
+// iferret_slice_bad says, for its trace's slicer), else 0.
+int iferret_closure_run(iferret_closure_t *c, uint64_t *rounds, uint64_t *num_new) {
+  iferret_slice_t *s;
+  uint64_t j, m, x, p, g;
+  int any, ret;
+
+  *rounds = 0;
+  c->num_new = 0;
+  closure_setup(c);
+  ret = closure_first(c);
+  while (ret == 0) {
+    for (any = 0, j = 0; j < c->num_slices && ret == 0; j++) {
+      s = c->slice[j];
+      if (s->num_w == 0) continue;
+      any = 1;
+      ret = iferret_slice_run(s, 0);
+    }
+    if (!any || ret != 0) break;
+    (*rounds) ++;
+    for (j = 0; j < c->num_slices && ret == 0; j++) {
+      s = c->slice[j];
+      for (m = 0; m < s->num_marked && ret == 0; m++) {
+        x = closure_find(c, s, s->marked[m]);
+        if (x == ~((uint64_t) 0)) continue;
+        g = c->inst[x].group;
+        p = s->marked[m] - c->inst[x].start;
+        if (p < c->group_len[g] && !closure_is_done(c, g, p))
+          ret = closure_spread(c, g, p);
+      }
+      s->num_marked = 0;
+    }
+  }
+  *num_new = c->num_new;
+  return ret;
+}
 
 void op_hex_dump_aux(uint32_t opnum, unsigned char *p1, unsigned char *p2, char *label) {
   unsigned char *p;
@@ -193,7 +994,7 @@ void op_hex_dump_aux(uint32_t opnum, unsigned char *p1, unsigned char *p2, char
 }
 
 
-void op_hex_dump(int i) {
+void op_hex_dump(op_pos_arr_t *op_pos_arr, int i) {
   char *p1, *p2; // *p;
   //  int j;
   uint32_t opnum;
@@ -223,109 +1024,841 @@ iferret_t *iferret_create() {
   iferret->start_log_num = 0;
   iferret->num_logs = 0;
   iferret->first_log = TRUE;
+  iferret->info_flow = FALSE;
+  iferret->shadow = iferret_shadow_new();
+  iferret->taint_events = iferret_taint_event_new();
+  iferret->last_hd_transfer_from = 0;
   return (iferret);
 }
 
+// tb schemas, as learned from IFLO_TB_SCHEMA records in the current log 
+// (format 1) or block (format 2).
+// an IFLO_TB_INSTANCE record expands to the first count ops of its schema.
+typedef struct tb_schema_struct_t {
+  uint8_t learned;              // TRUE once its IFLO_TB_SCHEMA record has been seen
+  uint32_t num_ops;
+  iferret_op_t *ops;
+} tb_schema_t;
+
+// each chunk or block learns its schemas afresh, into one of these
+typedef struct tb_schema_tab_struct_t {
+  tb_schema_t *s;
+  uint32_t max;
+} tb_schema_tab_t;
+
+static void tb_schema_free(tb_schema_t *s) {
+  uint32_t i, j;
+  for (i=0; i<s->num_ops; i++) {
+    for (j=0; j<s->ops[i].num_args; j++) 
+      if (s->ops[i].arg[j].type == IFLAT_STR) 
+        free(s->ops[i].arg[j].val.str);
+    free(s->ops[i].arg);
+  }
+  free(s->ops);
+  s->ops = NULL;
+  s->num_ops = 0;
+  s->learned = FALSE;
+}
+
+// forget every schema t has learned
+static void tb_schema_tab_clear(tb_schema_tab_t *t) {
+  uint32_t i;
+  for (i=0; i<t->max; i++) 
+    tb_schema_free(&t->s[i]);
+}
+
+static void tb_schema_tab_free(tb_schema_tab_t *t) {
+  tb_schema_tab_clear(t);
+  free(t->s);
+  t->s = NULL;
+  t->max = 0;
+}
+
+static tb_schema_t *tb_schema_get(tb_schema_tab_t *t, uint32_t id) {
+  if (id >= t->max) {
+    uint32_t n = (t->max == 0) ? 1024 : t->max;
+    while (n <= id) n *= 2;
+    t->s = (tb_schema_t *) realloc(t->s, n * sizeof(tb_schema_t));
+    memset(&t->s[t->max], 0, (n - t->max) * sizeof(tb_schema_t));
+    t->max = n;
+  }
+  return &t->s[id];
+}
+
+// deep copy op onto the end of schema s
+static void tb_schema_add(tb_schema_t *s, iferret_op_t *op) {
+  iferret_op_t *sop;
+  uint32_t j;
+  sop = &s->ops[s->num_ops++];
+  *sop = *op;
+  sop->syscall = NULL;
+  sop->arg = NULL;
+  if (op->num_args > 0) {
+    sop->arg = (iferret_op_arg_t *) malloc(op->num_args * sizeof(iferret_op_arg_t));
+    memcpy(sop->arg, op->arg, op->num_args * sizeof(iferret_op_arg_t));
+    for (j=0; j<op->num_args; j++) 
+      if (sop->arg[j].type == IFLAT_STR) 
+        sop->arg[j].val.str = strdup(op->arg[j].val.str);
+  }
+}
+
+// disassembly strings, by id, from IFLO_INSN_DIS_STR records.
+// IFLO_INSN_DIS ops just carry the id.
+// shared by all chunks, so only touch it with iferret_load_lock held.
+char **insn_dis_str = NULL;
+uint32_t insn_dis_max = 0;
+
+// chunks are loaded in parallel.  this guards what they share.
+static pthread_mutex_t iferret_load_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// takes ownership of str
+static void insn_dis_str_set(uint32_t id, char *str) {
+  pthread_mutex_lock(&iferret_load_lock);
+  if (id >= insn_dis_max) {
+    uint32_t n = (insn_dis_max == 0) ? 1024 : insn_dis_max;
+    while (n <= id) n *= 2;
+    insn_dis_str = (char **) realloc(insn_dis_str, n * sizeof(char *));
+    memset(&insn_dis_str[insn_dis_max], 0, (n - insn_dis_max) * sizeof(char *));
+    insn_dis_max = n;
+  }
+  // every chunk repeats the strings it uses, and an id always names the same 
+  // string.  keep the first copy, as someone may be holding on to it.
+  if (insn_dis_str[id] != NULL) {
+    free(str);
+  }
+  else {
+    insn_dis_str[id] = str;
+  }
+  pthread_mutex_unlock(&iferret_load_lock);
+}
+
+// disassembly for an IFLO_INSN_DIS op's id, or NULL if we never saw it.
+char *iferret_insn_dis_str(uint32_t id) {
+  if (id >= insn_dis_max) return NULL;
+  return insn_dis_str[id];
+}
+
+
 void iferret_destroy (iferret_t *iferret) {
   free(iferret->opcount);
   free(iferret->log_prefix);
+  iferret_taint_event_free(iferret->taint_events);
+  iferret_shadow_free(iferret->shadow);
   free(iferret);
 }
 
 
-void iferret_log_process(op_arr_t *op_arr, char *filename) {
-  struct stat fs;
-  uint32_t i, n, iferret_log_size;
-  FILE *fp;
-  iferret_op_t *op = op_arr->ops;
+// Decoding a chunk an op at a time.
+// Everything needed to carry on from where we are is in here, 
+// so a copy of it (a decoder_ckpt_t) lets us come back later.
+typedef struct decoder_struct {
+  iferret_log_reader_t *r;
+  char *block_start;            // header of the current block (format 2)
+  char *block_end;
+  uint32_t block_i;             // number of ops decoded before it
+  tb_schema_tab_t tb_schema;
+  tb_schema_t *tb_learn, *tb_inst;
+  uint32_t tb_learn_left, tb_inst_pos, tb_inst_left;
+  uint32_t i;                   // number of ops decoded
+  uint8_t quiet;                // TRUE to not spit ops under IFDEBUG
+  // where the last few ops were, for debugging
+  op_pos_t pos[OP_POS_CIRC_BUFF_SIZE];
+  op_pos_arr_t op_pos_arr;
+  // the op just decoded
+  iferret_op_t op;
+  iferret_op_arg_t arg[IFERRET_OP_MAX_NUM_ARGS];
   iferret_syscall_t syscall;
-  char command[256];
-  char *op_start;
-  int in_trace = 0;
+  char command[MAX_STRING_LEN+1];
+} decoder_t;
+
+// a decoder's state between two ops.  
+// only good while that decoder is open.
+typedef struct decoder_ckpt_struct {
+  iferret_log_reader_t r;
+  char *block_start;
+  char *block_end;
+  uint32_t block_i;
+  uint32_t tb_inst;             // schema id.  the table moves
+  uint32_t tb_inst_pos, tb_inst_left;
+  uint32_t tb_learn_left;
+  uint32_t i;
+} decoder_ckpt_t;
+
+static decoder_t *decoder_open(char *filename) {
+  decoder_t *d;
+
+  d = (decoder_t *) calloc(1, sizeof(decoder_t));
+  assert (d != NULL);
+  d->op_pos_arr.pos = d->pos;
+  d->op.arg = d->arg;
+  d->op.syscall = &d->syscall;
+  d->op.syscall->command = d->command;
+
+  // map the log, or decompress it if need be
+  if ((d->r = iferret_log_reader_open(filename)) == NULL) {
+    printf ("can't read log %s\n", filename);
+    exit(1);
+  }
+  //printf ("Processing log %s -- %d bytes\n", filename, (int) (d->r->end - d->r->base));
+  
+  // reads ifregaddr &c into d->r
+  // and tells us which format the log is in.
+  iferret_log_preamble_read(d->r); 
+  d->block_start = d->r->ptr;
+  d->block_end = d->r->ptr;
+  return d;
+}
 
-  if (op_pos_arr == NULL) {
-    op_pos_arr = (op_pos_arr_t *) malloc (sizeof(op_pos_arr_t));
-    op_pos_arr->pos = (op_pos_t *) malloc(sizeof (op_pos_t) * OP_POS_CIRC_BUFF_SIZE);
+// set the globals from d's chunk's ifregaddr &c.  
+// every chunk has the same, and the info-flow code may be reading them 
+// while we load, so only write them if they change.
+// the offline info flow doesn't use this.  see flow_put
+static void decoder_regs_set(decoder_t *d) {
+  pthread_mutex_lock(&iferret_load_lock);
+  if (memcmp(ifregaddr, d->r->ifregaddr, sizeof(d->r->ifregaddr)) != 0) {
+    memcpy(ifregaddr, d->r->ifregaddr, sizeof(d->r->ifregaddr));
+    phys_ram_base = d->r->phys_ram_base;
+    iferret_target_os = d->r->target_os;
   }
+  pthread_mutex_unlock(&iferret_load_lock);
+}
 
-  op->syscall = &syscall;
-  op->syscall->command = command;
+static void decoder_close(decoder_t *d) {
+  iferret_log_reader_close(d->r);
+  tb_schema_tab_free(&d->tb_schema);
+  free(d);
+}
 
-  // pull the entire log into memory
-  stat(filename, &fs);
-  iferret_log_size = fs.st_size;
-  fp = fopen(filename, "r");
-  n = fread(iferret_log_base, 1, iferret_log_size, fp);
-  iferret_log_ptr = iferret_log_base;
-  fclose(fp);
-  //printf ("Processing log %s -- %d bytes\n", filename, n);
-  
-  // sets up ifregaddr &c
-  iferret_log_preamble(); 
+static void decoder_save(decoder_t *d, decoder_ckpt_t *c) {
+  c->r = *(d->r);
+  c->block_start = d->block_start;
+  c->block_end = d->block_end;
+  c->block_i = d->block_i;
+  c->tb_inst = (d->tb_inst == NULL) ? 0 : d->tb_inst - d->tb_schema.s;
+  c->tb_inst_pos = d->tb_inst_pos;
+  c->tb_inst_left = d->tb_inst_left;
+  c->tb_learn_left = d->tb_learn_left;
+  c->i = d->i;
+}
 
-  // process each op in the log, in sequence
-  i=0;
-  while (iferret_log_ptr < iferret_log_base + iferret_log_size) {
+static iferret_op_t *decoder_next(decoder_t *d);
+
+// go back to where c was saved.
+// schemas stay as they are if we can.  each is learned at most once in a 
+// chunk (format 1) or block (format 2), and whatever we decode from here 
+// on can only use ones learned before.  that only holds if we've been 
+// through all of c's block up to c since we last started it, and aren't 
+// halfway through learning one.  otherwise, decode c's block from the top.
+static void decoder_restore(decoder_t *d, decoder_ckpt_t *c) {
+  if (d->r->format == 2
+      && (c->block_start != d->block_start || c->i > d->i || d->tb_learn_left > 0)) {
+    *(d->r) = c->r;
+    d->r->ptr = c->block_start;
+    d->block_end = c->block_start;
+    d->tb_inst = NULL;
+    d->tb_inst_left = 0;
+    d->tb_learn = NULL;
+    d->tb_learn_left = 0;
+    d->i = c->block_i;
+    while (d->i < c->i) 
+      decoder_next(d);
+    return;
+  }
+  *(d->r) = c->r;
+  d->block_end = c->block_end;
+  d->tb_inst = (c->tb_inst_left == 0) ? NULL : &d->tb_schema.s[c->tb_inst];
+  d->tb_inst_pos = c->tb_inst_pos;
+  d->tb_inst_left = c->tb_inst_left;
+  // we've been past the end of any schema being learned back then
+  d->tb_learn = NULL;
+  d->tb_learn_left = c->tb_learn_left;
+  d->i = c->i;
+}
+
+// decode the next op.  NULL at the end of the chunk.
+// the op, and any strings in it, are good until the next call.
+static iferret_op_t *decoder_next(decoder_t *d) {
+  iferret_log_reader_t *r = d->r;
+  iferret_op_t *op = &d->op;
+  op_pos_arr_t *op_pos_arr = &d->op_pos_arr;
+  char *op_start;
+  uint32_t i = d->i;
+
+  // (last few ops of a tb instance might have no dynamic args at all)
+  while (r->ptr < r->end || d->tb_inst_left > 0) {
+
+    if (d->tb_inst_left > 0) {
+      // next op of a tb instance.  static args come from the schema.
+      op_start = r->ptr;
+      iferret_log_op_args_read_templated(r, op, &d->tb_inst->ops[d->tb_inst_pos]);
+      d->tb_inst_pos ++;
+      d->tb_inst_left --;
+      goto op_read;
+    }
+
+    if (r->format == 2 && r->ptr >= d->block_end) {
+      // format 2: next block.  check it's all there and intact.
+      uint32_t len, cksum;
+      d->block_start = r->ptr;
+      d->block_i = i;
+      if (r->ptr + IFERRET_LOG_BLOCK_HEADER_SIZE > r->end) {
+        printf ("truncated block header at offset %lu after op %d\n", 
+                (unsigned long) (r->ptr - r->base), i);
+        exit(1);
+      }
+      len = iferret_log_uint32_t_read(r);
+      cksum = iferret_log_uint32_t_read(r);
+      d->block_end = r->ptr + len;
+      if (d->block_end > r->end
+          || cksum != adler32(adler32(0L, Z_NULL, 0), (Bytef *) r->ptr, len)) {
+        printf ("checksum failed for block at offset %lu after op %d\n", 
+                (unsigned long) (r->ptr - IFERRET_LOG_BLOCK_HEADER_SIZE - r->base), i);
+        exit(1);
+      }
+      // delta-encoded args, page contexts and schemas start afresh in each block
+      r->block_gen ++;
+      memset(r->page_ctx, 0, sizeof(r->page_ctx));
+      tb_schema_tab_clear(&d->tb_schema);
+      continue;
+    }
 
-    op_start = iferret_log_ptr;
-    op->num = iferret_log_op_only_read();
-    if ((iferret_log_sentinel_check()) == 0) {
+    op_start = r->ptr;
+    op->num = iferret_log_op_only_read(r);
+    if (r->format == 2 && op->num >= IFLO_DUMMY_LAST) {
+      printf ("bad op %d at op %d\n", op->num, i);
+      exit(1);
+    }
+    if (r->format == 1 && (iferret_log_sentinel_check(r)) == 0) {
       printf ("sentinel failed at op %d\n", i);
       printf ("%d op=%d %s\n", i, op->num, iferret_op_num_to_str(op->num));
-      printf ("%.2f percent of log\n", 100 * ((float) (iferret_log_ptr - iferret_log_base)) / n);
+      printf ("%.2f percent of log\n", 100 * ((float) (r->ptr - r->base)) / (r->end - r->base));
       { 
         int j;
         for (j=10; j>=1; j--) {
           printf ("i-%d=%d ", j, i-j);
-          op_hex_dump((i-j) % OP_POS_CIRC_BUFF_SIZE);
+          op_hex_dump(op_pos_arr, (i-j) % OP_POS_CIRC_BUFF_SIZE);
         }
-        op_hex_dump_aux(op->num, op_start, iferret_log_ptr, "current");
+        op_hex_dump_aux(op->num, op_start, r->ptr, "current");
       }
       exit(1);
     }
-    iferret_log_op_args_read(op);
+    iferret_log_op_args_read(r, op);
+
+    if (op->num == IFLO_INSN_DIS_STR) {
+      insn_dis_str_set(op->arg[0].val.u32, strdup(op->arg[1].val.str));
+      continue;
+    }
+    if (op->num == IFLO_TB_SCHEMA || op->num == IFLO_TB_INSTANCE) {
+      tb_schema_t *s = tb_schema_get(&d->tb_schema, op->arg[0].val.u32);
+      uint32_t count = op->arg[1].val.u8;
+      if (op->num == IFLO_TB_SCHEMA) {
+        // the next count ops are logged in full and make up the schema.
+        // unless we've rewound, and already have it.
+        if (s->learned) {
+          d->tb_learn = NULL;
+        }
+        else {
+          tb_schema_free(s);
+          s->ops = (iferret_op_t *) malloc(count * sizeof(iferret_op_t));
+          s->learned = TRUE;
+          d->tb_learn = s;
+        }
+        d->tb_learn_left = count;
+      }
+      else {
+        if (count > s->num_ops) {
+          printf ("tb instance of %d ops but schema %d has %d at op %d\n", 
+                  count, op->arg[0].val.u32, s->num_ops, i);
+          exit(1);
+        }
+        d->tb_inst = s;
+        d->tb_inst_pos = 0;
+        d->tb_inst_left = count;
+      }
+      continue;
+    }
+    if (d->tb_learn_left > 0) {
+      if (d->tb_learn != NULL) 
+        tb_schema_add(d->tb_learn, op);
+      d->tb_learn_left --;
+    }
 
+  op_read:
 #ifdef IFDEBUG
-    iferret_spit_op(op);
+    if (!d->quiet) 
+      iferret_spit_op(op);
 #endif
 
-//    if (op.num == IFLO_LABEL_INPUT) {
-//        in_trace = 1;
-//    }
-//
-//    if (in_trace) {
-//    }
-//    if (op.num == IFLO_LABEL_OUTPUT) {
-//        in_trace = 0;
-//    }
-
     op_pos_arr->pos[i%OP_POS_CIRC_BUFF_SIZE].opnum = op->num;
     op_pos_arr->pos[i%OP_POS_CIRC_BUFF_SIZE].start = op_start;
-    op_pos_arr->pos[i%OP_POS_CIRC_BUFF_SIZE].end = iferret_log_ptr-1;
-    i++;
+    op_pos_arr->pos[i%OP_POS_CIRC_BUFF_SIZE].end = r->ptr-1;
+    d->i = i + 1;
+    return op;
+  }
+  return NULL;
+}
 
-    if (op->num != IFLO_INSN_DIS && op->num < IFLO_SYS_CALLS_START)
-        op_arr->num++;
-    else {
+// TRUE iff op goes in the op store.  
+// the store's op indices, and a cursor's, only count these.
+static inline int op_kept(iferret_op_t *op) {
 #ifdef IFDEBUG
-        op_arr->num++;
+  return TRUE;
+#else
+  return (op->num != IFLO_INSN_DIS && op->num < IFLO_SYS_CALLS_START);
 #endif
+}
+
+// Chunk indexes.
+// Each chunk gets a sidecar, <chunk>.idx, the first time it's loaded.  
+// It says how many ops the chunk has, where decoding can start partway 
+// through it, and where the tb heads and input / output labels are, 
+// so we can go straight to any of those without decoding from the top.
+// Format 2 decoding can start at any block, as nothing carries over 
+// from one to the next.  Format 1 decoding can start anywhere between 
+// tb instances, given the page contexts and tb schemas.  We keep one such 
+// place about every INDEX_STRIDE ops, along with (format 1) all the 
+// chunk's schemas.
+// Op indices in it are of kept ops (see op_kept), from the chunk's first, 
+// and fit in 32 bits, as a chunk can't be 4G ops.
+// An index built with another stride, or by a build that keeps other ops, 
+// or for a chunk in another format, is rebuilt.
+#define INDEX_MAGIC 0x3358444954524546ULL   // "FERTIDX3"
+#define INDEX_STRIDE (1 << 16)
+
+// how this build decides which ops are kept
+#define INDEX_FLAG_DEBUG 1
+#ifdef IFDEBUG
+#define INDEX_FLAGS INDEX_FLAG_DEBUG
+#else
+#define INDEX_FLAGS 0
+#endif
+
+typedef struct index_head_struct {
+  uint64_t magic;
+  uint32_t stride;
+  uint32_t format;
+  uint32_t flags;
+  uint32_t pad;
+  // the chunk as it was when we indexed it
+  uint64_t chunk_size;
+  uint64_t chunk_mtime_sec, chunk_mtime_nsec;
+  uint64_t num_ops;
+  uint64_t num_ckpt, num_eip, num_tb, num_label, num_schema;
+} index_head_t;
+
+// somewhere decoding can start
+typedef struct index_ckpt_struct {
+  uint64_t op;                  // index of the next kept op
+  uint64_t offset;              // in the chunk
+  uint64_t block_end;           // offset of the end of the current block
+  uint32_t i;                   // number of ops decoded before here
+  uint32_t pad;
+  iferret_page_ctx_t page_ctx[IFERRET_PAGE_CTX_SIZE];
+} index_ckpt_t;
+
+// the IFLO_TB_HEAD_EIP ops for one eip are tb[first] .. tb[first+num-1], 
+// in order.  these are sorted by eip.
+typedef struct index_eip_struct {
+  uint32_t eip;
+  uint32_t num;
+  uint64_t first;
+} index_eip_t;
+
+// an IFLO_LABEL_INPUT or IFLO_LABEL_OUTPUT op.  sorted by op
+typedef struct index_label_struct {
+  uint32_t op;
+  uint32_t opnum;
+} index_label_t;
+
+// the file has the head, then the ckpts, eips, tbs and labels, 
+// then the schemas.  for each, 
+// uint32_t id, num_ops, then for each op
+// uint32_t num, uint8_t flags, num_args, then for each arg
+// uint8_t type, then uint32_t length and the chars for a string, or uint64_t val.
+typedef struct index_struct {
+  index_head_t h;
+  index_ckpt_t *ckpt;
+  index_eip_t *eip;
+  uint32_t *tb;                 // ops
+  index_label_t *label;
+  uint64_t max_ckpt, max_tb, max_label;
+  uint32_t *tb_eip;             // while building, the eip for each tb
+} index_t;
+
+// malloc'd
+static char *index_name(char *filename) {
+  char *name;
+
+  name = (char *) malloc(strlen(filename) + 5);
+  assert (name != NULL);
+  sprintf(name, "%s.idx", filename);
+  return name;
+}
+
+static int index_chunk_stat(char *filename, index_head_t *h) {
+  struct stat st;
+
+  if (stat(filename, &st) != 0) return FALSE;
+  h->chunk_size = st.st_size;
+  h->chunk_mtime_sec = st.st_mtim.tv_sec;
+  h->chunk_mtime_nsec = st.st_mtim.tv_nsec;
+  return TRUE;
+}
+
+static void index_free(index_t *x) {
+  free(x->ckpt);
+  free(x->eip);
+  free(x->tb);
+  free(x->tb_eip);
+  free(x->label);
+  memset(x, 0, sizeof(index_t));
+}
+
+// open filename's index and read its head into h.  
+// NULL if it has none, or it's no good for the chunk as it is now.
+static FILE *index_head_read(index_head_t *h, char *filename) {
+  char *name;
+  index_head_t now;
+  FILE *fp;
+
+  if (!index_chunk_stat(filename, &now)) return NULL;
+  name = index_name(filename);
+  fp = fopen(name, "r");
+  free(name);
+  if (fp == NULL) return NULL;
+  if (fread(h, sizeof(index_head_t), 1, fp) == 1
+      && h->magic == INDEX_MAGIC
+      && h->stride == INDEX_STRIDE
+      && h->flags == INDEX_FLAGS
+      && h->chunk_size == now.chunk_size
+      && h->chunk_mtime_sec == now.chunk_mtime_sec
+      && h->chunk_mtime_nsec == now.chunk_mtime_nsec
+      && h->num_ckpt > 0
+      && h->format == iferret_log_chunk_format(filename)) 
+    return fp;
+  fclose(fp);
+  return NULL;
+}
+
+// read filename's index, all but the schemas, into x.
+// FALSE if it has none, or the chunk has changed since.
+static int index_read(index_t *x, char *filename) {
+  FILE *fp;
+  int ok;
+
+  memset(x, 0, sizeof(index_t));
+  if ((fp = index_head_read(&x->h, filename)) == NULL) {
+    memset(x, 0, sizeof(index_t));
+    return FALSE;
+  }
+  x->ckpt = (index_ckpt_t *) malloc(x->h.num_ckpt * sizeof(index_ckpt_t));
+  x->eip = (index_eip_t *) malloc((x->h.num_eip + 1) * sizeof(index_eip_t));
+  x->tb = (uint32_t *) malloc((x->h.num_tb + 1) * sizeof(uint32_t));
+  x->label = (index_label_t *) malloc((x->h.num_label + 1) * sizeof(index_label_t));
+  ok = (fread(x->ckpt, sizeof(index_ckpt_t), x->h.num_ckpt, fp) == x->h.num_ckpt
+        && fread(x->eip, sizeof(index_eip_t), x->h.num_eip, fp) == x->h.num_eip
+        && fread(x->tb, sizeof(uint32_t), x->h.num_tb, fp) == x->h.num_tb
+        && fread(x->label, sizeof(index_label_t), x->h.num_label, fp) == x->h.num_label);
+  fclose(fp);
+  if (!ok) index_free(x);
+  return ok;
+}
+
+// load the schemas in filename's index into d, but for any it's learned.
+// x is what index_read got from it.
+static void index_schemas_read(index_t *x, char *filename, decoder_t *d) {
+  char *name, str[MAX_STRING_LEN+1];
+  uint32_t id, n, len, k, j;
+  iferret_op_t *op;
+  tb_schema_t *s, spare;
+  uint64_t m;
+  FILE *fp;
+
+  name = index_name(filename);
+  if ((fp = fopen(name, "r")) == NULL
+      || fseek(fp, sizeof(index_head_t) 
+               + x->h.num_ckpt * sizeof(index_ckpt_t) 
+               + x->h.num_eip * sizeof(index_eip_t)
+               + x->h.num_tb * sizeof(uint32_t)
+               + x->h.num_label * sizeof(index_label_t), SEEK_SET) != 0) {
+    printf ("can't read schemas from %s\n", name);
+    exit(1);
+  }
+  for (m=0; m<x->h.num_schema; m++) {
+    if (fread(&id, sizeof(uint32_t), 1, fp) != 1
+        || fread(&n, sizeof(uint32_t), 1, fp) != 1) 
+      goto bad;
+    memset(&spare, 0, sizeof(spare));
+    s = tb_schema_get(&d->tb_schema, id);
+    if (s->learned) s = &spare;
+    s->ops = (iferret_op_t *) calloc(n, sizeof(iferret_op_t));
+    s->learned = TRUE;
+    for (k=0; k<n; k++) {
+      op = &s->ops[s->num_ops++];
+      if (fread(&op->num, sizeof(uint32_t), 1, fp) != 1
+          || fread(&op->flags, sizeof(uint8_t), 1, fp) != 1
+          || fread(&op->num_args, sizeof(uint8_t), 1, fp) != 1) 
+        goto bad;
+      if (op->num_args == 0) continue;
+      op->arg = (iferret_op_arg_t *) calloc(op->num_args, sizeof(iferret_op_arg_t));
+      for (j=0; j<op->num_args; j++) {
+        uint8_t type;
+        if (fread(&type, sizeof(uint8_t), 1, fp) != 1) goto bad;
+        op->arg[j].type = type;
+        if (type == IFLAT_STR) {
+          if (fread(&len, sizeof(uint32_t), 1, fp) != 1 || len > MAX_STRING_LEN
+              || fread(str, 1, len, fp) != len) 
+            goto bad;
+          str[len] = 0;
+          op->arg[j].val.str = strdup(str);
+        }
+        else if (fread(&op->arg[j].val.u64, sizeof(uint64_t), 1, fp) != 1) {
+          goto bad;
+        }
+      }
     }
+    tb_schema_free(&spare);
+  }
+  fclose(fp);
+  free(name);
+  return;
+ bad:
+  printf ("bad schema in %s\n", name);
+  exit(1);
+}
 
-    if (op_arr->num >= op_arr->max)
-        op_arr_grow(op_arr);
+static int index_pair_cmp(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+  return (x < y) ? -1 : (x > y);
+}
+
+// sort the tbs into x's eips, by way of (eip, op) pairs packed in uint64_ts
+static void index_tb_sort(index_t *x) {
+  uint64_t *pair, k;
+  index_eip_t *e;
+
+  pair = (uint64_t *) malloc((x->h.num_tb + 1) * sizeof(uint64_t));
+  for (k=0; k<x->h.num_tb; k++) 
+    pair[k] = (((uint64_t) x->tb_eip[k]) << 32) | x->tb[k];
+  qsort(pair, x->h.num_tb, sizeof(uint64_t), index_pair_cmp);
+  x->eip = (index_eip_t *) malloc((x->h.num_tb + 1) * sizeof(index_eip_t));
+  x->h.num_eip = 0;
+  e = NULL;
+  for (k=0; k<x->h.num_tb; k++) {
+    x->tb[k] = (uint32_t) pair[k];
+    if (e == NULL || e->eip != (uint32_t) (pair[k] >> 32)) {
+      e = &x->eip[x->h.num_eip++];
+      e->eip = pair[k] >> 32;
+      e->num = 0;
+      e->first = k;
+    }
+    e->num ++;
+  }
+  free(pair);
+}
+
+// write x, and (format 1) the schemas d has learned, as filename's index.
+// it's only an index.  if we can't write it, we do without.
+static void index_write(index_t *x, char *filename, decoder_t *d) {
+  char *name, *tmp;
+  uint32_t id, k, j, len, max;
+  iferret_op_t *op;
+  tb_schema_t *s;
+  FILE *fp;
 
-    op = &op_arr->ops[op_arr->num];
-    op->syscall = &syscall;
-    op->syscall->command = command;
+  if (!index_chunk_stat(filename, &x->h)) return;
+  x->h.magic = INDEX_MAGIC;
+  x->h.stride = INDEX_STRIDE;
+  x->h.format = d->r->format;
+  x->h.flags = INDEX_FLAGS;
+  x->h.num_schema = 0;
+  // format 2's are only good for the last block
+  max = (x->h.format == 2) ? 0 : d->tb_schema.max;
+  for (id=0; id<max; id++) 
+    if (d->tb_schema.s[id].learned) x->h.num_schema ++;
+  index_tb_sort(x);
+
+  // readers only ever see a whole one
+  name = index_name(filename);
+  tmp = (char *) malloc(strlen(name) + 5);
+  assert (tmp != NULL);
+  sprintf(tmp, "%s.tmp", name);
+  if ((fp = fopen(tmp, "w")) == NULL) {
+    free(tmp);
+    free(name);
+    return;
   }
+  fwrite(&x->h, sizeof(index_head_t), 1, fp);
+  fwrite(x->ckpt, sizeof(index_ckpt_t), x->h.num_ckpt, fp);
+  fwrite(x->eip, sizeof(index_eip_t), x->h.num_eip, fp);
+  fwrite(x->tb, sizeof(uint32_t), x->h.num_tb, fp);
+  fwrite(x->label, sizeof(index_label_t), x->h.num_label, fp);
+  for (id=0; id<max; id++) {
+    s = &d->tb_schema.s[id];
+    if (!s->learned) continue;
+    fwrite(&id, sizeof(uint32_t), 1, fp);
+    fwrite(&s->num_ops, sizeof(uint32_t), 1, fp);
+    for (k=0; k<s->num_ops; k++) {
+      op = &s->ops[k];
+      fwrite(&op->num, sizeof(uint32_t), 1, fp);
+      fwrite(&op->flags, sizeof(uint8_t), 1, fp);
+      fwrite(&op->num_args, sizeof(uint8_t), 1, fp);
+      for (j=0; j<op->num_args; j++) {
+        uint8_t type = op->arg[j].type;
+        fwrite(&type, sizeof(uint8_t), 1, fp);
+        if (type == IFLAT_STR) {
+          len = strlen(op->arg[j].val.str);
+          fwrite(&len, sizeof(uint32_t), 1, fp);
+          fwrite(op->arg[j].val.str, 1, len, fp);
+        }
+        else {
+          fwrite(&op->arg[j].val.u64, sizeof(uint64_t), 1, fp);
+        }
+      }
+    }
+  }
+  if (fclose(fp) != 0 || rename(tmp, name) != 0) 
+    unlink(tmp);
+  free(tmp);
+  free(name);
+}
 
+// TRUE iff decoding could start from where d is now
+// (format 2: only at a block.  the last ops of a tb instance 
+// can be all static, so we may be at the end of one and not done)
+static inline int index_can_start(decoder_t *d) {
+  return (d->tb_inst_left == 0
+          && (d->r->format != 2 || d->r->ptr >= d->block_end));
+}
+
+// while building x: d is about to decode kept op n
+static inline void index_ckpt_note(index_t *x, decoder_t *d, uint64_t n) {
+  iferret_log_reader_t *r = d->r;
+  index_ckpt_t *c;
+
+  if (n < x->h.num_ckpt * INDEX_STRIDE || !index_can_start(d)) return;
+  if (x->h.num_ckpt == x->max_ckpt) {
+    x->max_ckpt = (x->max_ckpt == 0) ? 16 : 2 * x->max_ckpt;
+    x->ckpt = (index_ckpt_t *) realloc(x->ckpt, x->max_ckpt * sizeof(index_ckpt_t));
+  }
+  c = &x->ckpt[x->h.num_ckpt++];
+  memset(c, 0, sizeof(index_ckpt_t));
+  c->op = n;
+  c->offset = r->ptr - r->base;
+  c->block_end = d->block_end - r->base;
+  c->i = d->i;
+  memcpy(c->page_ctx, r->page_ctx, sizeof(c->page_ctx));
+}
+
+// while building x: op is kept op n
+static inline void index_op_note(index_t *x, iferret_op_t *op, uint64_t n) {
+  if (op->num == IFLO_TB_HEAD_EIP) {
+    if (x->h.num_tb == x->max_tb) {
+      x->max_tb = (x->max_tb == 0) ? 1024 : 2 * x->max_tb;
+      x->tb = (uint32_t *) realloc(x->tb, x->max_tb * sizeof(uint32_t));
+      x->tb_eip = (uint32_t *) realloc(x->tb_eip, x->max_tb * sizeof(uint32_t));
+    }
+    x->tb[x->h.num_tb] = n;
+    x->tb_eip[x->h.num_tb] = op->arg[0].val.u32;
+    x->h.num_tb ++;
+  }
+  else if (op->num == IFLO_LABEL_INPUT || op->num == IFLO_LABEL_OUTPUT) {
+    if (x->h.num_label == x->max_label) {
+      x->max_label = (x->max_label == 0) ? 64 : 2 * x->max_label;
+      x->label = (index_label_t *) realloc(x->label, x->max_label * sizeof(index_label_t));
+    }
+    x->label[x->h.num_label].op = n;
+    x->label[x->h.num_label].opnum = op->num;
+    x->h.num_label ++;
+  }
+}
+
+// start decoding from c, in x
+static void decoder_seek(decoder_t *d, index_t *x, index_ckpt_t *c) {
+  iferret_log_reader_t *r = d->r;
+
+  // (format 2: at a block header.  reading it resets the rest)
+  r->ptr = r->base + c->offset;
+  d->block_start = r->ptr;
+  d->block_end = r->base + c->block_end;
+  d->block_i = c->i;
+  memcpy(r->page_ctx, c->page_ctx, sizeof(c->page_ctx));
+  d->tb_inst = NULL;
+  d->tb_inst_pos = 0;
+  d->tb_inst_left = 0;
+  d->tb_learn = NULL;
+  d->tb_learn_left = 0;
+  d->i = c->i;
+}
+
+// last place in x decoding can start from before kept op n
+static index_ckpt_t *index_ckpt_find(index_t *x, uint64_t n) {
+  uint64_t lo = 0, hi = x->h.num_ckpt, mid;
+
+  // the first is at op 0
+  while (hi - lo > 1) {
+    mid = (lo + hi) / 2;
+    if (x->ckpt[mid].op <= n) lo = mid;
+    else hi = mid;
+  }
+  return &x->ckpt[lo];
+}
+
+// does filename have an up-to-date index?
+static int index_fresh(char *filename) {
+  index_head_t h;
+  FILE *fp;
+
+  if ((fp = index_head_read(&h, filename)) == NULL) return FALSE;
+  fclose(fp);
+  return TRUE;
+}
+
+// add the ops in a chunk to op_arr.  
+// builds the chunk's index too, if it hasn't got one.  
+// op_arr can be NULL, to just do that.
+void iferret_log_process(op_arr_t *op_arr, char *filename) {
+  decoder_t *d;
+  iferret_op_t *op;
+  index_t x, *xp;
+  uint64_t n;
+
+  xp = NULL;
+  if (!index_fresh(filename)) {
+    memset(&x, 0, sizeof(x));
+    xp = &x;
+  }
+  else if (op_arr == NULL) {
+    return;
+  }
+
+  // process each op in the log, in sequence
+  d = decoder_open(filename);
+  decoder_regs_set(d);
+  n = 0;
+  while (1) {
+    if (xp) index_ckpt_note(xp, d, n);
+    if ((op = decoder_next(d)) == NULL) break;
+    if (op_kept(op)) {
+      if (xp) index_op_note(xp, op, n);
+      if (op_arr) op_arr_add(op_arr, op);
+      n ++;
+    }
+  }
+  if (xp) {
+    x.h.num_ops = n;
+    index_write(xp, filename, d);
+    index_free(xp);
+  }
+  decoder_close(d);
   //printf("Done processing %ld ops\n", op_arr->num);
 }
 
 
 void usage() {
-  printf ("Usage: iferret -l LOG_PREFIX -s START_LOG_NUM -n NUM_LOGS\n");
+  printf ("Usage: iferret -l LOG_PREFIX -s START_LOG_NUM -n NUM_LOGS [-f] [-e]\n");
+  printf ("  -f  run the logs through info flow rather than loading them\n");
+  printf ("  -e  print taint events as they happen, not once info flow is done\n");
   exit (1);
 }
 
@@ -334,6 +1867,8 @@ static struct option longopts[] = {
   { "logprefix",    required_argument, NULL, 'l'},
   { "logstartnum",  optional_argument, NULL, 's'},
   { "numlogs",      required_argument, NULL, 'n'},
+  { "infoflow",     no_argument,       NULL, 'f'},
+  { "taintevents",  no_argument,       NULL, 'e'},
   { NULL, 0, NULL, 0}
 };
 
@@ -341,7 +1876,7 @@ static struct option longopts[] = {
 void process_opt(int argc, char **argv, iferret_t *iferret) {
   int opt;
 
-  while ((opt = getopt_long(argc, argv, "l:s:n:", longopts, NULL)) != -1) {
+  while ((opt = getopt_long(argc, argv, "l:s:n:fe", longopts, NULL)) != -1) {
     switch (opt) {
     case 'l':
       iferret->log_prefix = strdup(optarg);
@@ -352,6 +1887,12 @@ void process_opt(int argc, char **argv, iferret_t *iferret) {
     case 'n':
       iferret->num_logs = atoi(optarg);
       break;
+    case 'f':
+      iferret->info_flow = TRUE;
+      break;
+    case 'e':
+      iferret_taint_event_start(iferret->taint_events, stdout);
+      break;
     default:
       usage();
     }
@@ -366,41 +1907,751 @@ void process_opt(int argc, char **argv, iferret_t *iferret) {
   }
 }
 
-op_arr_t * init(char *prefix, int start, int num_logs) {
-  char  filename[1024];
-  int i,j;
-  op_arr_t *op_arr;
+// Loading several chunks.
+// Chunks only share what iferret_load_lock guards, so they are decoded 
+// in parallel, each into a store of its own.  Then the stores are 
+// stitched together in order, each chunk's ops and args going in at 
+// offsets given by the sums of those before it.
+typedef struct load_struct {
+  char *prefix;
+  int start;
+  int num;                      // number of chunks
+  op_arr_t **chunk;             // store for each chunk
+  uint64_t *op_base;            // where each chunk's ops go in op_arr
+  uint64_t *arg_base;           // and its args
+  op_arr_t *op_arr;             // all of them, stitched
+  int next;                     // next chunk for a thread to take
+  void (*fn)(struct load_struct *l, int i);
+} load_t;
+
+static void *load_thread(void *arg) {
+  load_t *l = (load_t *) arg;
+  int i;
+
+  while (1) {
+    pthread_mutex_lock(&iferret_load_lock);
+    i = l->next++;
+    pthread_mutex_unlock(&iferret_load_lock);
+    if (i >= l->num) break;
+    l->fn(l, i);
+  }
+  return NULL;
+}
 
-  op_arr = op_arr_init(); 
-  iferret_log_create();
+// run fn on every chunk, with a thread per cpu
+static void load_run(load_t *l, void (*fn)(load_t *l, int i)) {
+  pthread_t *thread;
+  int i, n;
+
+  n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n > l->num) n = l->num;
+  if (n < 1) n = 1;
+  l->fn = fn;
+  l->next = 0;
+  thread = (pthread_t *) malloc(n * sizeof(pthread_t));
+  for (i=0; i<n; i++) {
+    if (pthread_create(&thread[i], NULL, load_thread, l) != 0) {
+      printf ("can't start load thread\n");
+      exit(1);
+    }
+  }
+  for (i=0; i<n; i++) {
+    pthread_join(thread[i], NULL);
+  }
+  free(thread);
+}
+
+static void load_decode(load_t *l, int i) {
+  char filename[1024];
 
-  // iterate over logfiles and process each in sequence
-  for (j=0; j < num_logs; j++) {
-    i = start + j; 
-    sprintf(filename, "%s-%d", prefix, i);
-    //printf ("process: log %d: %d of %d: %s\n", i, j, iferret->num_logs, filename);
-    iferret_log_process(op_arr, filename);
+  snprintf(filename, 1024, "%s-%d", l->prefix, l->start + i);
+  //printf ("process: log %d: %d of %d: %s\n", l->start + i, i, l->num, filename);
+  l->chunk[i] = op_arr_init();
+  iferret_log_process(l->chunk[i], filename);
+}
+
+static void load_stitch(load_t *l, int i) {
+  op_arr_t *c = l->chunk[i], *a = l->op_arr;
+  uint64_t o = l->op_base[i], k;
+
+  memcpy(&a->opnum[o], c->opnum, c->num * sizeof(uint32_t));
+  memcpy(&a->flags[o], c->flags, c->num * sizeof(uint8_t));
+  memcpy(&a->num_args[o], c->num_args, c->num * sizeof(uint8_t));
+  for (k=0; k<c->num; k++) {
+    a->arg_off[o + k] = l->arg_base[i] + c->arg_off[k];
   }
+  memcpy(&a->arg[l->arg_base[i]], c->arg, c->num_arg * sizeof(uint64_t));
+  // the strings stay put.  op_arr takes them over once we're done.
+  op_arr_free_columns(c);
+}
+
+op_arr_t * init(char *prefix, int start, int num_logs) {
+  op_arr_t *op_arr;
+  load_t l;
+  uint64_t num, num_arg;
+  int i;
+
+  memset(&l, 0, sizeof(l));
+  l.prefix = prefix;
+  l.start = start;
+  l.num = num_logs;
+  l.chunk = (op_arr_t **) calloc(num_logs, sizeof(op_arr_t *));
+  l.op_base = (uint64_t *) malloc(num_logs * sizeof(uint64_t));
+  l.arg_base = (uint64_t *) malloc(num_logs * sizeof(uint64_t));
+
+  load_run(&l, load_decode);
+  if (num_logs == 1) {
+    // nothing to stitch
+    op_arr = l.chunk[0];
+  }
+  else {
+    num = num_arg = 0;
+    for (i=0; i<num_logs; i++) {
+      l.op_base[i] = num;
+      l.arg_base[i] = num_arg;
+      num += l.chunk[i]->num;
+      num_arg += l.chunk[i]->num_arg;
+    }
+    op_arr = op_arr_init();
+    op_arr_resize(op_arr, (num > 0) ? num : 1);
+    op_arr_arg_resize(op_arr, (num_arg > 0) ? num_arg : 1);
+    l.op_arr = op_arr;
+    load_run(&l, load_stitch);
+    op_arr->num = num;
+    op_arr->num_arg = num_arg;
+    for (i=0; i<num_logs; i++) {
+      iferret_str_tab_adopt(&op_arr->str, &l.chunk[i]->str);
+      free(l.chunk[i]);
+    }
+  }
+  free(l.chunk);
+  free(l.op_base);
+  free(l.arg_base);
 
   op_arr_fit(op_arr); 
-  free(iferret_log_base);
+  op_arr_post(op_arr);
 
   return op_arr;
 }
 
+// Offline info flow.
+// The chunks are decoded in order on one thread and their ops run 
+// through iferret_info_flow.c on another, so reading, decoding and 
+// propagating overlap.  Decoded ops go across in batches, through a ring 
+// of FLOW_RING_SIZE of them: the decoder fills the batch at head and 
+// hands it over by moving head on, and the propagator empties the one 
+// at tail and gives it back by moving tail on.  Each index has one 
+// writer, so there's no lock.  A decoder that gets FLOW_RING_SIZE 
+// batches ahead naps until one comes back, which is all the 
+// backpressure there is, and a propagator with nothing to do naps too.  
+// Each side counts its ops and how long it spent napping, which says 
+// which of the two is holding things up.
+// An op whose strings won't fit in a batch's str gets a batch to itself, 
+// with the strings in a spill buffer that goes when the batch is reused.
+// The decoder doesn't touch ifregaddr, which the propagator is using.  
+// Each batch carries its chunk's instead, and the propagator sets the 
+// global from it.
+#define FLOW_BATCH_OPS 4096
+#define FLOW_BATCH_ARGS (4 * FLOW_BATCH_OPS)
+#define FLOW_BATCH_STRS (16 * 1024)
+#define FLOW_RING_SIZE 8                // batches.  a power of 2
+#define FLOW_NAP_USEC 50
+
+typedef struct flow_batch_struct {
+  uint32_t num_ops, num_args, num_strs;
+  char *spill;                                  // malloc'd strings of an op too big for str, or NULL
+  uint64_t ifregaddr[IFRN_Q4+1];                // for the chunk its ops are from
+  iferret_op_t op[FLOW_BATCH_OPS];
+  iferret_op_arg_t arg[FLOW_BATCH_ARGS];        // op[i].arg points in here
+  char str[FLOW_BATCH_STRS];                    // and string args in here
+} flow_batch_t;
+
+// what each side did
+typedef struct flow_stage_struct {
+  uint64_t ops;
+  uint64_t batches;
+  uint64_t naps;
+  uint64_t nap_usec;
+  uint64_t usec;                // start to finish
+} flow_stage_t;
+
+typedef struct flow_struct {
+  iferret_t *iferret;
+  flow_batch_t *batch;                  // the ring
+  // the decoder's.  
+  volatile uint64_t head;               // batches handed over
+  volatile uint8_t done;                // TRUE once the last one has been
+  flow_batch_t *fill;                   // batch[head % FLOW_RING_SIZE]
+  flow_stage_t decode;
+  // keep the propagator's index off the decoder's cache line
+  char pad[64];
+  // the propagator's
+  volatile uint64_t tail;               // batches given back
+  flow_stage_t propagate;
+} flow_t;
+
+static uint64_t flow_usec_since(struct timeval *start) {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return ((uint64_t) (now.tv_sec - start->tv_sec)) * 1000000
+    + (now.tv_usec - start->tv_usec);
+}
+
+static void flow_nap(flow_stage_t *st) {
+  struct timespec nap;
+  struct timeval start;
+
+  nap.tv_sec = 0;
+  nap.tv_nsec = FLOW_NAP_USEC * 1000;
+  gettimeofday(&start, NULL);
+  nanosleep(&nap, NULL);
+  st->naps ++;
+  st->nap_usec += flow_usec_since(&start);
+}
+
+// hand over the batch being filled, if there's anything in it, 
+// and wait for room for the next
+static void flow_hand_over(flow_t *f) {
+  if (f->fill->num_ops == 0) 
+    return;
+  f->decode.batches ++;
+  // the batch has to be all there before the propagator sees head move
+  __sync_synchronize();
+  f->head ++;
+  while (f->head - f->tail == FLOW_RING_SIZE) 
+    flow_nap(&f->decode);
+  // and the propagator has to be done with it before we write it again
+  __sync_synchronize();
+  f->fill = &(f->batch[f->head % FLOW_RING_SIZE]);
+  f->fill->num_ops = f->fill->num_args = f->fill->num_strs = 0;
+  free(f->fill->spill);
+  f->fill->spill = NULL;
+}
+
+// copy op, from d's chunk, into the batch being filled.  
+// the decoder's op, args and strings get reused, so it all has to be copied.
+static void flow_put(flow_t *f, decoder_t *d, iferret_op_t *op) {
+  flow_batch_t *b = f->fill;
+  iferret_op_t *o;
+  uint32_t j, len, strs;
+  char *str;
+
+  for (strs=0, j=0; j<op->num_args; j++) {
+    if (op->arg[j].type == IFLAT_STR) 
+      strs += strlen(op->arg[j].val.str) + 1;
+  }
+  assert (op->num_args <= FLOW_BATCH_ARGS);
+  if (b->num_ops == FLOW_BATCH_OPS 
+      || b->num_args + op->num_args > FLOW_BATCH_ARGS
+      || b->num_strs + strs > FLOW_BATCH_STRS
+      || (b->num_ops > 0 
+          && memcmp(b->ifregaddr, d->r->ifregaddr, sizeof(b->ifregaddr)) != 0)) {
+    flow_hand_over(f);
+    b = f->fill;
+  }
+  if (b->num_ops == 0) 
+    memcpy(b->ifregaddr, d->r->ifregaddr, sizeof(b->ifregaddr));
+  if (strs > FLOW_BATCH_STRS) {
+    // b is empty.  fill str up so the next op goes in another batch
+    b->spill = (char *) malloc(strs);
+    assert (b->spill != NULL);
+    str = b->spill;
+    b->num_strs = FLOW_BATCH_STRS;
+  }
+  else {
+    str = &(b->str[b->num_strs]);
+    b->num_strs += strs;
+  }
+  o = &(b->op[b->num_ops++]);
+  *o = *op;
+  o->syscall = NULL;
+  o->arg = &(b->arg[b->num_args]);
+  memcpy(o->arg, op->arg, op->num_args * sizeof(iferret_op_arg_t));
+  b->num_args += op->num_args;
+  for (j=0; j<op->num_args; j++) {
+    if (op->arg[j].type == IFLAT_STR) {
+      len = strlen(op->arg[j].val.str) + 1;
+      o->arg[j].val.str = memcpy(str, op->arg[j].val.str, len);
+      str += len;
+    }
+  }
+  f->decode.ops ++;
+}
+
+static void *flow_decode_thread(void *arg) {
+  flow_t *f = (flow_t *) arg;
+  iferret_t *iferret = f->iferret;
+  char filename[1024];
+  struct timeval start;
+  decoder_t *d;
+  iferret_op_t *op;
+  uint32_t j;
+
+  gettimeofday(&start, NULL);
+  for (j=0; j<iferret->num_logs; j++) {
+    snprintf(filename, 1024, "%s-%d", iferret->log_prefix, iferret->start_log_num + j);
+    d = decoder_open(filename);
+    // stdout is for taint events, and spitting would swamp the timings
+    d->quiet = TRUE;
+    while ((op = decoder_next(d)) != NULL) {
+      // iferret_info_flow.c has nothing to do with these
+      if (op->num >= IFLO_SYS_CALLS_START) continue;
+      flow_put(f, d, op);
+    }
+    decoder_close(d);
+  }
+  flow_hand_over(f);
+  f->decode.usec = flow_usec_since(&start);
+  __sync_synchronize();
+  f->done = TRUE;
+  return NULL;
+}
+
+static void flow_stage_print(char *name, flow_stage_t *st) {
+  double busy = (st->usec > st->nap_usec) ? (st->usec - st->nap_usec) / 1.0e6 : 0;
+
+  printf ("  %-9s %Lu ops in %Lu batches.  %.2f sec, %.2f of them napping (%Lu naps).  %.2f Mops/sec busy\n",
+          name, (unsigned long long) st->ops, (unsigned long long) st->batches,
+          st->usec / 1.0e6, st->nap_usec / 1.0e6, (unsigned long long) st->naps,
+          (busy > 0) ? st->ops / busy / 1.0e6 : 0.0);
+}
+
+// run the logs through info flow, decoding on a thread of its own
+void iferret_info_flow_run(iferret_t *iferret) {
+  flow_t *f;
+  flow_batch_t *b;
+  pthread_t decoder;
+  struct timeval start;
+  uint32_t i;
+
+  f = (flow_t *) calloc(1, sizeof(flow_t));
+  f->batch = (flow_batch_t *) malloc(FLOW_RING_SIZE * sizeof(flow_batch_t));
+  assert (f != NULL && f->batch != NULL);
+  f->iferret = iferret;
+  for (i=0; i<FLOW_RING_SIZE; i++) 
+    f->batch[i].spill = NULL;
+  f->fill = &(f->batch[0]);
+  f->fill->num_ops = f->fill->num_args = f->fill->num_strs = 0;
+  gettimeofday(&start, NULL);
+  if (pthread_create(&decoder, NULL, flow_decode_thread, f) != 0) {
+    printf ("iferret_info_flow_run: can't start decoder thread\n");
+    exit(1);
+  }
+
+  while (1) {
+    if (f->tail == f->head) {
+      if (f->done) {
+        // head is as far as it will go
+        __sync_synchronize();
+        if (f->tail == f->head) break;
+        continue;
+      }
+      flow_nap(&f->propagate);
+      continue;
+    }
+    // don't look in the batch before we've seen head move past it
+    __sync_synchronize();
+    b = &(f->batch[f->tail % FLOW_RING_SIZE]);
+    if (memcmp(ifregaddr, b->ifregaddr, sizeof(b->ifregaddr)) != 0) 
+      memcpy(ifregaddr, b->ifregaddr, sizeof(b->ifregaddr));
+    for (i=0; i<b->num_ops; i++) 
+      iferret_info_flow_process_op(iferret, &(b->op[i]));
+    f->propagate.ops += b->num_ops;
+    f->propagate.batches ++;
+    // done with it before the decoder can have it back
+    __sync_synchronize();
+    f->tail ++;
+  }
+  f->propagate.usec = flow_usec_since(&start);
+  pthread_join(decoder, NULL);
+
+  printf ("info flow: %Lu ops in %.2f sec\n", 
+          (unsigned long long) f->propagate.ops, f->propagate.usec / 1.0e6);
+  flow_stage_print("decode", &f->decode);
+  flow_stage_print("propagate", &f->propagate);
+  iferret_taint_event_finish(iferret->taint_events, stdout);
+  for (i=0; i<FLOW_RING_SIZE; i++) 
+    free(f->batch[i].spill);
+  free(f->batch);
+  free(f);
+}
+
+// Cursors.
+// A cursor walks a trace an op at a time, either way, without loading it.
+// It keeps a window of decoded ops from one chunk.  
+// If the chunk has an index (see Chunk indexes), windows run from one of 
+// its places to start decoding to the next, and we know up front how many 
+// ops it has.  Otherwise windows are CURSOR_WINDOW ops, and we keep a 
+// decoder checkpoint for the start of each one we've been through, so 
+// going back is a restore and a refill.  How many ops the chunk has is 
+// found out the first time we get to its end, so seeking past what's 
+// known decodes forward to find out.
+// Op indices are the ones init() would give.  
+#define CURSOR_WINDOW (1 << 20)
+
+typedef struct iferret_cursor_struct {
+  char *prefix;
+  int start;
+  int num_chunks;
+  // chunk index.  chunk k has ops first[k] .. first[k]+num[k]-1.
+  // first[k] is known for k <= num_known and num[k] for k < num_known.
+  uint64_t *first;
+  uint64_t *num;
+  int num_known;
+  index_t *idx;                 // each chunk's index.  
+  uint8_t *indexed;             // TRUE iff it has one
+  int chunk;                    // chunk being decoded, or -1
+  decoder_t *d;
+  uint64_t dec_op;              // number of chunk's kept ops decoded
+  decoder_ckpt_t *ckpt;         // start of each window of chunk, if no index
+  uint32_t num_ckpt, max_ckpt;
+  op_arr_t *win;
+  uint64_t win_first;           // index of first op in win, or ~0 if none
+  uint64_t pos;                 // op the cursor is at.  ~0 before the first
+  uint8_t *filter;              // op numbers to stop at, or NULL for all
+} iferret_cursor_t;
+
+#define CURSOR_NONE (~((uint64_t) 0))
+
+// chunks with indexes after the last known one are known too
+static void cursor_known(iferret_cursor_t *c) {
+  int k;
+
+  for (k = c->num_known; k < c->num_chunks && c->indexed[k]; k++) {
+    c->num[k] = c->idx[k].h.num_ops;
+    c->first[k+1] = c->first[k] + c->num[k];
+  }
+  c->num_known = k;
+}
+
+iferret_cursor_t *iferret_cursor_open(char *prefix, int start, int num_logs) {
+  char filename[1024];
+  iferret_cursor_t *c;
+  int k;
+
+  c = (iferret_cursor_t *) calloc(1, sizeof(iferret_cursor_t));
+  assert (c != NULL);
+  c->prefix = strdup(prefix);
+  c->start = start;
+  c->num_chunks = num_logs;
+  c->first = (uint64_t *) calloc(num_logs + 1, sizeof(uint64_t));
+  c->num = (uint64_t *) calloc(num_logs + 1, sizeof(uint64_t));
+  c->idx = (index_t *) calloc(num_logs, sizeof(index_t));
+  c->indexed = (uint8_t *) calloc(num_logs, sizeof(uint8_t));
+  for (k=0; k<num_logs; k++) {
+    snprintf(filename, 1024, "%s-%d", prefix, start + k);
+    c->indexed[k] = index_read(&c->idx[k], filename);
+  }
+  cursor_known(c);
+  c->chunk = -1;
+  c->win_first = CURSOR_NONE;
+  c->win = op_arr_init();
+  c->pos = CURSOR_NONE;
+  return c;
+}
+
+void iferret_cursor_close(iferret_cursor_t *c) {
+  int k;
+
+  if (c->d) decoder_close(c->d);
+  free(c->ckpt);
+  for (k=0; k<c->num_chunks; k++) 
+    index_free(&c->idx[k]);
+  free(c->idx);
+  free(c->indexed);
+  op_arr_destroy(c->win);
+  free(c->filter);
+  free(c->first);
+  free(c->num);
+  free(c->prefix);
+  free(c);
+}
+
+// start decoding chunk k from the top
+static void cursor_chunk(iferret_cursor_t *c, int k) {
+  char filename[1024];
+
+  if (c->d) decoder_close(c->d);
+  snprintf(filename, 1024, "%s-%d", c->prefix, c->start + k);
+  c->d = decoder_open(filename);
+  decoder_regs_set(c->d);
+  if (c->indexed[k]) 
+    index_schemas_read(&c->idx[k], filename, c->d);
+  c->chunk = k;
+  c->dec_op = 0;
+  c->num_ckpt = 0;
+  c->win_first = CURSOR_NONE;
+}
+
+// decode the next n kept ops into win.  FALSE if the chunk ends first.
+static int cursor_fill(iferret_cursor_t *c, uint64_t n) {
+  op_arr_t *win = c->win;
+  iferret_op_t *op;
+  int k = c->chunk;
+
+  win->num = 0;
+  win->num_arg = 0;
+  iferret_str_tab_free(&win->str);
+  while (win->num < n && (op = decoder_next(c->d)) != NULL) {
+    if (op_kept(op))
+      op_arr_add(win, op);
+  }
+  c->win_first = c->first[k] + c->dec_op;
+  c->dec_op += win->num;
+  if (win->num == n) return TRUE;
+  if (k == c->num_known) {
+    // now we know how big chunk k is
+    c->num[k] = c->dec_op;
+    c->first[k+1] = c->first[k] + c->num[k];
+    c->num_known ++;
+    cursor_known(c);
+  }
+  return FALSE;
+}
+
+// get op i into win.  FALSE if the trace has no op i.
+static int cursor_load(iferret_cursor_t *c, uint64_t i) {
+  index_ckpt_t *x;
+  index_t *idx;
+  uint64_t j, w;
+  int k, more;
+
+  // usually it's already there
+  if (c->win_first != CURSOR_NONE && i - c->win_first < c->win->num) 
+    return TRUE;
+  while (1) {
+    for (k=0; k<c->num_known; k++) {
+      if (i < c->first[k] + c->num[k]) break;
+    }
+    if (k == c->num_chunks) return FALSE;
+    if (k != c->chunk) cursor_chunk(c, k);
+    j = i - c->first[k];
+
+    if (c->indexed[k]) {
+      // op i is known to be in chunk k.  
+      // start from the index, unless we're there already.
+      idx = &c->idx[k];
+      x = index_ckpt_find(idx, j);
+      if (c->dec_op != x->op) {
+        decoder_seek(c->d, idx, x);
+        c->dec_op = x->op;
+      }
+      cursor_fill(c, ((x + 1 < idx->ckpt + idx->h.num_ckpt) ? x[1].op : c->num[k]) - x->op);
+      return TRUE;
+    }
+
+    w = j / CURSOR_WINDOW;
+    if (w < c->num_ckpt) {
+      decoder_restore(c->d, &c->ckpt[w]);
+      c->dec_op = w * CURSOR_WINDOW;
+    }
+    // otherwise the decoder is at or before window w.  decode up to it.
+    do {
+      if (c->dec_op == (uint64_t) c->num_ckpt * CURSOR_WINDOW) {
+        if (c->num_ckpt == c->max_ckpt) {
+          c->max_ckpt = (c->max_ckpt == 0) ? 4 : 2 * c->max_ckpt;
+          c->ckpt = (decoder_ckpt_t *) realloc(c->ckpt, c->max_ckpt * sizeof(decoder_ckpt_t));
+          assert (c->ckpt != NULL);
+        }
+        decoder_save(c->d, &c->ckpt[c->num_ckpt++]);
+      }
+      more = cursor_fill(c, CURSOR_WINDOW);
+    } while (c->dec_op <= j && more);
+    if (i - c->win_first < c->win->num) 
+      return TRUE;
+    // op i is past the end of chunk k, which is known now.  
+    c->win_first = CURSOR_NONE;
+  }
+}
+
+// go to op i.  FALSE, and the cursor stays where it was, 
+// if there's no such op.  the filter doesn't apply.
+int iferret_cursor_seek(iferret_cursor_t *c, uint64_t i) {
+  if (cursor_load(c, i)) {
+    c->pos = i;
+    return TRUE;
+  }
+  if (c->pos != CURSOR_NONE) 
+    cursor_load(c, c->pos);
+  return FALSE;
+}
+
+static inline int cursor_stop(iferret_cursor_t *c, uint64_t i) {
+  return (c->filter == NULL 
+          || c->filter[c->win->opnum[i - c->win_first]]);
+}
+
+// on to the next op that passes the filter.  
+// FALSE, and the cursor stays where it was, if there isn't one.
+int iferret_cursor_next(iferret_cursor_t *c) {
+  uint64_t i;
+
+  for (i = c->pos + 1; cursor_load(c, i); i++) {
+    if (cursor_stop(c, i)) {
+      c->pos = i;
+      return TRUE;
+    }
+  }
+  if (c->pos != CURSOR_NONE) 
+    cursor_load(c, c->pos);
+  return FALSE;
+}
+
+// back to the previous op that passes the filter.
+int iferret_cursor_prev(iferret_cursor_t *c) {
+  uint64_t i;
+
+  if (c->pos == CURSOR_NONE) return FALSE;
+  for (i = c->pos; i > 0; i--) {
+    cursor_load(c, i - 1);
+    if (cursor_stop(c, i - 1)) {
+      c->pos = i - 1;
+      return TRUE;
+    }
+  }
+  cursor_load(c, c->pos);
+  return FALSE;
+}
+
+// only stop at ops numbered ops[0..n-1].  n == 0 stops at all ops again.
+void iferret_cursor_filter(iferret_cursor_t *c, uint32_t *ops, int n) {
+  int i;
+
+  free(c->filter);
+  c->filter = NULL;
+  if (n == 0) return;
+  c->filter = (uint8_t *) calloc(IFLO_DUMMY_LAST, sizeof(uint8_t));
+  for (i=0; i<n; i++) {
+    if (ops[i] < IFLO_DUMMY_LAST) 
+      c->filter[ops[i]] = TRUE;
+  }
+}
+
+// index of the op the cursor is at, or ~0 if it's before the first.
+uint64_t iferret_cursor_pos(iferret_cursor_t *c) {
+  return c->pos;
+}
+
+// the op the cursor is at is op iferret_cursor_index(c) 
+// of iferret_cursor_store(c).  both change as the cursor moves.
+op_arr_t *iferret_cursor_store(iferret_cursor_t *c) {
+  return c->win;
+}
+
+uint64_t iferret_cursor_index(iferret_cursor_t *c) {
+  return c->pos - c->win_first;
+}
+
+// number of ops in the trace.  has to decode any chunks not yet seen.
+uint64_t iferret_cursor_num(iferret_cursor_t *c) {
+  // there's no op this far in, but we have to go to the end to be sure
+  cursor_load(c, CURSOR_NONE - 1);
+  if (c->pos != CURSOR_NONE) 
+    cursor_load(c, c->pos);
+  return c->first[c->num_chunks];
+}
+
+// give every chunk an index, building any it hasn't got
+static void cursor_index_all(iferret_cursor_t *c) {
+  char filename[1024];
+  int k;
+
+  for (k=0; k<c->num_chunks; k++) {
+    if (c->indexed[k]) continue;
+    snprintf(filename, 1024, "%s-%d", c->prefix, c->start + k);
+    iferret_log_process(NULL, filename);
+    if (!index_read(&c->idx[k], filename)) {
+      printf ("can't index log %s\n", filename);
+      exit(1);
+    }
+    c->indexed[k] = TRUE;
+    // the decoder may already be in it
+    if (k == c->chunk) 
+      index_schemas_read(&c->idx[k], filename, c->d);
+  }
+  cursor_known(c);
+}
+
+// first IFLO_TB_HEAD_EIP op for eip at or after op i, or ~0 if there's none.
+uint64_t iferret_cursor_find_tb(iferret_cursor_t *c, uint32_t eip, uint64_t i) {
+  uint64_t lo, hi, mid, j;
+  index_eip_t *e;
+  index_t *x;
+  int k;
+
+  cursor_index_all(c);
+  for (k=0; k<c->num_chunks; k++) {
+    if (i >= c->first[k+1]) continue;
+    x = &c->idx[k];
+    j = (i > c->first[k]) ? i - c->first[k] : 0;
+    // this eip
+    lo = 0;
+    hi = x->h.num_eip;
+    while (lo < hi) {
+      mid = (lo + hi) / 2;
+      if (x->eip[mid].eip < eip) lo = mid + 1;
+      else hi = mid;
+    }
+    if (lo == x->h.num_eip || x->eip[lo].eip != eip) continue;
+    // its first tb at or after j
+    e = &x->eip[lo];
+    lo = e->first;
+    hi = e->first + e->num;
+    while (lo < hi) {
+      mid = (lo + hi) / 2;
+      if (x->tb[mid] < j) lo = mid + 1;
+      else hi = mid;
+    }
+    if (lo < e->first + e->num) 
+      return c->first[k] + x->tb[lo];
+  }
+  return CURSOR_NONE;
+}
+
+// first op numbered opnum, IFLO_LABEL_INPUT or IFLO_LABEL_OUTPUT, 
+// at or after op i, or ~0 if there's none.
+uint64_t iferret_cursor_find_label(iferret_cursor_t *c, uint32_t opnum, uint64_t i) {
+  uint64_t lo, hi, mid, j;
+  index_t *x;
+  int k;
+
+  cursor_index_all(c);
+  for (k=0; k<c->num_chunks; k++) {
+    if (i >= c->first[k+1]) continue;
+    x = &c->idx[k];
+    j = (i > c->first[k]) ? i - c->first[k] : 0;
+    lo = 0;
+    hi = x->h.num_label;
+    while (lo < hi) {
+      mid = (lo + hi) / 2;
+      if (x->label[mid].op < j) lo = mid + 1;
+      else hi = mid;
+    }
+    for (; lo < x->h.num_label; lo++) {
+      if (x->label[lo].opnum == opnum) 
+        return c->first[k] + x->label[lo].op;
+    }
+  }
+  return CURSOR_NONE;
+}
+
 int main (int argc, char **argv) {
   char  filename[1024];
   int i,j;
   iferret_t *iferret;
   op_arr_t *op_arr;
 
-  op_arr = op_arr_init(); 
-  iferret_log_create();
   iferret = iferret_create();
 
   // process command line options. 
   process_opt(argc,argv,iferret);
 
+  if (iferret->info_flow) {
+    iferret_info_flow_run(iferret);
+    iferret_destroy(iferret);
+    return (0);
+  }
+
   op_arr = init(iferret->log_prefix, iferret->start_log_num, iferret->num_logs);
 
 //  // iterate over logfiles and process each in sequence
@@ -413,6 +2664,7 @@ int main (int argc, char **argv) {
 //  }
 
   op_arr_destroy(op_arr);
+  iferret_destroy(iferret);
 
   return (0);
 }
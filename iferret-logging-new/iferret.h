@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 #include "target-i386/iferret_ops.h"
+#include "iferret_shadow.h"
+#include "iferret_taint_event.h"
 
 typedef struct opcount {
   iferret_log_op_enum_t op_num;
@@ -17,7 +19,10 @@ typedef struct iferret_struct_t {
   uint32_t start_log_num;
   uint32_t num_logs;
   uint8_t first_log;
-  uint8_t if_debug;
+  uint8_t info_flow;            // -f: run the logs through iferret_info_flow.c
+  iferret_shadow_t *shadow;     // labels, for iferret_info_flow.c
+  iferret_taint_event_sink_t *taint_events;     // what iferret_info_flow.c has to report
+  uint64_t last_hd_transfer_from;       // from IFLO_HD_TRANSFER_PART1, for PART2
   
 /*
   uint32_t next_labeling_rule_ind;
@@ -0,0 +1,142 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "iferret_arena.h"
+
+#define IFERRET_ARENA_ALIGN 8
+#define IFERRET_STR_TAB_INIT_SIZE 4096
+
+
+// n bytes, 8-byte aligned, good until the arena is freed
+void *iferret_arena_alloc(iferret_arena_t *a, uint64_t n) {
+  iferret_arena_chunk_t *c;
+  uint64_t size;
+  void *p;
+
+  n = (n + IFERRET_ARENA_ALIGN - 1) & ~((uint64_t) IFERRET_ARENA_ALIGN - 1);
+  c = a->chunk;
+  if (c == NULL || c->used + n > c->size) {
+    // anything too big for a chunk gets one of its own
+    size = (n > IFERRET_ARENA_CHUNK_SIZE) ? n : IFERRET_ARENA_CHUNK_SIZE;
+    c = (iferret_arena_chunk_t *) malloc(sizeof(iferret_arena_chunk_t) + size);
+    assert (c != NULL);
+    c->size = size;
+    c->used = 0;
+    c->next = a->chunk;
+    a->chunk = c;
+  }
+  p = ((char *) (c + 1)) + c->used;
+  c->used += n;
+  return p;
+}
+
+void iferret_arena_free(iferret_arena_t *a) {
+  iferret_arena_chunk_t *c, *next;
+
+  for (c = a->chunk; c != NULL; c = next) {
+    next = c->next;
+    free(c);
+  }
+  a->chunk = NULL;
+}
+
+// take over all of from's memory.  from is left empty.
+// a keeps allocating from its current chunk.
+void iferret_arena_adopt(iferret_arena_t *a, iferret_arena_t *from) {
+  iferret_arena_chunk_t *c;
+
+  if (from->chunk == NULL) return;
+  if (a->chunk == NULL) {
+    a->chunk = from->chunk;
+  }
+  else {
+    for (c = from->chunk; c->next != NULL; c = c->next);
+    c->next = a->chunk->next;
+    a->chunk->next = from->chunk;
+  }
+  from->chunk = NULL;
+}
+
+
+// FNV-1a
+static inline uint64_t iferret_str_hash(char *str) {
+  uint64_t h = 14695981039346656037ULL;
+  while (*str) {
+    h ^= (uint8_t) *str++;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+static void iferret_str_tab_grow(iferret_str_tab_t *t) {
+  char **old;
+  uint64_t old_size, i, j;
+
+  old = t->slot;
+  old_size = t->size;
+  t->size = (old_size == 0) ? IFERRET_STR_TAB_INIT_SIZE : 2 * old_size;
+  t->slot = (char **) calloc(t->size, sizeof(char *));
+  assert (t->slot != NULL);
+  for (i=0; i<old_size; i++) {
+    if (old[i] == NULL) continue;
+    for (j = iferret_str_hash(old[i]) & (t->size - 1); t->slot[j] != NULL; j = (j + 1) & (t->size - 1));
+    t->slot[j] = old[i];
+  }
+  free(old);
+}
+
+// the one copy of str.
+char *iferret_str_intern(iferret_str_tab_t *t, char *str) {
+  uint64_t j, n;
+  char *s;
+
+  // keep it at most half full
+  if (2 * (t->num + 1) > t->size) {
+    iferret_str_tab_grow(t);
+  }
+  for (j = iferret_str_hash(str) & (t->size - 1); t->slot[j] != NULL; j = (j + 1) & (t->size - 1)) {
+    if (strcmp(t->slot[j], str) == 0) {
+      return t->slot[j];
+    }
+  }
+  n = strlen(str) + 1;
+  s = (char *) iferret_arena_alloc(&t->arena, n);
+  memcpy(s, str, n);
+  t->slot[j] = s;
+  t->num ++;
+  return s;
+}
+
+void iferret_str_tab_free(iferret_str_tab_t *t) {
+  iferret_arena_free(&t->arena);
+  free(t->slot);
+  t->slot = NULL;
+  t->size = 0;
+  t->num = 0;
+}
+
+// take over from's strings, which stay where they are.
+// any that t already has are kept too, but only t's copy is interned.
+void iferret_str_tab_adopt(iferret_str_tab_t *t, iferret_str_tab_t *from) {
+  uint64_t i, j;
+  char *s;
+
+  for (i=0; i<from->size; i++) {
+    s = from->slot[i];
+    if (s == NULL) continue;
+    if (2 * (t->num + 1) > t->size) {
+      iferret_str_tab_grow(t);
+    }
+    for (j = iferret_str_hash(s) & (t->size - 1); t->slot[j] != NULL; j = (j + 1) & (t->size - 1)) {
+      if (strcmp(t->slot[j], s) == 0) break;
+    }
+    if (t->slot[j] == NULL) {
+      t->slot[j] = s;
+      t->num ++;
+    }
+  }
+  iferret_arena_adopt(&t->arena, &from->arena);
+  iferret_str_tab_free(from);
+}
@@ -0,0 +1,42 @@
+#ifndef __IFERRET_ARENA_H_
+#define __IFERRET_ARENA_H_
+
+#include <stdint.h>
+
+// Arenas, for the back end's op store.
+// Memory is handed out by bumping a pointer through big chunks
+// and only ever given back all at once, a chunk at a time.
+
+#define IFERRET_ARENA_CHUNK_SIZE (16 << 20)
+
+typedef struct iferret_arena_chunk_struct_t {
+  struct iferret_arena_chunk_struct_t *next;   // older chunks
+  uint64_t size;
+  uint64_t used;
+} iferret_arena_chunk_t;
+
+typedef struct iferret_arena_struct_t {
+  iferret_arena_chunk_t *chunk;  // current chunk
+} iferret_arena_t;
+
+void *iferret_arena_alloc(iferret_arena_t *a, uint64_t n);
+void iferret_arena_free(iferret_arena_t *a);
+void iferret_arena_adopt(iferret_arena_t *a, iferret_arena_t *from);
+
+
+// Interned strings.
+// Each distinct string is stored once, in an arena, so equal strings
+// have equal pointers and they all go away together.
+// (Tables adopted from elsewhere may bring along copies of some.)
+typedef struct iferret_str_tab_struct_t {
+  iferret_arena_t arena;
+  char **slot;                  // open addressing.  NULL means empty
+  uint64_t size;                // number of slots, a power of 2
+  uint64_t num;                 // number of strings
+} iferret_str_tab_t;
+
+char *iferret_str_intern(iferret_str_tab_t *t, char *str);
+void iferret_str_tab_free(iferret_str_tab_t *t);
+void iferret_str_tab_adopt(iferret_str_tab_t *t, iferret_str_tab_t *from);
+
+#endif
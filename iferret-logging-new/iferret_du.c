@@ -0,0 +1,61 @@
+#include <stdint.h>
+
+#include "iferret_du.h"
+#include "target-i386/iferret_ops.h"
+#include "target-i386/iferret_du_table.h"
+
+
+// slot for the env field at offset off: the last one starting at or before it
+static inline uint32_t iferret_du_env(uint64_t off) {
+  uint32_t lo = 0, hi = iferret_du_env_num, m;
+
+  while (lo < hi) {
+    m = (lo + hi) / 2;
+    if (iferret_du_env_off[m] <= off) lo = m + 1;
+    else hi = m;
+  }
+  // off is never before the first, which starts at 0
+  return iferret_du_env_slot[(lo == 0) ? 0 : lo - 1];
+}
+
+// the locations d stands for in an op with these args: lo..hi-1.
+// 0 if it's none.
+int iferret_du_range(iferret_du_t *d, uint64_t *args, uint32_t num_args,
+                     uint64_t *lo, uint64_t *hi) {
+  uint64_t v;
+
+  if (d->guard != IFERRET_DU_GUARD_NONE) {
+    if (d->guard_arg >= num_args) return 0;
+    v = args[d->guard_arg];
+    if ((v != (uint64_t) d->guard_val) != (d->guard == IFERRET_DU_GUARD_NE)) return 0;
+  }
+  if (d->what == IFERRET_DU_IS_SLOT) {
+    *lo = IFERRET_DU_SLOT(d->slot);
+    *hi = *lo + 1;
+    return 1;
+  }
+  if (d->arg >= num_args) return 0;
+  v = args[d->arg];
+  switch (d->what) {
+    case IFERRET_DU_IS_SLOT_ARG:
+      if (v >= d->num) return 0;
+      *lo = IFERRET_DU_SLOT(d->slot + v);
+      *hi = *lo + 1;
+      return 1;
+    case IFERRET_DU_IS_ENV:
+      *lo = IFERRET_DU_SLOT(iferret_du_env(v));
+      *hi = *lo + 1;
+      return 1;
+    case IFERRET_DU_IS_MEM:
+      *lo = v;
+      if (d->size_arg == IFERRET_DU_NO_SIZE_ARG) {
+        *hi = *lo + d->num;
+      }
+      else {
+        if (d->size_arg >= num_args) return 0;
+        *hi = *lo + (((uint64_t) 1) << (args[d->size_arg] & 63));
+      }
+      return 1;
+  }
+  return 0;
+}
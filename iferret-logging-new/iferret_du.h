@@ -0,0 +1,71 @@
+#ifndef __IFERRET_DU_H_
+#define __IFERRET_DU_H_
+
+#include <stdint.h>
+
+// What each info-flow op defines and uses.
+// This is qemu_data.defines_uses (in dynslicer) as a static table, which
+// dynslicer/make_du_table.py generates as target-i386/iferret_du_table.h.
+// Locations are 64-bit ids.  A byte of memory is its address, and
+// anything else (registers, flags, env fields, ...) is IFERRET_DU_SLOT(n),
+// numbered as in iferret_du_slots.
+// An op has a run of descriptors in iferret_du, first for what it
+// defines and then for what it uses.  A descriptor is a fixed slot, or
+// says which of the op's args has the register number, env offset or
+// address (and size) in it.  It can also be guarded, so it only counts
+// when some arg is or isn't some value.
+
+#define IFERRET_DU_SLOT(n) ((((uint64_t) 1) << 40) + (n))
+
+// what a descriptor is
+#define IFERRET_DU_IS_SLOT      0    // slot
+#define IFERRET_DU_IS_SLOT_ARG  1    // slot + arg, if arg < num
+#define IFERRET_DU_IS_ENV       2    // the env field at offset arg
+#define IFERRET_DU_IS_MEM       3    // num bytes at arg, or 1 << (arg size_arg)
+
+// and when it counts
+#define IFERRET_DU_GUARD_NONE   0
+#define IFERRET_DU_GUARD_NE     1    // arg guard_arg != guard_val
+#define IFERRET_DU_GUARD_EQ     2
+
+#define IFERRET_DU_NO_SIZE_ARG 0xff
+
+// most descriptors an op can have
+#define IFERRET_DU_MAX 64
+
+typedef struct iferret_du_struct_t {
+  uint8_t what;
+  uint8_t arg;
+  uint8_t size_arg;             // IFERRET_DU_NO_SIZE_ARG if the size is num
+  uint8_t guard;
+  uint8_t guard_arg;
+  uint32_t guard_val;
+  uint32_t slot;
+  uint32_t num;
+} iferret_du_t;
+
+typedef struct iferret_op_du_struct_t {
+  uint32_t off;                 // where its descriptors start in iferret_du
+  uint16_t num_def, num_use;
+  uint8_t known;                // 0 if the table doesn't say.  either 
+                                // defines_uses doesn't have the op, or 
+                                // make_du_table.py couldn't follow it.
+} iferret_op_du_t;
+
+// a slot, or a run of n slots for the names fmt % 0..n-1
+typedef struct iferret_du_slot_struct_t {
+  char *name;
+  uint32_t n;
+} iferret_du_slot_t;
+
+extern iferret_du_t iferret_du[];
+extern iferret_op_du_t iferret_op_du[];   // by opnum
+extern iferret_du_slot_t iferret_du_slots[];
+extern uint32_t iferret_du_num_slots;
+extern uint32_t iferret_du_env_off[], iferret_du_env_slot[];
+extern uint32_t iferret_du_env_num;
+
+int iferret_du_range(iferret_du_t *d, uint64_t *args, uint32_t num_args,
+                     uint64_t *lo, uint64_t *hi);
+
+#endif
@@ -0,0 +1,95 @@
+// Writes a small format 2 trace for checking the offline info flow
+// (oiferret -f) end to end.  See Makefile-flowcheck.
+//
+// Two tbs.  "send" just sends T0 out the network.  "infect" labels T0
+// from the network, clears it, and gets the label back from memory via
+// T1.  then it passes T0 through EBX to A0, so that a load goes through
+// a tainted pointer, copies T0 to the hard drive and sends it.  send
+// runs 100 times before infect and 10 times after, so info flow should
+// report 11 exfiltrations, one tainted hard drive write and one tainted
+// pointer.
+//
+// Usage: iferret_flow_check LOG_PREFIX
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "iferret_log.h"
+
+// the front end's, which the log writer wants
+unsigned int phys_ram_size = 64 * 1024 * 1024;
+uint8_t *phys_ram_base;
+uint32_t iferret_target_os;
+
+extern char *iferret_log_prefix;
+extern uint8_t iferret_info_flow;
+extern uint64_t ifregaddr[];
+
+// as in target-i386/helper.c
+static void iferret_tb_enter(uint32_t schema) {
+  iferret_tb_schema_t *s;
+
+  iferret_log_tb_leave_check();
+  s = iferret_log_tb_schema_get(schema);
+  if (s->epoch != iferret_log_tb_epoch) {
+    iferret_log_op_write_41(IFLO_TB_SCHEMA, schema, 0);
+    iferret_log_tb_learn(s);
+  }
+  else if (s->num_ops > 0) {
+    iferret_log_op_write_41(IFLO_TB_INSTANCE, schema, 0);
+    iferret_log_tb_instance(s);
+  }
+}
+
+static void send_tb(uint32_t schema) {
+  iferret_log_op_write_4(IFLO_TB_HEAD_EIP, 0x8048000);
+  iferret_tb_enter(schema);
+  iferret_log_info_flow_op_write_0(IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_LONG_T0);
+}
+
+static void infect_tb(uint32_t schema) {
+  iferret_log_op_write_4(IFLO_TB_HEAD_EIP, 0x8049000);
+  iferret_tb_enter(schema);
+  iferret_log_info_flow_op_write_4(IFLO_OPS_TEMPLATE_NETWORK_INPUT_LONG_T0, 0x50);
+  iferret_log_info_flow_op_write_1444444(IFLO_OPS_MEM_STL_T0_A0, 2, 0x2000, 0xbfff2000, 0, 0, 0, 0x41414141);
+  iferret_log_info_flow_op_write_4(IFLO_MOVL_T0_IM, 0);
+  iferret_log_info_flow_op_write_4(IFLO_MOVL_A0_IM, 0x3000);
+  iferret_log_info_flow_op_write_1444444(IFLO_OPS_MEM_LDL_T1_A0, 2, 0x2000, 0xbfff2000, 0, 0, 0, 0x41414141);
+  iferret_log_info_flow_op_write_0(IFLO_MOVL_T0_T1);
+  iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_R_T0, IFRN_EBX);
+  iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_A0_R, IFRN_EBX);
+  iferret_log_info_flow_op_write_1444444(IFLO_OPS_MEM_LDL_T1_A0, 2, 0x4000, 0xbfff4000, 0, 0, 0, 0);
+  iferret_log_info_flow_op_write_0(IFLO_HD_TRANSFER_PART1_T0_BASE);
+  iferret_log_info_flow_op_write_81(IFLO_HD_TRANSFER_PART2, HD_BASE_ADDR + 0x200, 4);
+  iferret_log_info_flow_op_write_0(IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_LONG_T0);
+}
+
+int main(int argc, char **argv) {
+  uint32_t send, infect;
+  int i;
+
+  if (argc != 2) {
+    printf ("Usage: iferret_flow_check LOG_PREFIX\n");
+    exit(1);
+  }
+  // somewhere for the registers that isn't ram or the hard drive
+  for (i=0; i<=IFRN_Q4; i++)
+    ifregaddr[i] = 0x555555550000ULL + 8*i;
+  iferret_info_flow = 1;
+  iferret_log_prefix = argv[1];
+  iferret_log_codec_select("none");
+  iferret_log_create();
+  send = iferret_log_tb_schema_new();
+  infect = iferret_log_tb_schema_new();
+  for (i=0; i<100; i++)
+    send_tb(send);
+  infect_tb(infect);
+  for (i=0; i<10; i++)
+    send_tb(send);
+  iferret_log_tb_leave_check();
+  iferret_log_rollup("flowcheck");
+  iferret_log_sync();
+  return 0;
+}
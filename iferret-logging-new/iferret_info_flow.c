@@ -4,7 +4,9 @@
 #include <time.h>
 #include "iferret_log.h"
 #include "iferret_info_flow.h"
+#ifdef QAINT
 #include "taint.h"
+#endif
 
 
 extern uint64_t ifregaddr[];
@@ -14,8 +16,6 @@ extern uint64_t phys_ram_base;
 
 extern uint8_t iferret_debug;
 
-uint8_t if_debug=0;
-
 #define EAX_BASE ifregaddr[IFRN_EAX]
 #define ECX_BASE ifregaddr[IFRN_ECX]
 #define EDX_BASE ifregaddr[IFRN_EDX]
@@ -80,10 +80,6 @@ uint8_t if_reg_taint[32] = {
 struct timeval last_time;
 
 
-void squeal_about_exfiltration() {
-  printf ("exfiltration\n");
-}
-
 char *if_reg_str(int if_regnum) {
   return (info_flow_reg_str[if_regnum]);
 }
@@ -102,81 +98,6 @@ double timer_time () {
 }
 
 
-void if_debug_set(int l) {
-  if_debug = l;
-}
-
-
-void if_debug_set_off() {
-  if_debug = IF_DEBUG_OFF;
-}
-
-
-void if_debug_set_low() {
-  if_debug = IF_DEBUG_LOW;
-}
-
-
-void if_debug_set_med() {
-  if_debug = IF_DEBUG_MED;
-}
-
-
-void if_debug_set_high() {
-  if_debug = IF_DEBUG_HIGH;
-}
-
-
-void if_debug_set_omg() {
-  if_debug = IF_DEBUG_OMG;
-}
-
-
-uint8_t debug_off() {
-  return (if_debug == IF_DEBUG_OFF);
-}
-
-
-uint8_t debug_low() {
-  return (if_debug <= IF_DEBUG_LOW);
-}
-
-
-uint8_t debug_med() {
-  return (if_debug <= IF_DEBUG_MED);
-}
-
-
-uint8_t debug_high() {
-  return (if_debug <= IF_DEBUG_HIGH);
-}
-
-
-uint8_t debug_omg() {
-  return (if_debug <= IF_DEBUG_OMG);
-}
-
-
-uint8_t debug_at_least_low() {
-  return (if_debug >= IF_DEBUG_LOW);
-}
-
-
-uint8_t debug_at_least_med() {
-  return (if_debug >= IF_DEBUG_MED);
-}
-
-
-uint8_t debug_at_least_high() {
-  return (if_debug >= IF_DEBUG_HIGH);
-}
-
-
-uint8_t debug_at_least_omg() {
-  return (if_debug >= IF_DEBUG_OMG);
-}
-
-
 // p is an address that came out of the log.  
 // or it might be a fake address, like a register.
 // decide which and print something approriate. 
@@ -326,18 +247,14 @@ inline uint8_t qaint_exists(uint64_t p, size_t n) {
 #define __info_flow_compute qaint_compute
 #endif
 
-#ifdef OTAINT
-#define __info_flow_label(p,n,l)          shad_label(iferret->shadow, p, n, l)
-#define __info_flow_add_label(p,n,l)      shad_add_label(iferret->shadow, p, n, l)
-#define __info_flow_delete(p,n)           shad_delete(iferret->shadow, p, n)
-#define __info_flow_exists(p,n)           shad_exists(iferret->shadow, p, n)
-// NB: __info_flow_copy and __info_flow_compute have p1=dest and p2=src
-// whereas shad_copy and shad_compute reverse the order.  
-#define __info_flow_copy(p1,p2,n)         shad_copy(iferret->shadow, p2, p1, n)
-#define __info_flow_compute(p1,p2,n1,n2)  shad_compute(iferret->shadow, p2, p1, n2, n1) 
-#define TRUE 1
-#define FALSE 0
-
+#ifndef QAINT
+// the shadow store in iferret_shadow.c
+#define __info_flow_label(p,n,l)          iferret_shadow_label(iferret->shadow, p, n, l)
+#define __info_flow_add_label(p,n,l)      iferret_shadow_add_label(iferret->shadow, p, n, l)
+#define __info_flow_delete(p,n)           iferret_shadow_delete(iferret->shadow, p, n)
+#define __info_flow_exists(p,n)           iferret_shadow_exists(iferret->shadow, p, n)
+#define __info_flow_copy(p1,p2,n)         iferret_shadow_copy(iferret->shadow, p1, p2, n)
+#define __info_flow_compute(p1,p2,n1,n2)  iferret_shadow_compute(iferret->shadow, p1, n1, p2, n2)
 #endif
 
 
@@ -349,29 +266,58 @@ inline uint8_t qaint_exists(uint64_t p, size_t n) {
 }
 
 
+// label set of the first tainted byte in (p,p+n-1), for a taint event
+static uint32_t info_flow_first_set(iferret_t *iferret, uint64_t p, size_t n) {
+#ifdef QAINT
+  return 0;
+#else
+  uint32_t id;
+  size_t i;
+
+  for (i=0; i<n; i++) {
+    if ((id = iferret_shadow_get(iferret->shadow, p+i)) != 0)
+      return id;
+  }
+  return 0;
+#endif
+}
+
+
+// tell whoever is listening.  this is just a record into a ring;
+// formatting it is someone else's job (iferret_taint_event.h)
+static void info_flow_event(iferret_t *iferret, iferret_taint_event_kind_t kind, 
+                            uint64_t p, uint64_t p2, size_t n) {
+  iferret_taint_event_put(iferret->taint_events, kind, p, p2, n, 
+                          info_flow_first_set(iferret, p, n));
+}
+
+
+static void squeal_about_exfiltration(iferret_t *iferret, uint64_t p, size_t n) {
+  info_flow_event(iferret, IFERRET_TAINT_EVENT_EXFILTRATION, p, 0, n);
+}
+
+
+// NB: these don't check_addr / check_size.  an address that came out
+// of the log gets checked once, by the handler for the op it came in;
+// everything else is an ifregaddr slot.
+
 // delete info-flow for (p,p+n-1)
  void info_flow_delete(iferret_t *iferret, uint64_t p, size_t n) {
-  if (check_addr(p) && check_size(n)) {
-    __info_flow_delete(p,n);
-    //    shad_delete(iferret->shadow, p, n);
-    assert ((__info_flow_exists(p,n)) == 0);
-  }
+  __info_flow_delete(p,n);
+  //    shad_delete(iferret->shadow, p, n);
+  assert ((__info_flow_exists(p,n)) == 0);
 }
 
 
 
 // copy of (p2,p2+n-1) to (p1,p1+n-1)
  void info_flow_copy(iferret_t *iferret, uint64_t p1,uint64_t p2, size_t n) {
-  uint8_t pbt=0;
-  if (check_addr(p1) && check_addr(p2) && check_size(n)) {
-    __info_flow_copy(p1, p2, n);
-    //shad_spit_range_nonl(iferret->shadow,p2,p2+n-1);
-    //shad_spit(iferret->shadow);
-    //iferret_spit_op(iferret->current_op);
-    fflush(stdout);
-    if (p1 >= HD_BASE_ADDR && (__info_flow_exists(p1,n))) {
-      printf ("iferret_info_flow we have a tainted hard drive.\n");
-    }
+  __info_flow_copy(p1, p2, n);
+  //shad_spit_range_nonl(iferret->shadow,p2,p2+n-1);
+  //shad_spit(iferret->shadow);
+  //iferret_spit_op(iferret->current_op);
+  if (p1 >= HD_BASE_ADDR && (__info_flow_exists(p1,n))) {
+    info_flow_event(iferret, IFERRET_TAINT_EVENT_HD_WRITE, p1, p2, n);
   }
 }
 
@@ -380,35 +326,27 @@ inline uint8_t qaint_exists(uint64_t p, size_t n) {
 // the destination (p1) can increase or remain the same.  
 // from (p2,p2+n2-1) to (p1,p1+n1-1)
  void info_flow_compute(iferret_t *iferret, uint64_t p1, size_t n1, uint64_t p2, size_t n2) {
-  uint8_t pbt=0;
-  if (check_addr(p1) && check_addr(p2) && check_size(n1) && check_size(n2)) {
-    __info_flow_compute(p1, p2, n1, n2);
-    //shad_spit_range_nonl(iferret->shadow,p2,p2+n2-1);
-    //shad_spit(iferret->shadow);
-    //iferret_spit_op(iferret->current_op);
-    fflush(stdout);
-    if (p1 >= HD_BASE_ADDR && (__info_flow_exists(p1,n1))) {
-      printf ("iferret_info_flow we have a tainted hard drive.\n");
-    }
+  __info_flow_compute(p1, p2, n1, n2);
+  //shad_spit_range_nonl(iferret->shadow,p2,p2+n2-1);
+  //shad_spit(iferret->shadow);
+  //iferret_spit_op(iferret->current_op);
+  if (p1 >= HD_BASE_ADDR && (__info_flow_exists(p1,n1))) {
+    info_flow_event(iferret, IFERRET_TAINT_EVENT_HD_WRITE, p1, p2, n1);
   }
 }
 
 
 void info_flow_label(iferret_t *iferret, uint64_t p, size_t n, char *label) {
-  if (check_addr(p) && check_size(n)) {
-    //    printf ("info_flow_label: (%llx,%d) %s\n", ctull(p), (int)n,label);
-    //    label_taint(wctull(p),n,label,"NONE",-1);
-    __info_flow_label(p, n, label);
-  }
+  //    printf ("info_flow_label: (%llx,%d) %s\n", ctull(p), (int)n,label);
+  //    label_taint(wctull(p),n,label,"NONE",-1);
+  __info_flow_label(p, n, label);
 }
 
 
 void info_flow_add_label(iferret_t *iferret, uint64_t p, size_t n, char *label) {
-  if (check_addr(p) && check_size(n)) {
-    printf ("info_flow_add_label: (%llx,%d) %s\n", ctull(p), (int)n,label);
-    //    label_taint(wctull(p),n,label,"NONE",-1);
-    __info_flow_add_label(p, n, label);
-  }
+  printf ("info_flow_add_label: (%llx,%d) %s\n", ctull(p), (int)n,label);
+  //    label_taint(wctull(p),n,label,"NONE",-1);
+  __info_flow_add_label(p, n, label);
 }
 
 
@@ -441,7 +379,8 @@ inline void info_flow_add_label(uint64_t p, size_t n, char *label) {
 */
 inline void info_flow_ld(iferret_t *iferret, uint64_t p1, uint64_t p2, size_t n, uint8_t u) {
 
-  if (iferret->if_debug == TRUE) {
+#if IF_DEBUG >= IF_DEBUG_LOW
+  {
     uint8_t from_range_tainted = FALSE;
     uint8_t to_range_tainted = FALSE;
     if (info_flow_exists(iferret,p2,n)) {
@@ -455,6 +394,7 @@ inline void info_flow_ld(iferret_t *iferret, uint64_t p1, uint64_t p2, size_t n,
 	      ctull(p2), ctull(p1), n, from_range_tainted, to_range_tainted);
     }	      
   }
+#endif
 
   /* BDG: Do we want to add in the input source labeling here? */
   //char label[256];
@@ -479,7 +419,8 @@ inline void info_flow_ld(iferret_t *iferret, uint64_t p1, uint64_t p2, size_t n,
 // store the low n bytes of that register at location p2.  
 inline void info_flow_st(iferret_t *iferret, uint64_t p1, uint64_t p2, size_t n) {
 
-  if (iferret->if_debug == TRUE) {
+#if IF_DEBUG >= IF_DEBUG_LOW
+  {
     uint8_t from_range_tainted = FALSE;
     uint8_t to_range_tainted = FALSE;
     if (info_flow_exists(iferret,p1,n)) {
@@ -493,6 +434,7 @@ inline void info_flow_st(iferret_t *iferret, uint64_t p1, uint64_t p2, size_t n)
 	      ctull(p1), ctull(p2), n, from_range_tainted, to_range_tainted);
     }	      
   }
+#endif
 
 
   assert (n<=4);
@@ -511,7 +453,8 @@ inline void info_flow_st(iferret_t *iferret, uint64_t p1, uint64_t p2, size_t n)
 // if we delete for all 4 byts, then we can set the big falg.
 inline void if_delete_reg_aux (iferret_t *iferret, uint32_t rn, uint32_t o, uint32_t n) {
 
-  if (iferret->if_debug == TRUE) {
+#if IF_DEBUG >= IF_DEBUG_LOW
+  {
     uint64_t p = ifregaddr[rn] + o;
     printf ("if_delete_reg_aux %s\n", if_reg_str(rn));
     if (info_flow_exists(iferret,p,n)) {
@@ -519,6 +462,7 @@ inline void if_delete_reg_aux (iferret_t *iferret, uint32_t rn, uint32_t o, uint
 	      rn, if_reg_str(rn), ctull(p), o, n);
     }
   }    
+#endif
 
   // only bother if reg *may* be tainted 
   if (info_flow_possibly_tainted(rn)) {		
@@ -561,7 +505,8 @@ inline void if_delete_r1(iferret_t *iferret, uint32_t rn) {
 // rn2 is source
 inline void if_copy_regs_aux (iferret_t *iferret, uint32_t rn1, uint32_t o1, uint32_t rn2, uint32_t o2, uint32_t n) {
 
-  if (iferret->if_debug == TRUE) {
+#if IF_DEBUG >= IF_DEBUG_LOW
+  {
     uint64_t p1, p2;
     uint8_t from_range_tainted = FALSE;
     uint8_t to_range_tainted = FALSE;
@@ -582,6 +527,7 @@ inline void if_copy_regs_aux (iferret_t *iferret, uint32_t rn1, uint32_t o1, uin
 	      from_range_tainted, to_range_tainted);
     }	      
   }
+#endif
     
 
   if (info_flow_possibly_tainted(rn2)) {  
@@ -634,7 +580,8 @@ inline void if_compute_regs_aux (iferret_t *iferret,
 				 uint32_t rn1, uint32_t o1, uint32_t n1, 
 				 uint32_t rn2, uint32_t o2, uint32_t n2) {
 
-  if (iferret->if_debug == TRUE) {
+#if IF_DEBUG >= IF_DEBUG_LOW
+  {
     uint64_t p1, p2;
     uint8_t from_range_tainted = FALSE;
     uint8_t to_range_tainted = FALSE;
@@ -655,6 +602,7 @@ inline void if_compute_regs_aux (iferret_t *iferret,
 	      );
     }	      
   }
+#endif
 
   if (info_flow_possibly_tainted(rn2)) { 
     info_flow_compute(iferret,ifregaddr[rn1]+o1,n1,ifregaddr[rn2]+o2,n2); 
@@ -690,7 +638,8 @@ inline void if_compute_r1(iferret_t *iferret, uint32_t rn1, uint32_t rn2) {
 inline void if_self_compute_regs_aux(iferret_t *iferret, uint32_t rn1, uint32_t rn2, uint32_t n) {
   uint8_t r1pt, r2pt;
 
-  if (iferret->if_debug == TRUE) {
+#if IF_DEBUG >= IF_DEBUG_LOW
+  {
     uint64_t p1, p2;
     uint8_t from_range_tainted = FALSE;
     uint8_t to_range_tainted = FALSE;
@@ -711,6 +660,7 @@ inline void if_self_compute_regs_aux(iferret_t *iferret, uint32_t rn1, uint32_t
 	      from_range_tainted, to_range_tainted);
     }	      
   }
+#endif
 
   r1pt = info_flow_possibly_tainted(rn1);
   r2pt = info_flow_possibly_tainted(rn2);  
@@ -750,14 +700,18 @@ inline void if_self_compute_r1(iferret_t *iferret, uint32_t rn1, uint32_t rn2) {
   i.e. Q0 = R + 1;  R = Q0;
 */
 inline void if_inc_r4(iferret_t *iferret, uint32_t rn) {
-  if (iferret->if_debug) printf ("if_inc_r4 %s\n", if_reg_str(rn));
-  if (iferret->if_debug == TRUE) {
+#if IF_DEBUG >= IF_DEBUG_HIGH
+  printf ("if_inc_r4 %s\n", if_reg_str(rn));
+#endif
+#if IF_DEBUG >= IF_DEBUG_LOW
+  {
     uint64_t p1 = ifregaddr[rn];
     if (info_flow_exists(iferret,p1,4)) {
       printf ("if_inc_r4 %d %llx was tainted.\n",
 	      rn, ctull(p1));
     }
   }
+#endif
   if (info_flow_possibly_tainted(rn)) {		
     if_delete_r4(iferret,IFRN_Q0); 
     if_compute_r4(iferret,IFRN_Q0,rn); 
@@ -781,9 +735,11 @@ inline void if_ld(iferret_t *iferret, uint32_t msn, uint32_t rn, uint32_t n, uin
   //  assert (msn != UNINITIALIZED); 
   //  assert (rn != UNINITIALIZED); 
   //  assert (p != (char *) UNINITIALIZED);	
-  if (iferret->if_debug) printf ("if_ld %s\n", if_reg_str(rn));
+#if IF_DEBUG >= IF_DEBUG_HIGH
+  printf ("if_ld %s\n", if_reg_str(rn));
+#endif
   //p += phys_ram_base;
-  if (p == 0)
+  if (p == 0 || !check_addr(p))
     return;
   info_flow_ld(iferret,ifregaddr[rn], p, n, u);	
   // assume rn might now be tainted.  
@@ -793,13 +749,17 @@ inline void if_ld(iferret_t *iferret, uint32_t msn, uint32_t rn, uint32_t n, uin
 
 // read n bytes from p and put them in register rn. 
 inline void if_ldu(iferret_t *iferret, uint32_t msn, uint32_t rn, uint32_t n, uint64_t p) {
-  if (iferret->if_debug) printf ("if_ldu %s\n", if_reg_str(rn));
+#if IF_DEBUG >= IF_DEBUG_HIGH
+  printf ("if_ldu %s\n", if_reg_str(rn));
+#endif
   if_ld(iferret,msn,rn,n,TRUE,p);
 }
 
 
 inline void if_lds(iferret_t *iferret, uint32_t msn, uint32_t rn, uint32_t n, uint64_t p) {
-  if (iferret->if_debug)  printf ("if_lds %s\n", if_reg_str(rn));
+#if IF_DEBUG >= IF_DEBUG_HIGH
+  printf ("if_lds %s\n", if_reg_str(rn));
+#endif
   if_ld(iferret,msn,rn,n,FALSE,p);
 }
 
@@ -811,11 +771,9 @@ inline void if_lds(iferret_t *iferret, uint32_t msn, uint32_t rn, uint32_t n, ui
 // it is, we propagate its labels to the dest_addr.
 inline void if_tainted_ptr(iferret_t *iferret, uint64_t dest_addr, uint64_t ptr_addr, uint32_t n) {
   if (info_flow_exists(iferret,ptr_addr, 4)) {
-    if (iferret->if_debug == TRUE) {
-      printf ("if_tainted_ptr dest_addr=%llx ptr_addr=%llx n=%d ptr is tainted.\n",
-	      ctull(dest_addr), ctull(ptr_addr), n);
-    }
     info_flow_compute(iferret,dest_addr, n, ptr_addr, 4);
+    // after, so the event has the pointer's labels
+    info_flow_event(iferret, IFERRET_TAINT_EVENT_TAINTED_PTR, dest_addr, ptr_addr, n);
   }
 }
 
@@ -825,9 +783,11 @@ inline void if_tainted_ptr(iferret_t *iferret, uint64_t dest_addr, uint64_t ptr_
 // i.e. 0 is first byte and 512* 1MB is last byte of a 512 MB system.  
 // msn is memory suffix number. 
 inline void if_st(iferret_t *iferret, uint32_t msn, uint32_t rn, uint32_t n, uint64_t p) {
-  if (p == 0) 
+  if (p == 0 || !check_addr(p))
     return;  
-  if (iferret->if_debug) printf ("if_st %s \n", if_reg_str(rn));
+#if IF_DEBUG >= IF_DEBUG_HIGH
+  printf ("if_st %s \n", if_reg_str(rn));
+#endif
   //p += phys_ram_base;
   if (info_flow_possibly_tainted(rn)) {		
     // note: no way to *mark* an address as possibly tainted.  
@@ -858,6 +818,30 @@ inline void if_st(iferret_t *iferret, uint32_t msn, uint32_t rn, uint32_t n, uin
   assert (op->num_args == 2 && op->arg[0].type == IFLAT_UI8 \
 	  && op->arg[1].type == IFLAT_UI32);
 
+#define assert_args_41(op) \
+  assert (op->num_args == 2 && op->arg[0].type == IFLAT_UI32 \
+	  && op->arg[1].type == IFLAT_UI8);
+
+#define assert_args_44(op) \
+  assert (op->num_args == 2 && op->arg[0].type == IFLAT_UI32 \
+	  && op->arg[1].type == IFLAT_UI32);
+
+#define assert_args_144(op) \
+  assert (op->num_args == 3 && op->arg[0].type == IFLAT_UI8 \
+	  && op->arg[1].type == IFLAT_UI32 \
+	  && op->arg[2].type == IFLAT_UI32);
+
+// the ops_mem.h loads and stores.  (msn, phys addr) and then the virtual
+// address, the page table entries and T0, which we don't use
+#define assert_args_1444444(op) \
+  assert (op->num_args == 7 && op->arg[0].type == IFLAT_UI8 \
+	  && op->arg[1].type == IFLAT_UI32 \
+	  && op->arg[2].type == IFLAT_UI32 \
+	  && op->arg[3].type == IFLAT_UI32 \
+	  && op->arg[4].type == IFLAT_UI32 \
+	  && op->arg[5].type == IFLAT_UI32 \
+	  && op->arg[6].type == IFLAT_UI32);
+
 #define assert_args_81(op) \
   assert (op->num_args == 2 && op->arg[0].type == IFLAT_UI64  \
 	  && op->arg[1].type == IFLAT_UI8);
@@ -875,1523 +859,1494 @@ inline void if_st(iferret_t *iferret, uint32_t msn, uint32_t rn, uint32_t n, uin
 	  && op->arg[2].type == IFLAT_UI32 \
 	  && op->arg[3].type == IFLAT_UI32);
 
-#if 0
-void iferret_info_flow_process_op(iferret_t *iferret,  iferret_op_t *op) {  
-  iferret_op_arg_t *arg;
-  uint8_t a0_8, a1_8, a2_8, a3_8, a4_8;
-  uint16_t a0_16, a1_16, a2_16, a3_16, a4_16;
-  uint32_t a0_32, a1_32, a2_32, a3_32, a4_32;
-  uint64_t a0_64, a1_64, a2_64, a3_64, a4_64;
-  assert (op->num < IFLO_SYS_CALLS_START);
+// Op handlers.
+// Each IF_OP is the handler for the ops it lists, and is named after the
+// first of them.  make_iferret_code.pl picks the IF_OP lines out of this
+// file and writes iferret_info_flow_dispatch.h, a table with a slot for
+// every info-flow op, so dispatch is one indexed load.  Args are still
+// decoded by iferret_log_op_args_read; the a<i>_<width> names below just
+// read them out of op->arg without first copying every one into a local.
+
+typedef void (*iferret_info_flow_handler_t)(iferret_t *iferret, iferret_op_t *op, iferret_op_arg_t *arg);
+
+#define IF_OP(name, ...) \
+  static void if_op_##name(iferret_t *iferret, iferret_op_t *op, iferret_op_arg_t *arg)
+
+#define a0_8 (arg[0].val.u8)
+#define a1_8 (arg[1].val.u8)
+#define a2_8 (arg[2].val.u8)
+#define a3_8 (arg[3].val.u8)
+#define a4_8 (arg[4].val.u8)
+
+#define a0_16 (arg[0].val.u16)
+#define a1_16 (arg[1].val.u16)
+#define a2_16 (arg[2].val.u16)
+#define a3_16 (arg[3].val.u16)
+#define a4_16 (arg[4].val.u16)
+
+#define a0_32 (arg[0].val.u32)
+#define a1_32 (arg[1].val.u32)
+#define a2_32 (arg[2].val.u32)
+#define a3_32 (arg[3].val.u32)
+#define a4_32 (arg[4].val.u32)
+
+#define a0_64 (arg[0].val.u64)
+#define a1_64 (arg[1].val.u64)
+#define a2_64 (arg[2].val.u64)
+#define a3_64 (arg[3].val.u64)
+#define a4_64 (arg[4].val.u64)
 
-  arg = op->arg;
+/*
+   Start of opreg_template.h
+*/
 
-  a0_8 = arg[0].val.u8;
-  a1_8 = arg[1].val.u8;
-  a2_8 = arg[2].val.u8;
-  a3_8 = arg[3].val.u8;
-  a4_8 = arg[4].val.u8;
+/*
+   This stuff (through IFLO_MOVH_REG_T1) all parallels
+   that which is in opreg_template.h in target-i386.
+   we keep REG opaque and code the register directly in the
+   info flow log element. Thus, we don't need to play same
+   trick of including that file over and over.
+*/
 
-  a0_16 = arg[0].val.u16;
-  a1_16 = arg[1].val.u16;
-  a2_16 = arg[2].val.u16;
-  a3_16 = arg[3].val.u16;
-  a4_16 = arg[4].val.u16;
-  
-  a0_32 = arg[0].val.u32;
-  a1_32 = arg[1].val.u32;
-  a2_32 = arg[2].val.u32;
-  a3_32 = arg[3].val.u32;
-  a4_32 = arg[4].val.u32;
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_A0_R,REGNUM);
+// A0 = (uint32_t)REG;
+// dest,src
+IF_OP(IFLO_OPREG_TEMPL_MOVL_A0_R) {
+  assert_args_1(op);
+  if_copy_r4(iferret,IFRN_A0,a0_8);
+}
 
-  a0_64 = arg[0].val.u64;
-  a1_64 = arg[1].val.u64;
-  a2_64 = arg[2].val.u64;
-  a3_64 = arg[3].val.u64;
-  a4_64 = arg[4].val.u64;
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_ADDL_A0_R,REGNUM);
+// A0 = (uint32_t)(A0 + REG);
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_ADDL_A0_R_S1,REGNUM);
+// A0 = (uint32_t)(A0 + (REG << 1));
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_ADDL_A0_R_S2,REGNUM);
+// A0 = (uint32_t)(A0 + (REG << 2));
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_ADDL_A0_R_S3,REGNUM);
+// A0 = (uint32_t)(A0 + (REG << 3));
+IF_OP(IFLO_OPREG_TEMPL_ADDL_A0_R, IFLO_OPREG_TEMPL_ADDL_A0_R_S1, IFLO_OPREG_TEMPL_ADDL_A0_R_S2, IFLO_OPREG_TEMPL_ADDL_A0_R_S3) {
+  assert_args_1(op);
+  if_self_compute_r4(iferret,IFRN_A0,a0_8);
+}
 
+/*
+  NB: skipping bloody 64-bit for now
+  void OPPROTO glue(op_movq_A0,REGNAME)(void)
+  void OPPROTO glue(op_addq_A0,REGNAME)(void)
+  void OPPROTO glue(glue(op_addq_A0,REGNAME),_s1)(void)
+  void OPPROTO glue(glue(op_addq_A0,REGNAME),_s2)(void)
+  void OPPROTO glue(glue(op_addq_A0,REGNAME),_s3)(void)
+*/
 
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_T0_R,REGNUM);
+// T0 = REG;
+IF_OP(IFLO_OPREG_TEMPL_MOVL_T0_R) {
+  assert_args_1(op);
+  if_copy_r4(iferret,IFRN_T0,a0_8);
+}
 
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_T1_R,REGNUM);
+// T1 = REG;
+IF_OP(IFLO_OPREG_TEMPL_MOVL_T1_R) {
+  assert_args_1(op);
+  if_copy_r4(iferret,IFRN_T1,a0_8);
+}
 
-  switch (op->num) {
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVH_T0_R,REGNUM);
+// T0 = REG >> 8;
+IF_OP(IFLO_OPREG_TEMPL_MOVH_T0_R) {
+  assert_args_1(op);
+  if_delete_r4(iferret,IFRN_T0);
+  if_compute_r4(iferret,IFRN_T0,a0_8);
+}
 
-    /* 
-       Start of opreg_template.h
-    */
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVH_T1_R,REGNUM);
+// T1 = REG >> 8;
+IF_OP(IFLO_OPREG_TEMPL_MOVH_T1_R) {
+  assert_args_1(op);
+  if_delete_r4(iferret,IFRN_T1);
+  if_compute_r4(iferret,IFRN_T1,a0_8);
+}
 
-    /* 
-       This stuff (through IFLO_MOVH_REG_T1) all parallels
-       that which is in opreg_template.h in target-i386.
-       we keep REG opaque and code the register directly in the 
-       info flow log element. Thus, we don't need to play same
-       trick of including that file over and over.  
-    */
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_R_T0,REGNUM);
+// REG = (uint32_t)T0;
+IF_OP(IFLO_OPREG_TEMPL_MOVL_R_T0) {
+  assert_args_1(op);
+  if_copy_r4(iferret,a0_8,IFRN_T0);
+}
 
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_A0_R,REGNUM);
-    // A0 = (uint32_t)REG; 
-  case IFLO_OPREG_TEMPL_MOVL_A0_R:  
-    // dest,src
-    assert_args_1(op);
-    if_copy_r4(iferret,IFRN_A0,a0_8);
-    break;
-
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_ADDL_A0_R,REGNUM);
-    // A0 = (uint32_t)(A0 + REG);
-  case IFLO_OPREG_TEMPL_ADDL_A0_R:
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_ADDL_A0_R_S1,REGNUM);
-    // A0 = (uint32_t)(A0 + (REG << 1)); 
-  case IFLO_OPREG_TEMPL_ADDL_A0_R_S1:
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_ADDL_A0_R_S2,REGNUM);
-    // A0 = (uint32_t)(A0 + (REG << 2));
-  case IFLO_OPREG_TEMPL_ADDL_A0_R_S2:
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_ADDL_A0_R_S3,REGNUM);
-    // A0 = (uint32_t)(A0 + (REG << 3));
-  case IFLO_OPREG_TEMPL_ADDL_A0_R_S3:
-    assert_args_1(op);
-    if_self_compute_r4(iferret,IFRN_A0,a0_8);
-    break;
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_R_T1,REGNUM);
+// REG = (uint32_t)T1;
+IF_OP(IFLO_OPREG_TEMPL_MOVL_R_T1) {
+  assert_args_1(op);
+  if_copy_r4(iferret,a0_8,IFRN_T1);
+}
 
-    /*
-      NB: skipping bloody 64-bit for now
-      void OPPROTO glue(op_movq_A0,REGNAME)(void)
-      void OPPROTO glue(op_addq_A0,REGNAME)(void)
-      void OPPROTO glue(glue(op_addq_A0,REGNAME),_s1)(void)
-      void OPPROTO glue(glue(op_addq_A0,REGNAME),_s2)(void)
-      void OPPROTO glue(glue(op_addq_A0,REGNAME),_s3)(void)
-    */
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_R_A0,REGNUM);
+// REG = (uint32_t)A0;
+IF_OP(IFLO_OPREG_TEMPL_MOVL_R_A0) {
+  assert_args_1(op);
+  if_copy_r4(iferret,a0_8,IFRN_A0);
+}
 
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_T0_R,REGNUM);
-    // T0 = REG;
-  case IFLO_OPREG_TEMPL_MOVL_T0_R:
-    assert_args_1(op);
-    if_copy_r4(iferret,IFRN_T0,a0_8);
-    break;
-    
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_T1_R,REGNUM);
-    // T1 = REG;
-  case IFLO_OPREG_TEMPL_MOVL_T1_R:
-    assert_args_1(op);
-    if_copy_r4(iferret,IFRN_T1,a0_8);
-    break;
-
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVH_T0_R,REGNUM);
-    // T0 = REG >> 8;
-  case IFLO_OPREG_TEMPL_MOVH_T0_R:
-    assert_args_1(op);
-    if_delete_r4(iferret,IFRN_T0);
-    if_compute_r4(iferret,IFRN_T0,a0_8);
-    break;
-
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVH_T1_R,REGNUM);
-    // T1 = REG >> 8;
-  case IFLO_OPREG_TEMPL_MOVH_T1_R:
-    assert_args_1(op);
-    if_delete_r4(iferret,IFRN_T1);
-    if_compute_r4(iferret,IFRN_T1,a0_8);
-    break;
-
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_R_T0,REGNUM);
-    // REG = (uint32_t)T0;
-  case IFLO_OPREG_TEMPL_MOVL_R_T0:
-    assert_args_1(op);
-    if_copy_r4(iferret,a0_8,IFRN_T0);
-    break;
-    
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_R_T1,REGNUM);
-    // REG = (uint32_t)T1;
-  case IFLO_OPREG_TEMPL_MOVL_R_T1:
-    assert_args_1(op);
-    if_copy_r4(iferret,a0_8,IFRN_T1);
-    break;
-    
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVL_R_A0,REGNUM);
-    // REG = (uint32_t)A0;
-  case IFLO_OPREG_TEMPL_MOVL_R_A0:
-    assert_args_1(op);
-    if_copy_r4(iferret,a0_8,IFRN_A0);
-    break;
+/*
+  Skipping 64-bit again
+  void OPPROTO glue(glue(op_movq,REGNAME),_T0)(void)
+  void OPPROTO glue(glue(op_movq,REGNAME),_T1)(void)
+  void OPPROTO glue(glue(op_movq,REGNAME),_A0)(void)
+*/
 
-    /*
-      Skipping 64-bit again 
-      void OPPROTO glue(glue(op_movq,REGNAME),_T0)(void)
-      void OPPROTO glue(glue(op_movq,REGNAME),_T1)(void)
-      void OPPROTO glue(glue(op_movq,REGNAME),_A0)(void)
-    */
+//    iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_CMOVW_R_T1_T0,REGNUM);
+// mov T1 to REG.  (NB: we are inside the conditional.  So really this isa MOVW.)
+// REG = (REG & ~0xffff) | (T1 & 0xffff);
+// here, copy low 2 bytes from T1 to REG and leave top 24 bytes of REG alone.
+IF_OP(IFLO_OPREG_TEMPL_CMOVW_R_T1_T0) {
+  assert_args_14(op);
+  if_copy_r2(iferret,a0_8,IFRN_T1);
+}
 
-    //    iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_CMOVW_R_T1_T0,REGNUM);
-    // mov T1 to REG.  (NB: we are inside the conditional.  So really this isa MOVW.)
-    // REG = (REG & ~0xffff) | (T1 & 0xffff);
-    // here, copy low 2 bytes from T1 to REG and leave top 24 bytes of REG alone.
-  case IFLO_OPREG_TEMPL_CMOVW_R_T1_T0:
-    assert_args_1(op);
-    if_copy_r2(iferret,a0_8,IFRN_T1);
-    break;
-
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_CMOVL_R_T1_T0,REGNUM);
-    // mov T1 to REG if T0
-    // REG = (uint32_t)T1;
-    // here, different from previous.  
-    // copy low 4 bytes from T1 to REG and zero anything in REG above those 4 bytes.  
-  case IFLO_OPREG_TEMPL_CMOVL_R_T1_T0:
-    assert_args_1(op);
-    if_copy_r4(iferret,a0_8,IFRN_T1);
-    break; 
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_CMOVL_R_T1_T0,REGNUM);
+// mov T1 to REG if T0
+// REG = (uint32_t)T1;
+// here, different from previous.
+// copy low 4 bytes from T1 to REG and zero anything in REG above those 4 bytes.
+IF_OP(IFLO_OPREG_TEMPL_CMOVL_R_T1_T0) {
+  assert_args_14(op);
+  if_copy_r4(iferret,a0_8,IFRN_T1);
+}
 
-    /*
-      Skipping 64 bit.
-      void OPPROTO glue(glue(op_cmovq,REGNAME),_T1_T0)(void)
-    */
+/*
+  Skipping 64 bit.
+  void OPPROTO glue(glue(op_cmovq,REGNAME),_T1_T0)(void)
+*/
 
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVW_R_T0,REGNUM);
-    // REG = (REG & ~0xffff) | (T0 & 0xffff);
-  case IFLO_OPREG_TEMPL_MOVW_R_T0:
-    assert_args_1(op);
-    if_copy_r2(iferret,a0_8,IFRN_T0);
-    break;
-    
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVW_R_T1,REGNUM);
-    // REG = (REG & ~0xffff) | (T1 & 0xffff);
-  case IFLO_OPREG_TEMPL_MOVW_R_T1:
-    assert_args_1(op);
-    if_copy_r2(iferret,a0_8,IFRN_T1);
-    break;
-    
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVW_R_A0,REGNUM);
-    // REG = (REG & ~0xffff) | (A0 & 0xffff);
-  case IFLO_OPREG_TEMPL_MOVW_R_A0:
-    assert_args_1(op);
-    if_copy_r2(iferret,a0_8,IFRN_A0);
-    break;  
-
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVB_R_T0,REGNUM);
-    // REG = (REG & ~0xff) | (T0 & 0xff);
-  case IFLO_OPREG_TEMPL_MOVB_R_T0:
-    assert_args_1(op);
-    if_copy_r1(iferret,a0_8,IFRN_T0);
-    break;
-    
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVH_R_T0,REGNUM);
-    // REG = (REG & ~0xff00) | ((T0 & 0xff) << 8);
-  case IFLO_OPREG_TEMPL_MOVH_R_T0:
-    assert_args_1(op);
-    if_copy_regs_aux(iferret,a0_8,1,IFRN_T0,1,1);
-    break;
-
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVB_R_T1,REGNUM);
-    // REG = (REG & ~0xff) | (T1 & 0xff);
-  case IFLO_OPREG_TEMPL_MOVB_R_T1:
-    assert_args_1(op);
-    if_copy_r1(iferret,a0_8,IFRN_T1);
-    break;
-
-    // iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVH_R_T1,REGNUM);
-    // REG = (REG & ~0xff00) | ((T1 & 0xff) << 8);
-  case IFLO_OPREG_TEMPL_MOVH_R_T1:
-    assert_args_1(op);
-    if_copy_regs_aux(iferret,a0_8,1,IFRN_T1,1,1);
-    break;
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVW_R_T0,REGNUM);
+// REG = (REG & ~0xffff) | (T0 & 0xffff);
+IF_OP(IFLO_OPREG_TEMPL_MOVW_R_T0) {
+  assert_args_1(op);
+  if_copy_r2(iferret,a0_8,IFRN_T0);
+}
 
-    /*
-      TRL 0802 Skipping 64-bit versions
-      i.e. env->regs[9..15]
-    */
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVW_R_T1,REGNUM);
+// REG = (REG & ~0xffff) | (T1 & 0xffff);
+IF_OP(IFLO_OPREG_TEMPL_MOVW_R_T1) {
+  assert_args_1(op);
+  if_copy_r2(iferret,a0_8,IFRN_T1);
+}
 
-    /* 
-       End of opreg_template.h 
-    */
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVW_R_A0,REGNUM);
+// REG = (REG & ~0xffff) | (A0 & 0xffff);
+IF_OP(IFLO_OPREG_TEMPL_MOVW_R_A0) {
+  assert_args_1(op);
+  if_copy_r2(iferret,a0_8,IFRN_A0);
+}
 
-    // T0 += T1;      
-  case IFLO_ADDL_T0_T1:
-    // T0 |= T1;
-  case IFLO_ORL_T0_T1:
-    // T0 &= T1;
-  case IFLO_ANDL_T0_T1:
-    // T0 -= T1;
-  case IFLO_SUBL_T0_T1:
-    // T0 ^= T1;
-  case IFLO_XORL_T0_T1:
-    assert_args_0(op);
-    if_self_compute_r4(iferret,IFRN_T0,IFRN_T1);
-    break;
-
-    // T0 = -T0;
-  case IFLO_NEGL_T0:
-    // T0++;
-  case IFLO_INCL_T0:
-    // T0--;
-  case IFLO_DECL_T0:
-    // T0 = ~T0;
-  case IFLO_NOTL_T0:
-    // T0 = bswap32(T0);
-  case IFLO_BSWAPL_T0:
-    // helper_bswapq_T0();
-    assert_args_0(op);
-    if_inc_r4(iferret,IFRN_T0);
-    break;
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVB_R_T0,REGNUM);
+// REG = (REG & ~0xff) | (T0 & 0xff);
+IF_OP(IFLO_OPREG_TEMPL_MOVB_R_T0) {
+  assert_args_1(op);
+  if_copy_r1(iferret,a0_8,IFRN_T0);
+}
 
-    /*
-      TRL 0802 Not bothering with 64-bit.
-      Thus, skipping op_bswapq_T0
-    */
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVH_R_T0,REGNUM);
+// REG = (REG & ~0xff00) | ((T0 & 0xff) << 8);
+IF_OP(IFLO_OPREG_TEMPL_MOVH_R_T0) {
+  assert_args_1(op);
+  if_copy_regs_aux(iferret,a0_8,1,IFRN_T0,1,1);
+}
 
-    // MULB:
-    // res = (uint8_t)EAX * (uint8_t)T0;
-    // EAX = (EAX & ~0xffff) | res;
-    // IMULB:
-    // res = (int8_t)EAX * (int8_t)T0;
-    // EAX = (EAX & ~0xffff) | (res & 0xffff);
-  case IFLO_MULB_AL_T0:
-  case IFLO_IMULB_AL_T0:
-    // q1(0..1) der (eax(0),t0(0))
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_Q1);
-    if_compute_regs_aux(iferret,IFRN_Q1,0,2,IFRN_EAX,0,1);
-    if_compute_regs_aux(iferret,IFRN_Q1,0,2,IFRN_T0,0,1);
-    // eax(0..1) = q1(0..1)
-    if_copy_r2(iferret,IFRN_EAX,IFRN_Q1);    
-    break;
-
-    // MULW:
-    // res = (uint16_t)EAX * (uint16_t)T0;
-    // EAX = (EAX & ~0xffff) | (res & 0xffff);
-    // EDX = (EDX & ~0xffff) | ((res >> 16) & 0xffff);
-  case IFLO_MULW_AX_T0:
-  case IFLO_IMULW_AX_T0:
-    // q1(0..3) der (eax(0..1),t0(0..1))
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_Q1);
-    if_compute_regs_aux(iferret,IFRN_Q1,0,4,IFRN_EAX,0,2);
-    if_compute_regs_aux(iferret,IFRN_Q1,0,4,IFRN_T0,0,2);
-    // eax(0..1) = q1(0..1)
-    if_copy_regs_aux(iferret,IFRN_EAX,0,IFRN_Q1,0,2);    
-    // edx(0..1) = q1(2..3)
-    if_copy_regs_aux(iferret,IFRN_EDX,0,IFRN_Q1,2,2);
-    break;
-
-    // MULL:
-    // res = (uint64_t)((uint32_t)EAX) * (uint64_t)((uint32_t)T0);
-    // EAX = (uint32_t)res;
-    // EDX = (uint32_t)(res >> 32);
-    // IMULL:
-    // res = (int64_t)((int32_t)EAX) * (int64_t)((int32_t)T0);
-    // EAX = (uint32_t)(res);
-    // EDX = (uint32_t)(res >> 32);
-  case IFLO_MULL_EAX_T0:
-  case IFLO_IMULL_EAX_T0:
-    // q1(0..3) der (eax(0..3),t0(0..3))
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_Q1);
-    if_compute_r4(iferret,IFRN_Q1,IFRN_EAX);
-    if_compute_r4(iferret,IFRN_Q1,IFRN_T0);
-    // q2(0..3) der (eax(0..3),t0(0..3))
-    if_delete_r4(iferret,IFRN_Q2);
-    if_compute_r4(iferret,IFRN_Q2,IFRN_EAX);
-    if_compute_r4(iferret,IFRN_Q2,IFRN_T0);
-    // eax(0..3) = q1(0..3)
-    if_copy_r4(iferret,IFRN_EAX,IFRN_Q1);
-    // edx(0..3) = q2(0..3)
-    if_copy_r4(iferret,IFRN_EDX,IFRN_Q2);
-    break;
-
-    // res = (int16_t)T0 * (int16_t)T1;
-    // T0 = res;
-  case IFLO_IMULW_T0_T1:
-    // q1(0..2) der (t0(0..1),t1(0..1))
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_Q1);
-    if_compute_regs_aux(iferret,IFRN_Q1,0,4,IFRN_T0,0,2);
-    if_compute_regs_aux(iferret,IFRN_Q1,0,4,IFRN_T1,0,2);
-    // t0(0..3) = q1(0..3)
-    if_copy_r4(iferret,IFRN_EAX,IFRN_Q1);    
-    break;
-
-    // res = (int64_t)((int32_t)T0) * (int64_t)((int32_t)T1);
-    // T0 = res;
-  case IFLO_IMULL_T0_T1:
-    // okay, we're screwed here.  looks like T0 *has* to be 64-bit?
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_T0);
-    break;
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVB_R_T1,REGNUM);
+// REG = (REG & ~0xff) | (T1 & 0xff);
+IF_OP(IFLO_OPREG_TEMPL_MOVB_R_T1) {
+  assert_args_1(op);
+  if_copy_r1(iferret,a0_8,IFRN_T1);
+}
 
-    /*
-      TRL 0802 
-      Ignoring 64-bit 
-      op_mulq_EAX_T0
-      op_imulq_EAX_T0
-      op_imulq_T0_T1
-    */
+// iferret_log_info_flow_op_write_1(IFLO_OPREG_TEMPL_MOVH_R_T1,REGNUM);
+// REG = (REG & ~0xff00) | ((T1 & 0xff) << 8);
+IF_OP(IFLO_OPREG_TEMPL_MOVH_R_T1) {
+  assert_args_1(op);
+  if_copy_regs_aux(iferret,a0_8,1,IFRN_T1,1,1);
+}
 
-    /*
-    num = (EAX & 0xffff);
-    den = (T0 & 0xff);
-    if (den == 0) {
-        raise_exception(EXCP00_DIVZ);
-    }
-    q = (num / den);
-    if (q > 0xff)
-        raise_exception(EXCP00_DIVZ);
-    q &= 0xff;
-    r = (num % den) & 0xff;
-    EAX = (EAX & ~0xffff) | (r << 8) | q;
-    */
+/*
+  TRL 0802 Skipping 64-bit versions
+  i.e. env->regs[9..15]
+*/
 
-  case IFLO_DIVB_AL_T0:
-  case IFLO_IDIVB_AL_T0:
-    // q1(0..1) = eax(0..1)         num
-    assert_args_0(op);
-    if_copy_r2(iferret,IFRN_Q1,IFRN_EAX);
-    // q2(0) = t0(0)                den
-    if_copy_r1(iferret,IFRN_Q2,IFRN_T0);
-    // q(0) der (q1(0..1),q2(0))   q
-    if_delete_r4(iferret,IFRN_Q3);
-    if_compute_regs_aux(iferret,IFRN_Q3,0,1,IFRN_Q1,0,2);
-    if_compute_regs_aux(iferret,IFRN_Q3,0,1,IFRN_Q2,0,1);
-    // q4(0) der (q1(0..1),q2(0))   r
-    if_delete_r4(iferret,IFRN_Q4);
-    if_compute_regs_aux(iferret,IFRN_Q4,0,1,IFRN_Q1,0,2);
-    if_compute_regs_aux(iferret,IFRN_Q4,0,1,IFRN_Q2,0,1);
-    // eax(0) = q3(0)
-    if_copy_r1(iferret,IFRN_EAX,IFRN_Q3);
-    // eax(1) = q4(0)
-    if_copy_regs_aux(iferret,IFRN_EAX,1,IFRN_Q4,0,1);
-    break;
+/*
+   End of opreg_template.h
+*/
 
-    /*
-    num = (EAX & 0xffff) | ((EDX & 0xffff) << 16);
-    den = (T0 & 0xffff);
-    if (den == 0) {
-        raise_exception(EXCP00_DIVZ);
-    }
-    q = (num / den);
-    if (q > 0xffff)
-        raise_exception(EXCP00_DIVZ);
-    q &= 0xffff;
-    r = (num % den) & 0xffff;
-    EAX = (EAX & ~0xffff) | q;
-    EDX = (EDX & ~0xffff) | r;
-    */
-  case IFLO_DIVW_AX_T0:
-  case IFLO_IDIVW_AX_T0:
-    // q1(0..1) = eax(0..1)               num
-    assert_args_0(op);
-    if_copy_r2(iferret,IFRN_Q1,IFRN_EAX);         
-    // q1(2..3) = edx(0..1)               
-    if_copy_regs_aux(iferret,IFRN_Q1,2,IFRN_EDX,0,2);
-    // q2(0..1) = t0(0..1)                den
-    if_copy_r2(iferret,IFRN_Q2,IFRN_T0);
-    // q3(0..1) der (q1(0..3),q2(0..1))   q
-    if_delete_r4(iferret,IFRN_Q3);
-    if_compute_regs_aux(iferret,IFRN_Q3,0,2,IFRN_Q1,0,4);
-    if_compute_regs_aux(iferret,IFRN_Q3,0,2,IFRN_Q2,0,2);
-    // q4(0..1) der (q1(0..3),q2(0..1))   r
-    if_delete_r4(iferret,IFRN_Q4);
-    if_compute_regs_aux(iferret,IFRN_Q4,0,2,IFRN_Q1,0,4);
-    if_compute_regs_aux(iferret,IFRN_Q4,0,2,IFRN_Q2,0,2);
-    // eax(0..1) = q3(0..1)
-    if_copy_r2(iferret,IFRN_EAX,IFRN_Q3);
-    // edx(0..1) = q4(0..1)
-    if_copy_r2(iferret,IFRN_EAX,IFRN_Q4);
-    break;
+// T0 += T1;
+// T0 |= T1;
+// T0 &= T1;
+// T0 -= T1;
+// T0 ^= T1;
+IF_OP(IFLO_ADDL_T0_T1, IFLO_ORL_T0_T1, IFLO_ANDL_T0_T1, IFLO_SUBL_T0_T1, IFLO_XORL_T0_T1) {
+  assert_args_0(op);
+  if_self_compute_r4(iferret,IFRN_T0,IFRN_T1);
+}
 
-    /*
-    num = ((uint32_t)EAX) | ((uint64_t)((uint32_t)EDX) << 32);
-    den = T0;
-    if (den == 0) {
-        raise_exception(EXCP00_DIVZ);
-    }
+// T0 = -T0;
+// T0++;
+// T0--;
+// T0 = ~T0;
+// T0 = bswap32(T0);
+// helper_bswapq_T0();
+IF_OP(IFLO_NEGL_T0, IFLO_INCL_T0, IFLO_DECL_T0, IFLO_NOTL_T0, IFLO_BSWAPL_T0) {
+  assert_args_0(op);
+  if_inc_r4(iferret,IFRN_T0);
+}
+
+/*
+  TRL 0802 Not bothering with 64-bit.
+  Thus, skipping op_bswapq_T0
+*/
+
+// MULB:
+// res = (uint8_t)EAX * (uint8_t)T0;
+// EAX = (EAX & ~0xffff) | res;
+// IMULB:
+// res = (int8_t)EAX * (int8_t)T0;
+// EAX = (EAX & ~0xffff) | (res & 0xffff);
+// q1(0..1) der (eax(0),t0(0))
+IF_OP(IFLO_MULB_AL_T0, IFLO_IMULB_AL_T0) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_Q1);
+  if_compute_regs_aux(iferret,IFRN_Q1,0,2,IFRN_EAX,0,1);
+  if_compute_regs_aux(iferret,IFRN_Q1,0,2,IFRN_T0,0,1);
+  // eax(0..1) = q1(0..1)
+  if_copy_r2(iferret,IFRN_EAX,IFRN_Q1);
+}
+
+// MULW:
+// res = (uint16_t)EAX * (uint16_t)T0;
+// EAX = (EAX & ~0xffff) | (res & 0xffff);
+// EDX = (EDX & ~0xffff) | ((res >> 16) & 0xffff);
+// q1(0..3) der (eax(0..1),t0(0..1))
+IF_OP(IFLO_MULW_AX_T0, IFLO_IMULW_AX_T0) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_Q1);
+  if_compute_regs_aux(iferret,IFRN_Q1,0,4,IFRN_EAX,0,2);
+  if_compute_regs_aux(iferret,IFRN_Q1,0,4,IFRN_T0,0,2);
+  // eax(0..1) = q1(0..1)
+  if_copy_regs_aux(iferret,IFRN_EAX,0,IFRN_Q1,0,2);
+  // edx(0..1) = q1(2..3)
+  if_copy_regs_aux(iferret,IFRN_EDX,0,IFRN_Q1,2,2);
+}
+
+// MULL:
+// res = (uint64_t)((uint32_t)EAX) * (uint64_t)((uint32_t)T0);
+// EAX = (uint32_t)res;
+// EDX = (uint32_t)(res >> 32);
+// IMULL:
+// res = (int64_t)((int32_t)EAX) * (int64_t)((int32_t)T0);
+// EAX = (uint32_t)(res);
+// EDX = (uint32_t)(res >> 32);
+// q1(0..3) der (eax(0..3),t0(0..3))
+IF_OP(IFLO_MULL_EAX_T0, IFLO_IMULL_EAX_T0) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_Q1);
+  if_compute_r4(iferret,IFRN_Q1,IFRN_EAX);
+  if_compute_r4(iferret,IFRN_Q1,IFRN_T0);
+  // q2(0..3) der (eax(0..3),t0(0..3))
+  if_delete_r4(iferret,IFRN_Q2);
+  if_compute_r4(iferret,IFRN_Q2,IFRN_EAX);
+  if_compute_r4(iferret,IFRN_Q2,IFRN_T0);
+  // eax(0..3) = q1(0..3)
+  if_copy_r4(iferret,IFRN_EAX,IFRN_Q1);
+  // edx(0..3) = q2(0..3)
+  if_copy_r4(iferret,IFRN_EDX,IFRN_Q2);
+}
+
+// res = (int16_t)T0 * (int16_t)T1;
+// T0 = res;
+// q1(0..2) der (t0(0..1),t1(0..1))
+IF_OP(IFLO_IMULW_T0_T1) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_Q1);
+  if_compute_regs_aux(iferret,IFRN_Q1,0,4,IFRN_T0,0,2);
+  if_compute_regs_aux(iferret,IFRN_Q1,0,4,IFRN_T1,0,2);
+  // t0(0..3) = q1(0..3)
+  if_copy_r4(iferret,IFRN_EAX,IFRN_Q1);
+}
+
+// res = (int64_t)((int32_t)T0) * (int64_t)((int32_t)T1);
+// T0 = res;
+// okay, we're screwed here.  looks like T0 *has* to be 64-bit?
+IF_OP(IFLO_IMULL_T0_T1) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_T0);
+}
+
+/*
+  TRL 0802
+  Ignoring 64-bit
+  op_mulq_EAX_T0
+  op_imulq_EAX_T0
+  op_imulq_T0_T1
+*/
+
+/*
+num = (EAX & 0xffff);
+den = (T0 & 0xff);
+if (den == 0) {
+    raise_exception(EXCP00_DIVZ);
+}
+q = (num / den);
+if (q > 0xff)
+    raise_exception(EXCP00_DIVZ);
+q &= 0xff;
+r = (num % den) & 0xff;
+EAX = (EAX & ~0xffff) | (r << 8) | q;
+*/
+
+// q1(0..1) = eax(0..1)         num
+IF_OP(IFLO_DIVB_AL_T0, IFLO_IDIVB_AL_T0) {
+  assert_args_0(op);
+  if_copy_r2(iferret,IFRN_Q1,IFRN_EAX);
+  // q2(0) = t0(0)                den
+  if_copy_r1(iferret,IFRN_Q2,IFRN_T0);
+  // q(0) der (q1(0..1),q2(0))   q
+  if_delete_r4(iferret,IFRN_Q3);
+  if_compute_regs_aux(iferret,IFRN_Q3,0,1,IFRN_Q1,0,2);
+  if_compute_regs_aux(iferret,IFRN_Q3,0,1,IFRN_Q2,0,1);
+  // q4(0) der (q1(0..1),q2(0))   r
+  if_delete_r4(iferret,IFRN_Q4);
+  if_compute_regs_aux(iferret,IFRN_Q4,0,1,IFRN_Q1,0,2);
+  if_compute_regs_aux(iferret,IFRN_Q4,0,1,IFRN_Q2,0,1);
+  // eax(0) = q3(0)
+  if_copy_r1(iferret,IFRN_EAX,IFRN_Q3);
+  // eax(1) = q4(0)
+  if_copy_regs_aux(iferret,IFRN_EAX,1,IFRN_Q4,0,1);
+}
+
+/*
+num = (EAX & 0xffff) | ((EDX & 0xffff) << 16);
+den = (T0 & 0xffff);
+if (den == 0) {
+    raise_exception(EXCP00_DIVZ);
+}
+q = (num / den);
+if (q > 0xffff)
+    raise_exception(EXCP00_DIVZ);
+q &= 0xffff;
+r = (num % den) & 0xffff;
+EAX = (EAX & ~0xffff) | q;
+EDX = (EDX & ~0xffff) | r;
+*/
+// q1(0..1) = eax(0..1)               num
+IF_OP(IFLO_DIVW_AX_T0, IFLO_IDIVW_AX_T0) {
+  assert_args_0(op);
+  if_copy_r2(iferret,IFRN_Q1,IFRN_EAX);
+  // q1(2..3) = edx(0..1)
+  if_copy_regs_aux(iferret,IFRN_Q1,2,IFRN_EDX,0,2);
+  // q2(0..1) = t0(0..1)                den
+  if_copy_r2(iferret,IFRN_Q2,IFRN_T0);
+  // q3(0..1) der (q1(0..3),q2(0..1))   q
+  if_delete_r4(iferret,IFRN_Q3);
+  if_compute_regs_aux(iferret,IFRN_Q3,0,2,IFRN_Q1,0,4);
+  if_compute_regs_aux(iferret,IFRN_Q3,0,2,IFRN_Q2,0,2);
+  // q4(0..1) der (q1(0..3),q2(0..1))   r
+  if_delete_r4(iferret,IFRN_Q4);
+  if_compute_regs_aux(iferret,IFRN_Q4,0,2,IFRN_Q1,0,4);
+  if_compute_regs_aux(iferret,IFRN_Q4,0,2,IFRN_Q2,0,2);
+  // eax(0..1) = q3(0..1)
+  if_copy_r2(iferret,IFRN_EAX,IFRN_Q3);
+  // edx(0..1) = q4(0..1)
+  if_copy_r2(iferret,IFRN_EAX,IFRN_Q4);
+}
+
+/*
+num = ((uint32_t)EAX) | ((uint64_t)((uint32_t)EDX) << 32);
+den = T0;
+if (den == 0) {
+    raise_exception(EXCP00_DIVZ);
+}
 #ifdef BUGGY_GCC_DIV64
-    r = div32(&q, num, den);
+r = div32(&q, num, den);
 #else
-    q = (num / den);
-    r = (num % den);
+q = (num / den);
+r = (num % den);
 #endif
-    if (q > 0xffffffff)
-        raise_exception(EXCP00_DIVZ);
-    EAX = (uint32_t)q;
-    EDX = (uint32_t)r;
-
-     */
-  case IFLO_DIVL_EAX_T0:
-  case IFLO_IDIVL_EAX_T0:
-    // Once again, we are in some trouble.
-    // num & den & T0 need to be 64-bit...
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_EAX);
-    if_delete_r4(iferret,IFRN_EDX);
-    break;
+if (q > 0xffffffff)
+    raise_exception(EXCP00_DIVZ);
+EAX = (uint32_t)q;
+EDX = (uint32_t)r;
 
-    /*
-      TRL 0802
-      Ignoring 64 bit again.
-      op_divq_EAX_T0
-      op_idivq_EAX_T0
-    */
+ */
+// Once again, we are in some trouble.
+// num & den & T0 need to be 64-bit...
+IF_OP(IFLO_DIVL_EAX_T0, IFLO_IDIVL_EAX_T0) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_EAX);
+  if_delete_r4(iferret,IFRN_EDX);
+}
 
-    // T0 = (uint32_t)PARAM1;
-  case IFLO_MOVL_T0_IMU:
-    // T0 = (int32_t)PARAM1;
-  case IFLO_MOVL_T0_IM:
-    assert_args_4(op);
-    if_delete_r4(iferret,IFRN_T0);
-    //if_im(iferret,IFRN_T0);
-    break;
-
-    // T0 = T0 & 0xffff;
-  case IFLO_ANDL_T0_FFFF:
-    assert_args_0(op);
-    if_inc_r4(iferret,IFRN_T0);
-    break;
-
-    // T0 += PARAM1;
-  case IFLO_ADDL_T0_IM:
-    //  T0 = T0 & PARAM1;
-  case IFLO_ANDL_T0_IM:
-    assert_args_4(op);
-    if_inc_r4(iferret,IFRN_T0);
-    //if_im(iferret,IFRN_T0);
-    break;
-
-    // T0 = T1;
-  case IFLO_MOVL_T0_T1:
-    assert_args_0(op);
-    if_copy_r4(iferret,IFRN_T0,IFRN_T1);
-    break;
-
-    // T1 = (uint32_t)PARAM1;    
-  case IFLO_MOVL_T1_IMU:
-    // T1 = (int32_t)PARAM1;
-  case IFLO_MOVL_T1_IM:
-    assert_args_4(op);
-    if_delete_r4(iferret,IFRN_T1);
-    //if_im(iferret,IFRN_T1);
-    break;
-
-    // T1 += PARAM1;
-  case IFLO_ADDL_T1_IM:
-    assert_args_4(op);
-    if_inc_r4(iferret,IFRN_T1);
-    //if_im(iferret,IFRN_T1);
-    break;
-
-    // T1 = A0;
-  case IFLO_MOVL_T1_A0:
-    assert_args_0(op);
-    if_copy_r4(iferret,IFRN_T1,IFRN_A0);
-    break; 
-
-    // A0 = (uint32_t)PARAM1;
-  case IFLO_MOVL_A0_IM:
-    assert_args_4(op);
-    if_delete_r4(iferret,IFRN_A0);
-    //if_im(iferret,IFRN_A0);
-    break;
-
-    // A0 = (uint32_t)(A0 + PARAM1);
-  case IFLO_ADDL_A0_IM:
-    assert_args_4(op);
-    if_inc_r4(iferret,IFRN_A0);
-    //if_im(iferret,IFRN_A0);
-    break;
-
-    // A0 = (uint32_t)*(target_ulong *)((char *)env + PARAM1);
-    // NB: if_addr is env+PARAM1
-  case IFLO_MOVL_A0_SEG:    
-    assert_args_84(op);
-    if_ldu(iferret,0,IFRN_A0,4,a0_64);
-    if_tainted_ptr(iferret,A0_BASE,a0_64,4);
-    break;
- 
-    // A0 = (uint32_t)(A0 + *(target_ulong *)((char *)env + PARAM1));
-    // NB: if_addr is env+PARAM1
-  case IFLO_ADDL_A0_SEG:
-    // q1 = *(if_addr)
-    assert_args_84(op);
-    if_ldu(iferret,0,IFRN_Q1,4,a0_64);
-    // a0 += q1
-    if_self_compute_r4(iferret,IFRN_A0, IFRN_Q1);
-    if_tainted_ptr(iferret,A0_BASE,a0_64,4);    
-    break;
-
-    // A0 = (uint32_t)(A0 + (EAX & 0xff));
-  case IFLO_ADDL_A0_AL:
-    assert_args_0(op);
-    if_self_compute_r4(iferret,IFRN_A0,IFRN_EAX);
-    break;
+/*
+  TRL 0802
+  Ignoring 64 bit again.
+  op_divq_EAX_T0
+  op_idivq_EAX_T0
+*/
 
-    // A0 = A0 & 0xffff;
-  case IFLO_ANDL_A0_FFFF:
-    // x86 is little endian so bytes 2 and 3 are higher order ones. 
-    assert_args_0(op);
-    if_delete_reg_aux(iferret,IFRN_A0,2,2);
-    break;
+// T0 = (uint32_t)PARAM1;
+// T0 = (int32_t)PARAM1;
+IF_OP(IFLO_MOVL_T0_IMU, IFLO_MOVL_T0_IM) {
+  assert_args_4(op);
+  if_delete_r4(iferret,IFRN_T0);
+  //if_im(iferret,IFRN_T0);
+}
 
-    /*
-      TRL0802 skipping 64-bit
-      op_movq_T0_im64
-      op_movq_T1_im64
-      op_movq_A0_im
-      op_movq_A0_im64
-      op_addq_A0_im
-      op_addq_A0_im64
-      op_movq_A0_seg
-      op_addq_A0_seg
-      op_addq_A0_AL
-    */
+// T0 = T0 & 0xffff;
+IF_OP(IFLO_ANDL_T0_FFFF) {
+  assert_args_0(op);
+  if_inc_r4(iferret,IFRN_T0);
+}
 
-    /*
-      Start handling includes of ops_mem.h in op.c.
+// T0 += PARAM1;
+//  T0 = T0 & PARAM1;
+IF_OP(IFLO_ADDL_T0_IM, IFLO_ANDL_T0_IM) {
+  assert_args_4(op);
+  if_inc_r4(iferret,IFRN_T0);
+  //if_im(iferret,IFRN_T0);
+}
 
-      The following, up to IFLO_STL_MEMSUFFIX_T1,
-      are analogous to ops_mem.h.  That file is included
-      several times by op.c with different settings for MEMSUFFIX.
-      Here, MEMSUFFIX is if_mem, which we squirreled away in the log
-      entry and extracted above.  
-    */
-    
-    //  iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDUB_T0_A0,MEMSUFFIXNUM,phys_a0(A0));
-    // T0 = *A0, just one byte. A0 is next element in log.
-  case IFLO_OPS_MEM_LDUB_T0_A0:
-    // first, a copy transfer from address to t0
-    assert_args_14(op);
-    if_ldu(iferret,a0_8,IFRN_T0,1,a1_32);
-    if_tainted_ptr(iferret,T0_BASE,A0_BASE,1);    
-    break;
-    
-    // iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDSB_T0_A0,MEMSUFFIXNUM,phys_a0(A0));
-    // ditto, but signed.
-  case IFLO_OPS_MEM_LDSB_T0_A0:
-    assert_args_14(op);
-    if_lds(iferret,a0_8,IFRN_T0,1,a1_32);
-    if_tainted_ptr(iferret,T0_BASE,A0_BASE,1);    
-    break; 
-
-    // iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDUW_T0_A0,MEMSUFFIXNUM,phys_a0(A0));
-    // T0 = *A0, 2 bytes
-  case IFLO_OPS_MEM_LDUW_T0_A0:
-    assert_args_14(op);
-    if_ldu(iferret,a0_8,IFRN_T0,2,a1_32);
-    if_tainted_ptr(iferret,T0_BASE,A0_BASE,2);    
-    break;
-
-    // iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDSW_T0_A0,MEMSUFFIXNUM,phys_a0(A0));
-    // ditto, but signed.
-  case IFLO_OPS_MEM_LDSW_T0_A0:
-    assert_args_14(op);
-    if_lds(iferret,a0_8,IFRN_T0,2,a1_32);
-    if_tainted_ptr(iferret,T0_BASE,A0_BASE,2);    
-    break;
-
-    // iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDL_T0_A0,MEMSUFFIXNUM,phys_a0(A0));
-    // T0 = *A0, 4 bytes
-  case IFLO_OPS_MEM_LDL_T0_A0:
-    assert_args_14(op);
-    if_ldu(iferret,a0_8,IFRN_T0,4,a1_32);
-    if_tainted_ptr(iferret,T0_BASE,A0_BASE,4);    
-    break;
-
-    // iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDUB_T1_A0,MEMSUFFIXNUM,phys_a0(A0));
-    // T1 = *A0, just one byte. A0 is next element in log.
-  case IFLO_OPS_MEM_LDUB_T1_A0:
-    assert_args_14(op);
-    if_ldu(iferret,a0_8,IFRN_T1,1,a1_32);
-    if_tainted_ptr(iferret,T1_BASE,A0_BASE,1);    
-    break;
-
-    // iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDSB_T1_A0,MEMSUFFIXNUM,phys_a0(A0));  
-    // ditto, but signed.
-  case IFLO_OPS_MEM_LDSB_T1_A0:
-    assert_args_14(op);
-    if_lds(iferret,a0_8,IFRN_T1,1,a1_32);
-    if_tainted_ptr(iferret,T1_BASE,A0_BASE,1);    
-    break; 
-      
-    // iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDUW_T1_A0,MEMSUFFIXNUM,phys_a0(A0));
-    // T1 = *A0, 2 bytes
-  case IFLO_OPS_MEM_LDUW_T1_A0:
-    assert_args_14(op);
-    if_ldu(iferret,a0_8,IFRN_T1,2,a1_32);
-    if_tainted_ptr(iferret,T1_BASE,A0_BASE,2);    
-    break;
-
-    // ditto, but signed.
-  case IFLO_OPS_MEM_LDSW_T1_A0:
-    assert_args_14(op);
-    if_lds(iferret,a0_8,IFRN_T1,2,a1_32);
-    if_tainted_ptr(iferret,T1_BASE,A0_BASE,2);    
-    break;
-
-    // T1 = *A0, 4 bytes
-  case IFLO_OPS_MEM_LDL_T1_A0:
-    assert_args_14(op);
-    if_ldu(iferret,a0_8,IFRN_T1,4,a1_32);
-    if_tainted_ptr(iferret,T1_BASE,A0_BASE,4);    
-    break;
-
-    // *A0 = T0, one byte
-  case IFLO_OPS_MEM_STB_T0_A0:
-    assert_args_14(op);
-    if_st(iferret,a0_8,IFRN_T0,1,a1_32);
-    break;
-
-    // two bytes.
-  case IFLO_OPS_MEM_STW_T0_A0:
-    assert_args_14(op);
-    if_st(iferret,a0_8,IFRN_T0,2,a1_32);
-    break;
-
-    // all four bytes
-  case IFLO_OPS_MEM_STL_T0_A0:
-    assert_args_14(op);
-    if_st(iferret,a0_8,IFRN_T0,4,a1_32);
-    break;
-    
-  case IFLO_OPS_MEM_STW_T1_A0:
-    assert_args_14(op);
-    if_st(iferret,a0_8,IFRN_T1,2,a1_32);
-    break;
+// T0 = T1;
+IF_OP(IFLO_MOVL_T0_T1) {
+  assert_args_0(op);
+  if_copy_r4(iferret,IFRN_T0,IFRN_T1);
+}
 
-  case IFLO_OPS_MEM_STL_T1_A0:
-    assert_args_14(op);
-    if_st(iferret,a0_8,IFRN_T1,4,a1_32);
-    break;
+// T1 = (uint32_t)PARAM1;
+// T1 = (int32_t)PARAM1;
+IF_OP(IFLO_MOVL_T1_IMU, IFLO_MOVL_T1_IM) {
+  assert_args_4(op);
+  if_delete_r4(iferret,IFRN_T1);
+  //if_im(iferret,IFRN_T1);
+}
 
-    /*
-      Done handling ops_mem.h stuff.
-    */
+// T1 += PARAM1;
+IF_OP(IFLO_ADDL_T1_IM) {
+  assert_args_4(op);
+  if_inc_r4(iferret,IFRN_T1);
+  //if_im(iferret,IFRN_T1);
+}
 
-    // raincheck
-    // EIP = T0;
-  case IFLO_JMP_T0:
-    // check here that EIP isn't tainted?  
-    assert_args_0(op);
-    if_copy_r4(iferret,IFRN_EIP,IFRN_T0);
-    break;
+// T1 = A0;
+IF_OP(IFLO_MOVL_T1_A0) {
+  assert_args_0(op);
+  if_copy_r4(iferret,IFRN_T1,IFRN_A0);
+}
 
-    // EIP = (uint32_t)PARAM1;
-  case IFLO_MOVL_EIP_IM:
-    assert_args_4(op);
-    if_delete_r4(iferret,IFRN_EIP);
-    break;
+// A0 = (uint32_t)PARAM1;
+IF_OP(IFLO_MOVL_A0_IM) {
+  assert_args_4(op);
+  if_delete_r4(iferret,IFRN_A0);
+  //if_im(iferret,IFRN_A0);
+}
 
-    /*
-      Skipping 64-bit
-      op_movq_eip_im
-      op_movq_eip_im64
-    */
+// A0 = (uint32_t)(A0 + PARAM1);
+IF_OP(IFLO_ADDL_A0_IM) {
+  assert_args_4(op);
+  if_inc_r4(iferret,IFRN_A0);
+  //if_im(iferret,IFRN_A0);
+}
 
-    /*
-      No info-flow for
-      op_hlt;
-      op_monitor;
-      op_mwait;
-      op_debug;
-      op_raise_interrupt;
-      op_raise_exception;
-      op_into;
-      op_cli;
-      op_sti;
-      op_set_inhibit_irq;
-      op_reset_inhibit_irq;
-      op_rsm;
-      op_boundw;  (Really?)
-      op_boundl;  (Really?)
+// A0 = (uint32_t)*(target_ulong *)((char *)env + PARAM1);
+// NB: if_addr is env+PARAM1
+IF_OP(IFLO_MOVL_A0_SEG) {
+  assert_args_84(op);
+  if_ldu(iferret,0,IFRN_A0,4,a0_64);
+  if_tainted_ptr(iferret,A0_BASE,a0_64,4);
+}
 
-    */
+// A0 = (uint32_t)(A0 + *(target_ulong *)((char *)env + PARAM1));
+// NB: if_addr is env+PARAM1
+// q1 = *(if_addr)
+IF_OP(IFLO_ADDL_A0_SEG) {
+  assert_args_84(op);
+  if_ldu(iferret,0,IFRN_Q1,4,a0_64);
+  // a0 += q1
+  if_self_compute_r4(iferret,IFRN_A0, IFRN_Q1);
+  if_tainted_ptr(iferret,A0_BASE,a0_64,4);
+}
 
-    
-    //    eflags = cc_table[CC_OP].compute_all();
-    //    d = ldq(A0);
-    //    if (d == (((uint64_t)EDX << 32) | EAX)) {
-    // // part_1 corresponds to this branch
-    //        iferret_log_info_flow_op_write_4(IFLO_CMPXCHG8B_PART1, phys_a0());       
-    //        stq(A0, ((uint64_t)ECX << 32) | EBX);
-    //        eflags |= CC_Z;
-    //	...
-    //    } else {
-    //        EDX = d >> 32;
-    //        EAX = d;
-    //	iferret_log_info_flow_op_write_0(IFLO_CMPXCHG8B_PART2);
-    //    }
-
-  case IFLO_CMPXCHG8B_PART1:
-    assert_args_4(op);
-    if_st(iferret,0,IFRN_EBX,4,a0_32);
-    if_st(iferret,0,IFRN_ECX,4,a0_32+4);
-    break;
-
-  case IFLO_CMPXCHG8B_PART2:
-    assert_args_4(op);
-    if_ldu(iferret,0,IFRN_EAX,4,a0_32);
-    if_ldu(iferret,0,IFRN_EDX,4,a0_32+4);
-    break;
-
-    // T0 = 0;
-  case IFLO_MOVL_T0_0:
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_T0);
-    break;
+// A0 = (uint32_t)(A0 + (EAX & 0xff));
+IF_OP(IFLO_ADDL_A0_AL) {
+  assert_args_0(op);
+  if_self_compute_r4(iferret,IFRN_A0,IFRN_EAX);
+}
 
-    /*
-      Start handling includes of ops_template.h into op.c
+// A0 = A0 & 0xffff;
+// x86 is little endian so bytes 2 and 3 are higher order ones.
+IF_OP(IFLO_ANDL_A0_FFFF) {
+  assert_args_0(op);
+  if_delete_reg_aux(iferret,IFRN_A0,2,2);
+}
 
-      Time for all those multiple size ops 
-      i.e. the 4 different includes of ops_template.h in op.c
-      for SHIFT = 0,1,2,3
-      which turns into q,l,w,b in ops_template.h
-    */
+/*
+  TRL0802 skipping 64-bit
+  op_movq_T0_im64
+  op_movq_T1_im64
+  op_movq_A0_im
+  op_movq_A0_im64
+  op_addq_A0_im
+  op_addq_A0_im64
+  op_movq_A0_seg
+  op_addq_A0_seg
+  op_addq_A0_AL
+*/
 
-    /*
-      These are all about computing cc (flags).
-      Taking a rain check for now. 
-      compute_all_add
-      compute_c_add
-      compute_all_adc
-      compute_c_adc
-      compute_all_sub
-      compute_c_sub
-      compute_all_sbb
-      compute_c_sbb
-      compute_all_logic
-      compute_all_inc
-      compute_c_inc
-      compute_all_dec
-      compute_all_shl
-      compute_c_shl
-      compute_c_sar
-      compute_all_sar
-      compute_c_mul
-      compute_all_mul
-      
-      These are jumps.  Also taking a raincheck.
-      op_jb_sub
-      op_jz_sub
-      op_jnz_sub
-      op_jbe_sub
-      op_js_sub
-      op_jl_sub
-      op_jle_sub
-      
-      Loops get a raincheck, too.
-      op_loopnz
-      op_loopz
-      op_jz_ecx
-      op_jnz_ecx
-    */
+/*
+  Start handling includes of ops_mem.h in op.c.
 
-    // raincheck
-    // these are all about setting T0 to true/false
-    // based upon the relationships between condition codes.
-    // T0 = ((DATA_TYPE)src1 < (DATA_TYPE)src2);
-  case IFLO_OPS_TEMPLATE_SETB_T0_SUB:
-    // T0 = ((DATA_TYPE)CC_DST == 0);
-  case IFLO_OPS_TEMPLATE_SETZ_T0_SUB:
-    // T0 = ((DATA_TYPE)src1 <= (DATA_TYPE)src2);
-  case IFLO_OPS_TEMPLATE_SETBE_T0_SUB:
-    // T0 = lshift(CC_DST, -(DATA_BITS - 1)) & 1;
-  case IFLO_OPS_TEMPLATE_SETS_T0_SUB:
-    // T0 = ((DATA_STYPE)src1 < (DATA_STYPE)src2);
-  case IFLO_OPS_TEMPLATE_SETL_T0_SUB:  // NB: a0_8 is SHIFT);
-    // A0 += ((DATA_STYPE)T1 >> (3 + SHIFT)) << SHIFT;
-    if_self_compute_r4(iferret,IFRN_A0,IFRN_T1);
-    break;
-
-    // weird shit.
-    //    res = T0 & DATA_MASK;
-    //    if (res != 0) {
-    //    count = 0;
-    //    while ((res & 1) == 0) {
-    //        count++;
-    //        res >>= 1;
-    //    }
-    //    iferret_log_info_flow_op_write_1(IFLO_OPS_TEMPLATE_BSF_T0_CC,SHIFT);
-    //    T1 = count;
-  case IFLO_OPS_TEMPLATE_BSF_T0_CC:
-  case IFLO_OPS_TEMPLATE_BSR_T0_CC:
-    assert_args_1(op);
-    if_delete_r4(iferret,IFRN_T1);
-    if_compute_r4(iferret,IFRN_T1,IFRN_T0);
-    break;
-
-    // raincheck. 
-    // DF is "direction flag" 
-    // T0 = DF << SHIFT;    
-  case IFLO_OPS_TEMPLATE_MOVL_T0_DSHIFT:
-    assert_args_1(op);
-    if_delete_r4(iferret,IFRN_T0);
-    break;
-    
+  The following, up to IFLO_STL_MEMSUFFIX_T1,
+  are analogous to ops_mem.h.  That file is included
+  several times by op.c with different settings for MEMSUFFIX.
+  Here, MEMSUFFIX is if_mem, which we squirreled away in the log
+  entry and extracted above.
+*/
 
-  case IFLO_HD_TRANSFER_PART1_T0_BASE:
-    assert_args_0(op);
-    printf ("IFLO_HD_TRANSFER_PART1_T0_BASE = %llx\n", ctull(T0_BASE));
-    iferret->last_hd_transfer_from = T0_BASE;
-    break;
-    
+//  iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDUB_T0_A0,MEMSUFFIXNUM,phys_a0(A0));
+// T0 = *A0, just one byte. A0 is next element in log.
+// first, a copy transfer from address to t0
+IF_OP(IFLO_OPS_MEM_LDUB_T0_A0) {
+  assert_args_1444444(op);
+  if_ldu(iferret,a0_8,IFRN_T0,1,a1_32);
+  if_tainted_ptr(iferret,T0_BASE,A0_BASE,1);
+}
 
-  case IFLO_HD_TRANSFER_PART1_T1_BASE:
-    assert_args_0(op);
-    printf ("IFLO_HD_TRANSFER_PART1_T1_BASE = %llx\n", ctull(T1_BASE));
-    iferret->last_hd_transfer_from = T1_BASE;
-    break;
-    
+// iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDSB_T0_A0,MEMSUFFIXNUM,phys_a0(A0));
+// ditto, but signed.
+IF_OP(IFLO_OPS_MEM_LDSB_T0_A0) {
+  assert_args_1444444(op);
+  if_lds(iferret,a0_8,IFRN_T0,1,a1_32);
+  if_tainted_ptr(iferret,T0_BASE,A0_BASE,1);
+}
 
-  case IFLO_HD_TRANSFER_PART1:
-    assert_args_8(op);
-    // (from)
-    // save the from address?
-    printf ("IFLO_HD_TRANSFER_PART1 = %llx\n", ctull(a0_64));
-    iferret->last_hd_transfer_from = a0_64;
-    break;
-
-  case IFLO_HD_TRANSFER_PART2:
-    assert_args_81(op);
-    // (to,size): (a0_64,a1_8)
-    // make use of saved from address.  
-    printf ("info flow op: IFLO_HD_TRANSFER P12 %llx -> %llx num=%d\n", 
-	    ctull(iferret->last_hd_transfer_from), ctull(a0_64), (int)a1_8);
-    if (iferret->last_hd_transfer_from != 0) {
-      if (info_flow_exists(iferret,iferret->last_hd_transfer_from, a1_8)) {
-	printf ("IFLO_HD_TRANSFER_PART2 from tainted:\n");
-      }
-      if (info_flow_exists(iferret,a0_64, a1_8)) {
-	printf ("IFLO_HD_TRANSFER_PART2 to tainted:\n");
-      }		  
-      info_flow_copy(iferret, a0_64, iferret->last_hd_transfer_from, a1_8);
-    }
-    break;
-
-  case IFLO_HD_TRANSFER:
-    assert_args_884(op);
-    // (from,to,size): (a0_64,a1_64,a2_32)
-    // NB: from could be HD or io buffer and to could be either.
-    if (a2_32 == 4096) {
-      printf ("here I am\n");
-    }
-    printf ("info flow op: IFLO_HD_TRANSFER %llx -> %llx num=%d\n", 
-	    ctull(a0_64), ctull(a1_64), a2_32);
-    info_flow_copy(iferret,a1_64,a0_64,a2_32);
-    if (info_flow_exists(iferret,a0_64, a2_32)) {
-      printf ("IFLO_HD_TRANSFER from tainted:\n");
-    }
-    if (info_flow_exists(iferret,a1_64, a2_32)) {
-      printf ("IFLO_HD_TRANSFER to tainted:\n");
-    }		  
-    break;
+// iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDUW_T0_A0,MEMSUFFIXNUM,phys_a0(A0));
+// T0 = *A0, 2 bytes
+IF_OP(IFLO_OPS_MEM_LDUW_T0_A0) {
+  assert_args_1444444(op);
+  if_ldu(iferret,a0_8,IFRN_T0,2,a1_32);
+  if_tainted_ptr(iferret,T0_BASE,A0_BASE,2);
+}
 
+// iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDSW_T0_A0,MEMSUFFIXNUM,phys_a0(A0));
+// ditto, but signed.
+IF_OP(IFLO_OPS_MEM_LDSW_T0_A0) {
+  assert_args_1444444(op);
+  if_lds(iferret,a0_8,IFRN_T0,2,a1_32);
+  if_tainted_ptr(iferret,T0_BASE,A0_BASE,2);
+}
 
-    // network output.  what do we do?
-  case IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_BYTE_T1:
-    assert_args_0(op);
-    if (info_flow_exists(iferret,T1_BASE, 1)) {
-      squeal_about_exfiltration(T1_BASE,1);
-    }
-    break;
+// iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDL_T0_A0,MEMSUFFIXNUM,phys_a0(A0));
+// T0 = *A0, 4 bytes
+IF_OP(IFLO_OPS_MEM_LDL_T0_A0) {
+  assert_args_1444444(op);
+  if_ldu(iferret,a0_8,IFRN_T0,4,a1_32);
+  if_tainted_ptr(iferret,T0_BASE,A0_BASE,4);
+}
 
-  case IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_WORD_T1:
-    assert_args_0(op);
-    if (info_flow_exists(iferret,T1_BASE, 2)) {
-      squeal_about_exfiltration(T1_BASE,2);
-    }
-    break;
+// iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDUB_T1_A0,MEMSUFFIXNUM,phys_a0(A0));
+// T1 = *A0, just one byte. A0 is next element in log.
+IF_OP(IFLO_OPS_MEM_LDUB_T1_A0) {
+  assert_args_1444444(op);
+  if_ldu(iferret,a0_8,IFRN_T1,1,a1_32);
+  if_tainted_ptr(iferret,T1_BASE,A0_BASE,1);
+}
 
-  case IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_LONG_T1:
-    assert_args_0(op);
-    if (info_flow_exists(iferret,T1_BASE, 4)) {
-      squeal_about_exfiltration(T1_BASE,4);
-    }
-    break;
-    
-  case IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_BYTE_T0:
-    assert_args_0(op);
-    if (info_flow_exists(iferret,T0_BASE, 1)) {
-      squeal_about_exfiltration(T0_BASE,1);
-    }
-    break;
+// iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDSB_T1_A0,MEMSUFFIXNUM,phys_a0(A0));
+// ditto, but signed.
+IF_OP(IFLO_OPS_MEM_LDSB_T1_A0) {
+  assert_args_1444444(op);
+  if_lds(iferret,a0_8,IFRN_T1,1,a1_32);
+  if_tainted_ptr(iferret,T1_BASE,A0_BASE,1);
+}
 
-  case IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_WORD_T0:
-    assert_args_0(op);
-    if (info_flow_exists(iferret,T0_BASE, 2)) {
-      squeal_about_exfiltration(T0_BASE,2);
-    }
-    break;
+// iferret_log_info_flow_op_write_18(IFLO_OPS_MEM_LDUW_T1_A0,MEMSUFFIXNUM,phys_a0(A0));
+// T1 = *A0, 2 bytes
+IF_OP(IFLO_OPS_MEM_LDUW_T1_A0) {
+  assert_args_1444444(op);
+  if_ldu(iferret,a0_8,IFRN_T1,2,a1_32);
+  if_tainted_ptr(iferret,T1_BASE,A0_BASE,2);
+}
 
-  case IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_LONG_T0:
-    assert_args_0(op);
-    if (info_flow_exists(iferret,T0_BASE, 4)) {
-      squeal_about_exfiltration(T0_BASE,4);
+// ditto, but signed.
+IF_OP(IFLO_OPS_MEM_LDSW_T1_A0) {
+  assert_args_1444444(op);
+  if_lds(iferret,a0_8,IFRN_T1,2,a1_32);
+  if_tainted_ptr(iferret,T1_BASE,A0_BASE,2);
+}
+
+// T1 = *A0, 4 bytes
+IF_OP(IFLO_OPS_MEM_LDL_T1_A0) {
+  assert_args_1444444(op);
+  if_ldu(iferret,a0_8,IFRN_T1,4,a1_32);
+  if_tainted_ptr(iferret,T1_BASE,A0_BASE,4);
+}
+
+// *A0 = T0, one byte
+IF_OP(IFLO_OPS_MEM_STB_T0_A0) {
+  assert_args_1444444(op);
+  if_st(iferret,a0_8,IFRN_T0,1,a1_32);
+}
+
+// two bytes.
+IF_OP(IFLO_OPS_MEM_STW_T0_A0) {
+  assert_args_1444444(op);
+  if_st(iferret,a0_8,IFRN_T0,2,a1_32);
+}
+
+// all four bytes
+IF_OP(IFLO_OPS_MEM_STL_T0_A0) {
+  assert_args_1444444(op);
+  if_st(iferret,a0_8,IFRN_T0,4,a1_32);
+}
+
+IF_OP(IFLO_OPS_MEM_STW_T1_A0) {
+  assert_args_1444444(op);
+  if_st(iferret,a0_8,IFRN_T1,2,a1_32);
+}
+
+IF_OP(IFLO_OPS_MEM_STL_T1_A0) {
+  assert_args_1444444(op);
+  if_st(iferret,a0_8,IFRN_T1,4,a1_32);
+}
+
+/*
+  Done handling ops_mem.h stuff.
+*/
+
+// raincheck
+// EIP = T0;
+// check here that EIP isn't tainted?
+IF_OP(IFLO_JMP_T0) {
+  assert_args_4(op);
+  if_copy_r4(iferret,IFRN_EIP,IFRN_T0);
+}
+
+// EIP = (uint32_t)PARAM1;
+IF_OP(IFLO_MOVL_EIP_IM) {
+  assert_args_4(op);
+  if_delete_r4(iferret,IFRN_EIP);
+}
+
+/*
+  Skipping 64-bit
+  op_movq_eip_im
+  op_movq_eip_im64
+*/
+
+/*
+  No info-flow for
+  op_hlt;
+  op_monitor;
+  op_mwait;
+  op_debug;
+  op_raise_interrupt;
+  op_raise_exception;
+  op_into;
+  op_cli;
+  op_sti;
+  op_set_inhibit_irq;
+  op_reset_inhibit_irq;
+  op_rsm;
+  op_boundw;  (Really?)
+  op_boundl;  (Really?)
+
+*/
+
+
+//    eflags = cc_table[CC_OP].compute_all();
+//    d = ldq(A0);
+//    if (d == (((uint64_t)EDX << 32) | EAX)) {
+// // part_1 corresponds to this branch
+//        iferret_log_info_flow_op_write_4(IFLO_CMPXCHG8B_PART1, phys_a0());
+//        stq(A0, ((uint64_t)ECX << 32) | EBX);
+//        eflags |= CC_Z;
+//	...
+//    } else {
+//        EDX = d >> 32;
+//        EAX = d;
+//	iferret_log_info_flow_op_write_0(IFLO_CMPXCHG8B_PART2);
+//    }
+
+IF_OP(IFLO_CMPXCHG8B_PART1) {
+  assert_args_4(op);
+  if_st(iferret,0,IFRN_EBX,4,a0_32);
+  if_st(iferret,0,IFRN_ECX,4,a0_32+4);
+}
+
+IF_OP(IFLO_CMPXCHG8B_PART2) {
+  assert_args_4(op);
+  if_ldu(iferret,0,IFRN_EAX,4,a0_32);
+  if_ldu(iferret,0,IFRN_EDX,4,a0_32+4);
+}
+
+// T0 = 0;
+IF_OP(IFLO_MOVL_T0_0) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_T0);
+}
+
+/*
+  Start handling includes of ops_template.h into op.c
+
+  Time for all those multiple size ops
+  i.e. the 4 different includes of ops_template.h in op.c
+  for SHIFT = 0,1,2,3
+  which turns into q,l,w,b in ops_template.h
+*/
+
+/*
+  These are all about computing cc (flags).
+  Taking a rain check for now.
+  compute_all_add
+  compute_c_add
+  compute_all_adc
+  compute_c_adc
+  compute_all_sub
+  compute_c_sub
+  compute_all_sbb
+  compute_c_sbb
+  compute_all_logic
+  compute_all_inc
+  compute_c_inc
+  compute_all_dec
+  compute_all_shl
+  compute_c_shl
+  compute_c_sar
+  compute_all_sar
+  compute_c_mul
+  compute_all_mul
+
+  These are jumps.  Also taking a raincheck.
+  op_jb_sub
+  op_jz_sub
+  op_jnz_sub
+  op_jbe_sub
+  op_js_sub
+  op_jl_sub
+  op_jle_sub
+
+  Loops get a raincheck, too.
+  op_loopnz
+  op_loopz
+  op_jz_ecx
+  op_jnz_ecx
+*/
+
+// raincheck
+// these are all about setting T0 to true/false
+// based upon the relationships between condition codes.
+// T0 = ((DATA_TYPE)src1 < (DATA_TYPE)src2);
+// T0 = ((DATA_TYPE)CC_DST == 0);
+// T0 = ((DATA_TYPE)src1 <= (DATA_TYPE)src2);
+// T0 = lshift(CC_DST, -(DATA_BITS - 1)) & 1;
+// T0 = ((DATA_STYPE)src1 < (DATA_STYPE)src2);
+// NB: a0_8 is SHIFT);
+IF_OP(IFLO_OPS_TEMPLATE_SETB_T0_SUB, IFLO_OPS_TEMPLATE_SETZ_T0_SUB, IFLO_OPS_TEMPLATE_SETBE_T0_SUB, IFLO_OPS_TEMPLATE_SETS_T0_SUB, IFLO_OPS_TEMPLATE_SETL_T0_SUB) {
+  // A0 += ((DATA_STYPE)T1 >> (3 + SHIFT)) << SHIFT;
+  if_self_compute_r4(iferret,IFRN_A0,IFRN_T1);
+}
+
+// weird shit.
+//    res = T0 & DATA_MASK;
+//    if (res != 0) {
+//    count = 0;
+//    while ((res & 1) == 0) {
+//        count++;
+//        res >>= 1;
+//    }
+//    iferret_log_info_flow_op_write_1(IFLO_OPS_TEMPLATE_BSF_T0_CC,SHIFT);
+//    T1 = count;
+IF_OP(IFLO_OPS_TEMPLATE_BSF_T0_CC, IFLO_OPS_TEMPLATE_BSR_T0_CC) {
+  assert_args_1(op);
+  if_delete_r4(iferret,IFRN_T1);
+  if_compute_r4(iferret,IFRN_T1,IFRN_T0);
+}
+
+// raincheck.
+// DF is "direction flag"
+// T0 = DF << SHIFT;
+IF_OP(IFLO_OPS_TEMPLATE_MOVL_T0_DSHIFT) {
+  assert_args_1(op);
+  if_delete_r4(iferret,IFRN_T0);
+}
+
+
+IF_OP(IFLO_HD_TRANSFER_PART1_T0_BASE) {
+  assert_args_0(op);
+#if IF_DEBUG >= IF_DEBUG_LOW
+  printf ("IFLO_HD_TRANSFER_PART1_T0_BASE = %llx\n", ctull(T0_BASE));
+#endif
+  iferret->last_hd_transfer_from = T0_BASE;
+}
+
+
+IF_OP(IFLO_HD_TRANSFER_PART1_T1_BASE) {
+  assert_args_0(op);
+#if IF_DEBUG >= IF_DEBUG_LOW
+  printf ("IFLO_HD_TRANSFER_PART1_T1_BASE = %llx\n", ctull(T1_BASE));
+#endif
+  iferret->last_hd_transfer_from = T1_BASE;
+}
+
+
+IF_OP(IFLO_HD_TRANSFER_PART2) {
+  assert_args_81(op);
+  // (to,size): (a0_64,a1_8)
+  // make use of saved from address.
+#if IF_DEBUG >= IF_DEBUG_LOW
+  printf ("info flow op: IFLO_HD_TRANSFER P12 %llx -> %llx num=%d\n",
+          ctull(iferret->last_hd_transfer_from), ctull(a0_64), (int)a1_8);
+#endif
+  if (!check_addr(a0_64))
+    return;
+  if (iferret->last_hd_transfer_from != 0 && check_addr(iferret->last_hd_transfer_from)) {
+#if IF_DEBUG >= IF_DEBUG_LOW
+    if (info_flow_exists(iferret,iferret->last_hd_transfer_from, a1_8)) {
+      printf ("IFLO_HD_TRANSFER_PART2 from tainted:\n");
+    }
+    if (info_flow_exists(iferret,a0_64, a1_8)) {
+      printf ("IFLO_HD_TRANSFER_PART2 to tainted:\n");
     }
-    break;
-        
+#endif
+    info_flow_copy(iferret, a0_64, iferret->last_hd_transfer_from, a1_8);
+  }
+}
 
-    // network input.  add labels...  
-  case IFLO_OPS_TEMPLATE_NETWORK_INPUT_BYTE_T0:
-    assert_args_4(op);
-    info_flow_label(iferret, T0_BASE, 1, "NETWORK");
-    break;
+// nothing logs these yet (see the IFLW_HD_TRANSFER in hw/ide.c), 
+// so they aren't ops.  make_iferret_code.pl skips handlers in #if 0.
+#if 0
+IF_OP(IFLO_HD_TRANSFER_PART1) {
+  assert_args_8(op);
+  // (from)
+  // save the from address?
+#if IF_DEBUG >= IF_DEBUG_LOW
+  printf ("IFLO_HD_TRANSFER_PART1 = %llx\n", ctull(a0_64));
+#endif
+  iferret->last_hd_transfer_from = a0_64;
+}
 
-  case IFLO_OPS_TEMPLATE_NETWORK_INPUT_WORD_T0:
-    assert_args_4(op);
-    info_flow_label(iferret, T0_BASE, 2, "NETWORK");
-    break;
+IF_OP(IFLO_HD_TRANSFER) {
+  assert_args_884(op);
+  // (from,to,size): (a0_64,a1_64,a2_32)
+  // NB: from could be HD or io buffer and to could be either.
+#if IF_DEBUG >= IF_DEBUG_LOW
+  printf ("info flow op: IFLO_HD_TRANSFER %llx -> %llx num=%d\n",
+          ctull(a0_64), ctull(a1_64), a2_32);
+#endif
+  if (!check_addr(a0_64) || !check_addr(a1_64) || !check_size(a2_32))
+    return;
+  info_flow_copy(iferret,a1_64,a0_64,a2_32);
+#if IF_DEBUG >= IF_DEBUG_LOW
+  if (info_flow_exists(iferret,a0_64, a2_32)) {
+    printf ("IFLO_HD_TRANSFER from tainted:\n");
+  }
+  if (info_flow_exists(iferret,a1_64, a2_32)) {
+    printf ("IFLO_HD_TRANSFER to tainted:\n");
+  }
+#endif
+}
+#endif
 
-  case IFLO_OPS_TEMPLATE_NETWORK_INPUT_LONG_T0:
-    assert_args_4(op);
-    info_flow_label(iferret, T0_BASE, 4, "NETWORK");
-    break;
 
-  case IFLO_OPS_TEMPLATE_NETWORK_INPUT_BYTE_T1:
-    assert_args_4(op);
-    info_flow_label(iferret, T1_BASE, 1, "NETWORK");
-    break;
+// network output.  what do we do?
+IF_OP(IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_BYTE_T1) {
+  assert_args_0(op);
+  if (info_flow_exists(iferret,T1_BASE, 1)) {
+    squeal_about_exfiltration(iferret,T1_BASE,1);
+  }
+}
 
-  case IFLO_OPS_TEMPLATE_NETWORK_INPUT_WORD_T1:
-    assert_args_4(op);
-    info_flow_label(iferret, T1_BASE, 2, "NETWORK");
-    break;
+IF_OP(IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_WORD_T1) {
+  assert_args_0(op);
+  if (info_flow_exists(iferret,T1_BASE, 2)) {
+    squeal_about_exfiltration(iferret,T1_BASE,2);
+  }
+}
 
-  case IFLO_OPS_TEMPLATE_NETWORK_INPUT_LONG_T1:
-    assert_args_4(op);
-    info_flow_label(iferret, T1_BASE, 4, "NETWORK");
-    break;
+IF_OP(IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_LONG_T1) {
+  assert_args_0(op);
+  if (info_flow_exists(iferret,T1_BASE, 4)) {
+    squeal_about_exfiltration(iferret,T1_BASE,4);
+  }
+}
 
+IF_OP(IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_BYTE_T0) {
+  assert_args_0(op);
+  if (info_flow_exists(iferret,T0_BASE, 1)) {
+    squeal_about_exfiltration(iferret,T0_BASE,1);
+  }
+}
 
+IF_OP(IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_WORD_T0) {
+  assert_args_0(op);
+  if (info_flow_exists(iferret,T0_BASE, 2)) {
+    squeal_about_exfiltration(iferret,T0_BASE,2);
+  }
+}
 
+IF_OP(IFLO_OPS_TEMPLATE_NETWORK_OUTPUT_LONG_T0) {
+  assert_args_0(op);
+  if (info_flow_exists(iferret,T0_BASE, 4)) {
+    squeal_about_exfiltration(iferret,T0_BASE,4);
+  }
+}
 
-  case IFLO_OPS_TEMPLATE_IN_T0_T1: 
-    assert_args_1(op);
-    // port i/o 
-    // specific cases handled elsewhere (network, hd, e.g.)
-    if_delete_r4(iferret,IFRN_T1);
-    break;
-    
-  case IFLO_OPS_TEMPLATE_IN_DX_T0:
-    assert_args_1(op);
-    // again, port i/o
-    if_delete_r4(iferret,IFRN_T0);    
-    break;
 
-    /*
-      Done handling includes of ops_template.h into op.c
-    */
+// network input.  add labels...
+IF_OP(IFLO_OPS_TEMPLATE_NETWORK_INPUT_BYTE_T0) {
+  assert_args_4(op);
+  info_flow_label(iferret, T0_BASE, 1, "NETWORK");
+}
 
-    // T0 = (int8_t)T0;
-  case IFLO_MOVSBL_T0_T0:
-    assert_args_0(op);
-    // sign extension?
-    if_inc_r4(iferret,IFRN_T0);
-    break;
+IF_OP(IFLO_OPS_TEMPLATE_NETWORK_INPUT_WORD_T0) {
+  assert_args_4(op);
+  info_flow_label(iferret, T0_BASE, 2, "NETWORK");
+}
 
-    // T0 = (uint8_t)T0;
-  case IFLO_MOVZBL_T0_T0:
-    assert_args_0(op);
-    // clear top 3 bytes
-    if_delete_reg_aux(iferret,IFRN_T0,1,3);
-    break;
+IF_OP(IFLO_OPS_TEMPLATE_NETWORK_INPUT_LONG_T0) {
+  assert_args_4(op);
+  info_flow_label(iferret, T0_BASE, 4, "NETWORK");
+}
 
-    // T0 = (int16_t)T0;
-  case IFLO_MOVSWL_T0_T0:
-    assert_args_0(op);
-    if_inc_r4(iferret,IFRN_T0);
-    break;
+IF_OP(IFLO_OPS_TEMPLATE_NETWORK_INPUT_BYTE_T1) {
+  assert_args_4(op);
+  info_flow_label(iferret, T1_BASE, 1, "NETWORK");
+}
 
-    // T0 = (uint16_t)T0;    
-  case IFLO_MOVZWL_T0_T0:
-    assert_args_0(op);
-    if_delete_reg_aux(iferret,IFRN_T0,2,2);
-    break;
+IF_OP(IFLO_OPS_TEMPLATE_NETWORK_INPUT_WORD_T1) {
+  assert_args_4(op);
+  info_flow_label(iferret, T1_BASE, 2, "NETWORK");
+}
 
-    // EAX = (uint32_t)((int16_t)EAX);
-  case IFLO_MOVSWL_EAX_AX:
-    assert_args_0(op);
-    // sign extend and then mask?
-    if_inc_r4(iferret,IFRN_EAX);
-    break;
+IF_OP(IFLO_OPS_TEMPLATE_NETWORK_INPUT_LONG_T1) {
+  assert_args_4(op);
+  info_flow_label(iferret, T1_BASE, 4, "NETWORK");
+}
 
-    /*
-      Skipping 64-bit stuff.
-      op_movslq_T0_T0
-      op_moslq_RAX_EAX
-    */
 
-    // wtf, mate?
-    // EAX = (EAX & ~0xffff) | ((int8_t)EAX & 0xffff);
-  case IFLO_MOVSBW_AX_AL:
-    assert_args_0(op);
-    if_inc_r4(iferret,IFRN_EAX);
-    break;
+IF_OP(IFLO_OPS_TEMPLATE_IN_T0_T1) {
+  assert_args_144(op);
+  // port i/o
+  // specific cases handled elsewhere (network, hd, e.g.)
+  if_delete_r4(iferret,IFRN_T1);
+}
 
-    // wtf isnt this a 64-bit op? 
-    // EDX = (uint32_t)((int32_t)EAX >> 31);
-  case IFLO_MOVSLQ_EDX_EAX:
-    assert_args_0(op);
-    if_self_compute_r4(iferret,IFRN_EDX,IFRN_EAX);
-    break;
+IF_OP(IFLO_OPS_TEMPLATE_IN_DX_T0) {
+  assert_args_144(op);
+  // again, port i/o
+  if_delete_r4(iferret,IFRN_T0);
+}
 
-    // EDX = (EDX & ~0xffff) | (((int16_t)EAX >> 15) & 0xffff);
-  case IFLO_MOVSWL_DX_AX:
-    assert_args_0(op);
-    if_self_compute_r4(iferret,IFRN_EDX,IFRN_EAX);
-    break;    
+/*
+  Done handling includes of ops_template.h into op.c
+*/
 
-    /*
-      Skipping 64-bit stuff.
-      op_movsqo_RDX_RAX
-    */
+// T0 = (int8_t)T0;
+IF_OP(IFLO_MOVSBL_T0_T0) {
+  assert_args_0(op);
+  // sign extension?
+  if_inc_r4(iferret,IFRN_T0);
+}
 
-    // ESI = (uint32_t)(ESI + T0);
-  case IFLO_ADDL_ESI_T0:
-    assert_args_0(op);
-    if_self_compute_r4(iferret,IFRN_ESI,IFRN_T0);
-    break;
+// T0 = (uint8_t)T0;
+IF_OP(IFLO_MOVZBL_T0_T0) {
+  assert_args_0(op);
+  // clear top 3 bytes
+  if_delete_reg_aux(iferret,IFRN_T0,1,3);
+}
 
-    // ESI = (ESI & ~0xffff) | ((ESI + T0) & 0xffff);
-  case IFLO_ADDW_ESI_T0:
-    assert_args_0(op);
-    if_self_compute_r2(iferret,IFRN_ESI,IFRN_T0);
-    break;
+// T0 = (int16_t)T0;
+IF_OP(IFLO_MOVSWL_T0_T0) {
+  assert_args_0(op);
+  if_inc_r4(iferret,IFRN_T0);
+}
 
-    // EDI = (uint32_t)(EDI + T0);
-  case IFLO_ADDL_EDI_T0:
-    assert_args_0(op);
-    if_self_compute_r4(iferret,IFRN_EDI,IFRN_T0);
-    break;
+// T0 = (uint16_t)T0;
+IF_OP(IFLO_MOVZWL_T0_T0) {
+  assert_args_0(op);
+  if_delete_reg_aux(iferret,IFRN_T0,2,2);
+}
 
-    // EDI = (EDI & ~0xffff) | ((EDI + T0) & 0xffff);
-  case IFLO_ADDW_EDI_T0:
-    assert_args_0(op);
-    if_self_compute_r2(iferret,IFRN_EDI,IFRN_T0);
-    break;
+// EAX = (uint32_t)((int16_t)EAX);
+IF_OP(IFLO_MOVSWL_EAX_AX) {
+  assert_args_0(op);
+  // sign extend and then mask?
+  if_inc_r4(iferret,IFRN_EAX);
+}
 
-    // ECX = (uint32_t)(ECX - 1);
-  case IFLO_DECL_ECX:
-    assert_args_0(op);
-    if_inc_r4(iferret,IFRN_ECX);
-    break;
+/*
+  Skipping 64-bit stuff.
+  op_movslq_T0_T0
+  op_moslq_RAX_EAX
+*/
 
-    // ECX = (ECX & ~0xffff) | ((ECX - 1) & 0xffff);
-  case IFLO_DECW_ECX:
-    assert_args_0(op);
-    if_inc_r4(iferret,IFRN_ECX);
-    break;
+// wtf, mate?
+// EAX = (EAX & ~0xffff) | ((int8_t)EAX & 0xffff);
+IF_OP(IFLO_MOVSBW_AX_AL) {
+  assert_args_0(op);
+  if_inc_r4(iferret,IFRN_EAX);
+}
 
-    /*
-      Skipping 64-bit stuff.
-      op_addq_ESI_T0
-      op_addq_EDI_T0
-      op_decq_ECX
-    */
+// wtf isnt this a 64-bit op?
+// EDX = (uint32_t)((int32_t)EAX >> 31);
+IF_OP(IFLO_MOVSLQ_EDX_EAX) {
+  assert_args_0(op);
+  if_self_compute_r4(iferret,IFRN_EDX,IFRN_EAX);
+}
 
-    // A0 = (uint32_t)(A0 + env->segs[R_SS].base);
-  case IFLO_ADDL_A0_SS:
-    assert_args_8(op);
-    info_flow_compute(iferret,a0_64,4,A0_BASE,4);
-    break;
+// EDX = (EDX & ~0xffff) | (((int16_t)EAX >> 15) & 0xffff);
+IF_OP(IFLO_MOVSWL_DX_AX) {
+  assert_args_0(op);
+  if_self_compute_r4(iferret,IFRN_EDX,IFRN_EAX);
+}
 
-    // A0 = (uint32_t)(A0 - 2);
-  case IFLO_SUBL_A0_2:
-    // A0 = (uint32_t)(A0 - 4);
-  case IFLO_SUBL_A0_4:
-    assert_args_0(op);
-    if_inc_r4(iferret,IFRN_A0);
-    break;
-
-    // ESP = (uint32_t)(ESP + 4)
-  case IFLO_ADDL_ESP_4:
-    // ESP = (uint32_t)(ESP + 2);
-  case IFLO_ADDL_ESP_2:
-    // ESP = (ESP & ~0xffff) | ((ESP + 4) & 0xffff);
-  case IFLO_ADDW_ESP_4:
-    // ESP = (ESP & ~0xffff) | ((ESP + 2) & 0xffff);
-  case IFLO_ADDW_ESP_2:
-    assert_args_0(op);
-    if_inc_r4(iferret,IFRN_ESP);
-    break;
+/*
+  Skipping 64-bit stuff.
+  op_movsqo_RDX_RAX
+*/
 
-    // ESP = (uint32_t)(ESP + PARAM1);
-  case IFLO_ADDL_ESP_IM:
-    // ESP = (ESP & ~0xffff) | ((ESP + PARAM1) & 0xffff);
-  case IFLO_ADDW_ESP_IM:
-    assert_args_4(op);
-    if_inc_r4(iferret,IFRN_ESP);
-    break;
+// ESI = (uint32_t)(ESI + T0);
+IF_OP(IFLO_ADDL_ESI_T0) {
+  assert_args_0(op);
+  if_self_compute_r4(iferret,IFRN_ESI,IFRN_T0);
+}
 
-    /*
-      Skipping 64-bit stuff.
-      op_subq_A0_2
-      op_subq_A0_8
-      op_addq_ESP_8
-      op_addq_ESP_im
-    */
+// ESI = (ESI & ~0xffff) | ((ESI + T0) & 0xffff);
+IF_OP(IFLO_ADDW_ESI_T0) {
+  assert_args_0(op);
+  if_self_compute_r2(iferret,IFRN_ESI,IFRN_T0);
+}
 
-    // helper_rdtsc();
-  case IFLO_RDTSC:
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_EAX);
-    if_delete_r4(iferret,IFRN_EDX);
-    break;
+// EDI = (uint32_t)(EDI + T0);
+IF_OP(IFLO_ADDL_EDI_T0) {
+  assert_args_0(op);
+  if_self_compute_r4(iferret,IFRN_EDI,IFRN_T0);
+}
 
-    // helper_cpuid();    
-  case IFLO_CPUID:
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_EAX);
-    if_delete_r4(iferret,IFRN_EBX);
-    if_delete_r4(iferret,IFRN_ECX);
-    if_delete_r4(iferret,IFRN_EDX);
-    break;
-
-    // rainchek    
-    // helper_enter_level(PARAM1, PARAM2);
-  case IFLO_ENTER_LEVEL:
-    // helper_sysenter();
-  case IFLO_SYSENTER:
-    // helper_sysexit();
-  case IFLO_SYSEXIT:
-    break;
+// EDI = (EDI & ~0xffff) | ((EDI + T0) & 0xffff);
+IF_OP(IFLO_ADDW_EDI_T0) {
+  assert_args_0(op);
+  if_self_compute_r2(iferret,IFRN_EDI,IFRN_T0);
+}
 
-    /*
-      Skipping 64-bit stuff.
-      op_enter64_level;
-      op_syscall;
-      op_sysret;
-    */
+// ECX = (uint32_t)(ECX - 1);
+IF_OP(IFLO_DECL_ECX) {
+  assert_args_0(op);
+  if_inc_r4(iferret,IFRN_ECX);
+}
 
-    // raincheck
-    // helper_rdmsr();
-  case IFLO_RDMSR:
-    // helper_wrmsr();
-  case IFLO_WRMSR:
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_EAX);
-    if_delete_r4(iferret,IFRN_EDX);
-    break;
-
-    // raincheck
-    // bcd shite.  please.
-  case IFLO_AAM:
-  case IFLO_AAD:
-  case IFLO_AAA:
-  case IFLO_AAS:
-  case IFLO_DAA:
-  case IFLO_DAS:
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_EAX);
-    break;
-
-    // raincheck
-    // segment handling stuff
-  case IFLO_MOVL_SEG_T0:
-  case IFLO_MOVL_SEG_T0_VM:
-    assert_args_4(op);
-    break;
-
-    // T0 = env->segs[PARAM1].selector;
-  case IFLO_MOVL_T0_SEG:
-    assert_args_4(op);
-    if_delete_r4(iferret,IFRN_T0);
-    break;
-
-    // rainchek
-  case IFLO_LSL:
-    assert_args_0(op);
-    // load segment limit
-    //    T1 = limit;
-    if_delete_r4(iferret,IFRN_T1);
-    break;
+// ECX = (ECX & ~0xffff) | ((ECX - 1) & 0xffff);
+IF_OP(IFLO_DECW_ECX) {
+  assert_args_0(op);
+  if_inc_r4(iferret,IFRN_ECX);
+}
 
-  case IFLO_LAR:
-    assert_args_0(op);
-    // load access rights byte
-    //    T1 = e2 & 0x00f0ff00;
-    if_delete_r4(iferret,IFRN_T1);
-    break;
+/*
+  Skipping 64-bit stuff.
+  op_addq_ESI_T0
+  op_addq_EDI_T0
+  op_decq_ECX
+*/
 
-    /*
-      no info flow for?
-      op_verr
-      op_verw
-    */
+// A0 = (uint32_t)(A0 + env->segs[R_SS].base);
+IF_OP(IFLO_ADDL_A0_SS) {
+  assert_args_8(op);
+  if (!check_addr(a0_64))
+    return;
+  info_flow_compute(iferret,a0_64,4,A0_BASE,4);
+}
 
-  case IFLO_ARPL_CASE_1:
-    assert_args_0(op);
-    if_self_compute_r4(iferret,IFRN_T0, IFRN_T1);
-    if_delete_r4(iferret,IFRN_T1);
-    break;
+// A0 = (uint32_t)(A0 - 2);
+// A0 = (uint32_t)(A0 - 4);
+IF_OP(IFLO_SUBL_A0_2, IFLO_SUBL_A0_4) {
+  assert_args_0(op);
+  if_inc_r4(iferret,IFRN_A0);
+}
 
-  case IFLO_ARPL_CASE_2:
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_T1);
-    break;
-
-    // raincheck
-  case IFLO_LJMP_PROTECTED_T0_T1:
-    // protected mode jump
-  case IFLO_LCALL_REAL_T0_T1:
-    // real mode call
-  case IFLO_LCALL_PROTECTED_T0_T1:
-    // protected mode call
-  case IFLO_IRET_REAL:
-    // real & vm86 mode iret
-  case IFLO_IRET_PROTECTED:
-    // protected mode iret
-  case IFLO_LRET_PROTECTED:
-    // punt.
-    assert_args_0(op);
-    break;
-
-    // raincheck
-  case IFLO_LLDT_T0:
-    // load local descriptor table
-  case IFLO_LTR_T0:
-    // load task descriptor table
-  case IFLO_MOVL_CRN_T0:
-    // punting again. 
-    assert_args_0(op);
-    break;
+// ESP = (uint32_t)(ESP + 4)
+// ESP = (uint32_t)(ESP + 2);
+// ESP = (ESP & ~0xffff) | ((ESP + 4) & 0xffff);
+// ESP = (ESP & ~0xffff) | ((ESP + 2) & 0xffff);
+IF_OP(IFLO_ADDL_ESP_4, IFLO_ADDL_ESP_2, IFLO_ADDW_ESP_4, IFLO_ADDW_ESP_2) {
+  assert_args_0(op);
+  if_inc_r4(iferret,IFRN_ESP);
+}
 
-    // raincheck
-  case IFLO_MOVTL_T0_CR8:
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_T0);
-    break;
+// ESP = (uint32_t)(ESP + PARAM1);
+// ESP = (ESP & ~0xffff) | ((ESP + PARAM1) & 0xffff);
+IF_OP(IFLO_ADDL_ESP_IM, IFLO_ADDW_ESP_IM) {
+  assert_args_4(op);
+  if_inc_r4(iferret,IFRN_ESP);
+}
 
-    // raincheck
-  case IFLO_MOVL_DRN_T0:
-    assert_args_0(op);
-    // punt 
-    break;
+/*
+  Skipping 64-bit stuff.
+  op_subq_A0_2
+  op_subq_A0_8
+  op_addq_ESP_8
+  op_addq_ESP_im
+*/
 
-    // raincheck
-  case IFLO_LMSW_T0:
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_T0);
-    break;
+// helper_rdtsc();
+IF_OP(IFLO_RDTSC) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_EAX);
+  if_delete_r4(iferret,IFRN_EDX);
+}
 
-    // raincheck
-  case IFLO_INVLPG_A0:
-    assert_args_0(op);
-    // punt
-    break;
+// helper_cpuid();
+IF_OP(IFLO_CPUID) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_EAX);
+  if_delete_r4(iferret,IFRN_EBX);
+  if_delete_r4(iferret,IFRN_ECX);
+  if_delete_r4(iferret,IFRN_EDX);
+}
 
-    /*
-      NB:using memsufix=_raw here?
-    */
-    
-    // T0 = *(uint32_t *)((char *)env + PARAM1);
-  case IFLO_MOVL_T0_ENV:
-    assert_args_84(op);
-    if_ldu(iferret,0, IFRN_T0, 4, a0_64);
-    break;
-
-    // *(uint32_t *)((char *)env + PARAM1) = T0;
-  case IFLO_MOVL_ENV_T0:
-    assert_args_84(op);
-    if_st(iferret,0, IFRN_T0, 4, a0_64);
-    break;
-
-    // *(uint32_t *)((char *)env + PARAM1) = T1;
-  case IFLO_MOVL_ENV_T1:
-    assert_args_84(op);
-    if_st(iferret,0, IFRN_T1, 4, a0_64);
-    break;
-
-    // T0 = *(target_ulong *)((char *)env + PARAM1);
-  case IFLO_MOVTL_T0_ENV:
-    assert_args_84(op);
-    if_ldu(iferret,0, IFRN_T0, 4, a0_64);
-    break;
-
-    // *(target_ulong *)((char *)env + PARAM1) = T0;
-  case IFLO_MOVTL_ENV_T0:
-    assert_args_84(op);
-    if_st(iferret,0, IFRN_T0, 4, a0_64);
-    break;
-
-    // T1 = *(target_ulong *)((char *)env + PARAM1);
-  case IFLO_MOVTL_T1_ENV:
-    assert_args_84(op);
-    if_ldu(iferret,0, IFRN_T1, 4, a0_64);
-    break;
-
-    // *(target_ulong *)((char *)env + PARAM1) = T1;
-  case IFLO_MOVTL_ENV_T1:
-    assert_args_84(op);
-    if_st(iferret,0, IFRN_T1, 4, a0_64);
-    break;
-
-    // raincheck
-  case IFLO_CLTS:
-    assert_args_0(op);
-    break; 
-
-    /* 
-       No info flow for
-       op_goto_tb0
-       op_goto_tb1
-       op_jmp_label
-       op_jnz_T0_label  IMPLICIT INFO-FLOW???
-       op_jz_T0_label   DITTO!
-    */
+// rainchek
+// helper_enter_level(PARAM1, PARAM2);
+// helper_sysenter();
+// helper_sysexit();
+IF_OP(IFLO_ENTER_LEVEL, IFLO_SYSENTER, IFLO_SYSEXIT) {
+}
 
-    // raincheck
-  case IFLO_SETO_T0_CC:    
-  case IFLO_SETB_T0_CC:
-  case IFLO_SETZ_T0_CC:
-  case IFLO_SETBE_T0_CC:
-  case IFLO_SETS_T0_CC:
-  case IFLO_SETP_T0_CC:
-  case IFLO_SETL_T0_CC:
-  case IFLO_SETLE_T0_CC:
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_T0);
-    break;
-    
-    // T0 ^= 1
-  case IFLO_XOR_T0_1:
-    assert_args_0(op);
-    if_inc_r4(iferret,IFRN_T0);
-    break;
+/*
+  Skipping 64-bit stuff.
+  op_enter64_level;
+  op_syscall;
+  op_sysret;
+*/
 
-    /* 
-       No info flow for
-       op_set_cc_op
-    */
+// raincheck
+// helper_rdmsr();
+// helper_wrmsr();
+IF_OP(IFLO_RDMSR, IFLO_WRMSR) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_EAX);
+  if_delete_r4(iferret,IFRN_EDX);
+}
 
-  case IFLO_MOV_T0_CC:
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_T0);
-    break;
-
-    // raincheck
-    // these are all about eflags.
-    // no effect upon regular regs.  
-    // variants of eflags = t0
-  case IFLO_MOVL_EFLAGS_T0:
-  case IFLO_MOVW_EFLAGS_T0:
-  case IFLO_MOVL_EFLAGS_T0_IO:
-  case IFLO_MOVW_EFLAGS_T0_IO:
-  case IFLO_MOVL_EFLAGS_T0_CPL0:
-  case IFLO_MOVW_EFLAGS_T0_CPL0:
-  case IFLO_MOVB_EFLAGS_T0:
-    assert_args_0(op);
-    // punt.
-    break;
+// raincheck
+// bcd shite.  please.
+IF_OP(IFLO_AAM, IFLO_AAD, IFLO_AAA, IFLO_AAS, IFLO_DAA, IFLO_DAS) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_EAX);
+}
 
-    // raincheck
-    // t0 = eflags 
-  case IFLO_MOVL_T0_EFLAGS:
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_T0);
-    break;
+// raincheck
+// segment handling stuff
+IF_OP(IFLO_MOVL_SEG_T0, IFLO_MOVL_SEG_T0_VM) {
+  assert_args_4(op);
+}
 
-    /*
-      No info flow for the following
-      op_cld
-      op_std
-      op_clc
-      op_stc
-      op_cmc
-    */
+// T0 = env->segs[PARAM1].selector;
+IF_OP(IFLO_MOVL_T0_SEG) {
+  assert_args_4(op);
+  if_delete_r4(iferret,IFRN_T0);
+}
+
+// rainchek
+IF_OP(IFLO_LSL) {
+  assert_args_4(op);
+  // load segment limit
+  //    T1 = limit;
+  if_delete_r4(iferret,IFRN_T1);
+}
+
+IF_OP(IFLO_LAR) {
+  assert_args_4(op);
+  // load access rights byte
+  //    T1 = e2 & 0x00f0ff00;
+  if_delete_r4(iferret,IFRN_T1);
+}
+
+/*
+  no info flow for?
+  op_verr
+  op_verw
+*/
+
+IF_OP(IFLO_ARPL_CASE_1) {
+  assert_args_0(op);
+  if_self_compute_r4(iferret,IFRN_T0, IFRN_T1);
+  if_delete_r4(iferret,IFRN_T1);
+}
+
+IF_OP(IFLO_ARPL_CASE_2) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_T1);
+}
+
+// raincheck
+// protected mode jump
+// real mode call
+// protected mode call
+// real & vm86 mode iret
+// protected mode iret
+// punt.
+IF_OP(IFLO_LJMP_PROTECTED_T0_T1, IFLO_LCALL_REAL_T0_T1, IFLO_LCALL_PROTECTED_T0_T1, IFLO_IRET_REAL, IFLO_LRET_PROTECTED) {
+  assert_args_0(op);
+}
+
+IF_OP(IFLO_IRET_PROTECTED) {
+  assert_args_41(op);
+}
+
+// raincheck
+// load local descriptor table
+// load task descriptor table
+// punting again.
+IF_OP(IFLO_LLDT_T0, IFLO_LTR_T0) {
+  assert_args_0(op);
+}
+
+IF_OP(IFLO_MOVL_CRN_T0) {
+  assert_args_44(op);
+}
+
+// raincheck
+IF_OP(IFLO_MOVTL_T0_CR8) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_T0);
+}
+
+// raincheck
+IF_OP(IFLO_MOVL_DRN_T0) {
+  assert_args_0(op);
+  // punt
+}
+
+// raincheck
+IF_OP(IFLO_LMSW_T0) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_T0);
+}
+
+// raincheck
+IF_OP(IFLO_INVLPG_A0) {
+  assert_args_0(op);
+  // punt
+}
+
+/*
+  NB:using memsufix=_raw here?
+*/
+
+// T0 = *(uint32_t *)((char *)env + PARAM1);
+IF_OP(IFLO_MOVL_T0_ENV) {
+  assert_args_84(op);
+  if_ldu(iferret,0, IFRN_T0, 4, a0_64);
+}
+
+// *(uint32_t *)((char *)env + PARAM1) = T0;
+IF_OP(IFLO_MOVL_ENV_T0) {
+  assert_args_84(op);
+  if_st(iferret,0, IFRN_T0, 4, a0_64);
+}
+
+// *(uint32_t *)((char *)env + PARAM1) = T1;
+IF_OP(IFLO_MOVL_ENV_T1) {
+  assert_args_84(op);
+  if_st(iferret,0, IFRN_T1, 4, a0_64);
+}
+
+// T0 = *(target_ulong *)((char *)env + PARAM1);
+IF_OP(IFLO_MOVTL_T0_ENV) {
+  assert_args_84(op);
+  if_ldu(iferret,0, IFRN_T0, 4, a0_64);
+}
+
+// *(target_ulong *)((char *)env + PARAM1) = T0;
+IF_OP(IFLO_MOVTL_ENV_T0) {
+  assert_args_84(op);
+  if_st(iferret,0, IFRN_T0, 4, a0_64);
+}
+
+// T1 = *(target_ulong *)((char *)env + PARAM1);
+IF_OP(IFLO_MOVTL_T1_ENV) {
+  assert_args_84(op);
+  if_ldu(iferret,0, IFRN_T1, 4, a0_64);
+}
+
+// *(target_ulong *)((char *)env + PARAM1) = T1;
+IF_OP(IFLO_MOVTL_ENV_T1) {
+  assert_args_84(op);
+  if_st(iferret,0, IFRN_T1, 4, a0_64);
+}
+
+// raincheck
+IF_OP(IFLO_CLTS) {
+  assert_args_0(op);
+}
+
+/*
+   No info flow for
+   op_goto_tb0
+   op_goto_tb1
+   op_jmp_label
+   op_jnz_T0_label  IMPLICIT INFO-FLOW???
+   op_jz_T0_label   DITTO!
+*/
+
+// raincheck
+IF_OP(IFLO_SETO_T0_CC, IFLO_SETB_T0_CC, IFLO_SETZ_T0_CC, IFLO_SETBE_T0_CC, IFLO_SETS_T0_CC, IFLO_SETP_T0_CC, IFLO_SETL_T0_CC, IFLO_SETLE_T0_CC) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_T0);
+}
+
+// T0 ^= 1
+IF_OP(IFLO_XOR_T0_1) {
+  assert_args_0(op);
+  if_inc_r4(iferret,IFRN_T0);
+}
+
+/*
+   No info flow for
+   op_set_cc_op
+*/
+
+IF_OP(IFLO_MOV_T0_CC) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_T0);
+}
+
+// raincheck
+// these are all about eflags.
+// no effect upon regular regs.
+// variants of eflags = t0
+IF_OP(IFLO_MOVL_EFLAGS_T0, IFLO_MOVW_EFLAGS_T0, IFLO_MOVL_EFLAGS_T0_IO, IFLO_MOVW_EFLAGS_T0_IO, IFLO_MOVL_EFLAGS_T0_CPL0, IFLO_MOVW_EFLAGS_T0_CPL0, IFLO_MOVB_EFLAGS_T0) {
+  assert_args_0(op);
+  // punt.
+}
+
+// raincheck
+// t0 = eflags
+IF_OP(IFLO_MOVL_T0_EFLAGS) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_T0);
+}
+
+/*
+  No info flow for the following
+  op_cld
+  op_std
+  op_clc
+  op_stc
+  op_cmc
+*/
+
+IF_OP(IFLO_SALC) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_EAX);
+}
+
+/*
+  Skipping boat load of FPU ops
+*/
+
+// well, not quite.
+// hmm this one diddles with EAX.
+IF_OP(IFLO_FNSTSW_EAX) {
+  assert_args_0(op);
+  if_delete_r4(iferret,IFRN_EAX);
+}
+
+/*
+  Skipping threading support,
+  op_lock
+  op_unlock
+
+  Skipping SSE support,
+  op_movo
+  op_movl
+  etc etc
+*/
+
+IF_OP(IFLO_KEYBOARD_INPUT) {
+  //assert_args_1(op);
+  {
+    //char alabel[1024];
+    // construct a new keyboard label for each keycode.
 
-  case IFLO_SALC:
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_EAX);
-    break;
 
     /*
-      Skipping boat load of FPU ops
+    snprintf (alabel, 1024, "key-%s-%x-%x",
+              if_keyboard_label, if_key_num,if_key_val);
     */
-
-    // well, not quite. 
-    // hmm this one diddles with EAX.  
-  case IFLO_FNSTSW_EAX:
-    assert_args_0(op);
-    if_delete_r4(iferret,IFRN_EAX);
-    break;
+    //      push_key_label(alabel);
+    //      if_key_num ++;
+    //      if (debug_at_least_low()) {
 
     /*
-      Skipping threading support, 
-      op_lock
-      op_unlock
-
-      Skipping SSE support,
-      op_movo
-      op_movl
-      etc etc
+      printf ("IFLO_KEYBOARD_INPUT: if_p_orig=%p val=%x label=%s\n",
+              if_p_orig, if_key_val, alabel);
     */
-    
-  case IFLO_KEYBOARD_INPUT:
-    //assert_args_1(op);
-    {
-      //char alabel[1024];						        
-      // construct a new keyboard label for each keycode.
-            
-     
-      /*
-      snprintf (alabel, 1024, "key-%s-%x-%x", 
-		if_keyboard_label, if_key_num,if_key_val);
-      */
-      //      push_key_label(alabel);
-      //      if_key_num ++;      
-      //      if (debug_at_least_low()) {
-
-      /*
-	printf ("IFLO_KEYBOARD_INPUT: if_p_orig=%p val=%x label=%s\n", 
-		if_p_orig, if_key_val, alabel);
-      */
-	//      }
-	//      info_flow_label(T1_BASE, 1, alabel);
-      //   info_flow_label(iferret, T1_BASE, 1, "KEYBOARD");
-      //      info_flow_mark_as_possibly_tainted(IFRN_T1);      
-      
-      //      if (if_key_num == 3 && if_key_val == 0x2e) {
-      //      	foo2 = TRUE;
+      //      }
+      //      info_flow_label(T1_BASE, 1, alabel);
+    //   info_flow_label(iferret, T1_BASE, 1, "KEYBOARD");
+    //      info_flow_mark_as_possibly_tainted(IFRN_T1);
+
+    //      if (if_key_num == 3 && if_key_val == 0x2e) {
+    //      	foo2 = TRUE;
 //	if_debug_set_med();
-    }
-    break;
-    
-    /*    
-  case IFLO_SAVE_REG:
-    printf("We're saving regnum#%d to addr 0x%08x\r\n",a0_32,if_addr);
-    break;
-    */
-    
-    // iferret_log_info_flow_op_write_8844(IFLO_CPU_PHYSICAL_MEMORY_RW, addr, buf, len, is_write);
+  }
+}
+
+/*
+case IFLO_SAVE_REG:
+  printf("We're saving regnum#%d to addr 0x%08x\r\n",a0_32,if_addr);
+  break;
+*/
+
+// iferret_log_info_flow_op_write_8844(IFLO_CPU_PHYSICAL_MEMORY_RW, addr, buf, len, is_write);
 //  case IFLO_CPU_PHYSICAL_MEMORY_RW:
 //    assert_args_4844(op);
 //    // (addr,buf,len,iswrite) : (a0_32,a1_64,a2_32,a3_32)
 //    // a0 is a physical address in the guest, thus it is 32 bits.
-//    // a1 is a vitrual address in qemu's space.  thus it is 64 bits. 
+//    // a1 is a vitrual address in qemu's space.  thus it is 64 bits.
 //    if (a3_32 == 1) {
 //      // this is a write. a0 is dest, a1 is src.
 //      //info_flow_copy(iferret, phys_ram_base + a0_32, a1_64, a2_32);
 //      info_flow_copy(iferret, a0_32, a1_64, a2_32);
 //    }
 //    else {
-//      // this is a read.  a0 is source. a1 is dest.  
-//      //info_flow_copy(iferret, a1_64, phys_ram_base + a0_32, a2_32);		     
-//      info_flow_copy(iferret, a1_64, a0_32, a2_32);		     
+//      // this is a read.  a0 is source. a1 is dest.
+//      //info_flow_copy(iferret, a1_64, phys_ram_base + a0_32, a2_32);
+//      info_flow_copy(iferret, a1_64, a0_32, a2_32);
 //    }
 //    break;
 
-  case IFLO_TESTL_T0_T1_CC:
-    {
-      uint8_t t0t, t1t;
-      /*
-      assert_args_0(op);          
-      t0t = info_flow_exists(iferret, T0_BASE, 4);
-      t1t = info_flow_exists(iferret, T1_BASE, 4);
-      if (t0t || t1t) {
-	printf ("testl t0 t1. ");
-	if (t0t) printf ("t0 tainted. ");
-	if (t1t) printf ("t1 tainted. ");
-	printf ("\n");
-      }
-      */
+IF_OP(IFLO_TESTL_T0_T1_CC) {
+  {
+    uint8_t t0t, t1t;
+    /*
+    assert_args_0(op);
+    t0t = info_flow_exists(iferret, T0_BASE, 4);
+    t1t = info_flow_exists(iferret, T1_BASE, 4);
+    if (t0t || t1t) {
+      printf ("testl t0 t1. ");
+      if (t0t) printf ("t0 tainted. ");
+      if (t1t) printf ("t1 tainted. ");
+      printf ("\n");
     }
-
+    */
   }
+}
 
+#include "iferret_info_flow_dispatch.h"
 
+void iferret_info_flow_process_op(iferret_t *iferret, iferret_op_t *op) {
+  iferret_info_flow_handler_t h;
 
+  assert (op->num < IFLO_SYS_CALLS_START);
+  iferret->taint_events->op = op->num;
+  if ((h = iferret_info_flow_handler[op->num]) != NULL)
+    h(iferret, op, op->arg);
 }
-#endif
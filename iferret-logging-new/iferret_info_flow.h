@@ -1,7 +1,9 @@
 #ifndef __IFERRET_INFO_FLOW_H_
 #define __IFERRET_INFO_FLOW_H_
 
+#ifdef QAINT
 #include "taint.h"
+#endif
 #include "iferret.h"
 
 #define IF_DEBUG_OFF 0
@@ -10,6 +12,20 @@
 #define IF_DEBUG_HIGH 3
 #define IF_DEBUG_OMG 4
 
+// how much iferret_info_flow.c prints as it goes.  it's fixed when it's
+// compiled (-DIF_DEBUG=IF_DEBUG_LOW, say), so a build without it has no
+// debug tests in the propagation code at all.  what's worth hearing
+// about in any build goes to iferret->taint_events instead.
+#ifndef IF_DEBUG
+#define IF_DEBUG IF_DEBUG_OFF
+#endif
+
+#define debug_off() (IF_DEBUG == IF_DEBUG_OFF)
+#define debug_at_least_low() (IF_DEBUG >= IF_DEBUG_LOW)
+#define debug_at_least_med() (IF_DEBUG >= IF_DEBUG_MED)
+#define debug_at_least_high() (IF_DEBUG >= IF_DEBUG_HIGH)
+#define debug_at_least_omg() (IF_DEBUG >= IF_DEBUG_OMG)
+
 
 #define wctull(p) p
 
@@ -29,9 +45,14 @@ extern uint8_t iferret_debug;
 #define ctull(p) (unsigned long long) p
 
 void iferret_info_flow_process_op(iferret_t *iferret, iferret_op_t *op);
+// in iferret.c.  decodes iferret->log_prefix &c on one thread and
+// feeds the ops to iferret_info_flow_process_op on another
+void iferret_info_flow_run(iferret_t *iferret);
 
-#ifdef OTAINT
+#ifndef TRUE
 #define TRUE 1
+#endif
+#ifndef FALSE
 #define FALSE 0
 #endif
 
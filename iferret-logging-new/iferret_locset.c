@@ -0,0 +1,168 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "iferret_locset.h"
+
+#define IFERRET_LOCSET_NONE (~((uint64_t) 0))
+#define IFERRET_LOCSET_INIT_SIZE 64
+
+// every page that's all in a set points here
+static uint64_t iferret_locset_full;
+
+#define FULL (&iferret_locset_full)
+
+
+// Fibonacci hashing
+static inline uint64_t iferret_locset_hash(iferret_locset_t *s, uint64_t key) {
+  return (key * 11400714819323198485ULL) & (s->size - 1);
+}
+
+static void iferret_locset_grow(iferret_locset_t *s) {
+  uint64_t *old_key, **old_page;
+  uint64_t old_size, i, j;
+
+  old_key = s->key;
+  old_page = s->page;
+  old_size = s->size;
+  s->size = (old_size == 0) ? IFERRET_LOCSET_INIT_SIZE : 2 * old_size;
+  s->key = (uint64_t *) malloc(s->size * sizeof(uint64_t));
+  s->page = (uint64_t **) calloc(s->size, sizeof(uint64_t *));
+  assert (s->key != NULL && s->page != NULL);
+  memset(s->key, 0xff, s->size * sizeof(uint64_t));
+  for (i=0; i<old_size; i++) {
+    if (old_key[i] == IFERRET_LOCSET_NONE) continue;
+    for (j = iferret_locset_hash(s, old_key[i]); s->key[j] != IFERRET_LOCSET_NONE; j = (j + 1) & (s->size - 1));
+    s->key[j] = old_key[i];
+    s->page[j] = old_page[i];
+  }
+  free(old_key);
+  free(old_page);
+  s->last = 0;
+}
+
+// slot for page key, or IFERRET_LOCSET_NONE if there isn't one and we
+// weren't asked to make it
+static inline uint64_t iferret_locset_slot(iferret_locset_t *s, uint64_t key, int make) {
+  uint64_t j;
+
+  // runs of lookups tend to be in the same page
+  if (s->size != 0 && s->key[s->last] == key)
+    return s->last;
+  if (make && 2 * (s->num + 1) > s->size)
+    iferret_locset_grow(s);
+  if (s->size == 0)
+    return IFERRET_LOCSET_NONE;
+  for (j = iferret_locset_hash(s, key); s->key[j] != IFERRET_LOCSET_NONE; j = (j + 1) & (s->size - 1)) {
+    if (s->key[j] == key) {
+      s->last = j;
+      return j;
+    }
+  }
+  if (!make)
+    return IFERRET_LOCSET_NONE;
+  s->key[j] = key;
+  s->num ++;
+  s->last = j;
+  return j;
+}
+
+// bits a..b-1 of word w of a page
+static inline uint64_t iferret_locset_mask(uint32_t w, uint32_t a, uint32_t b) {
+  uint32_t lo = (a > w * 64) ? a - w * 64 : 0;
+  uint32_t hi = (b < (w + 1) * 64) ? b - w * 64 : 64;
+  uint64_t m = (hi == 64) ? ~((uint64_t) 0) : ((((uint64_t) 1) << hi) - 1);
+  return m & ~((((uint64_t) 1) << lo) - 1);
+}
+
+// which bits of page p lo..hi-1 covers: a..b-1
+static inline void iferret_locset_bits(uint64_t p, uint64_t lo, uint64_t hi, 
+                                       uint32_t *a, uint32_t *b) {
+  *a = (p == lo >> IFERRET_LOCSET_PAGE_BITS) ? (lo & (IFERRET_LOCSET_PAGE_SIZE - 1)) : 0;
+  *b = (p == (hi - 1) >> IFERRET_LOCSET_PAGE_BITS) ? 
+    ((hi - 1) & (IFERRET_LOCSET_PAGE_SIZE - 1)) + 1 : IFERRET_LOCSET_PAGE_SIZE;
+}
+
+// is any of lo..hi-1 in s?
+int iferret_locset_any(iferret_locset_t *s, uint64_t lo, uint64_t hi) {
+  uint64_t p, j, *page;
+  uint32_t a, b, w;
+
+  if (s->num_pages == 0 || lo >= hi) return 0;
+  for (p = lo >> IFERRET_LOCSET_PAGE_BITS; p <= (hi - 1) >> IFERRET_LOCSET_PAGE_BITS; p++) {
+    iferret_locset_bits(p, lo, hi, &a, &b);
+    j = iferret_locset_slot(s, p, 0);
+    if (j == IFERRET_LOCSET_NONE || (page = s->page[j]) == NULL) continue;
+    if (page == FULL) return 1;
+    for (w = a / 64; w <= (b - 1) / 64; w++) {
+      if (page[w] & iferret_locset_mask(w, a, b))
+        return 1;
+    }
+  }
+  return 0;
+}
+
+void iferret_locset_add(iferret_locset_t *s, uint64_t lo, uint64_t hi) {
+  uint64_t p, j, *page;
+  uint32_t a, b, w;
+
+  if (lo >= hi) return;
+  for (p = lo >> IFERRET_LOCSET_PAGE_BITS; p <= (hi - 1) >> IFERRET_LOCSET_PAGE_BITS; p++) {
+    iferret_locset_bits(p, lo, hi, &a, &b);
+    j = iferret_locset_slot(s, p, 1);
+    page = s->page[j];
+    if (page == FULL) continue;
+    if (page == NULL) s->num_pages ++;
+    if (a == 0 && b == IFERRET_LOCSET_PAGE_SIZE) {
+      free(page);
+      s->page[j] = FULL;
+      continue;
+    }
+    if (page == NULL) {
+      page = s->page[j] = (uint64_t *) calloc(IFERRET_LOCSET_PAGE_WORDS, sizeof(uint64_t));
+      assert (page != NULL);
+    }
+    for (w = a / 64; w <= (b - 1) / 64; w++)
+      page[w] |= iferret_locset_mask(w, a, b);
+  }
+}
+
+void iferret_locset_del(iferret_locset_t *s, uint64_t lo, uint64_t hi) {
+  uint64_t p, j, *page, any;
+  uint32_t a, b, w;
+
+  if (s->num_pages == 0 || lo >= hi) return;
+  for (p = lo >> IFERRET_LOCSET_PAGE_BITS; p <= (hi - 1) >> IFERRET_LOCSET_PAGE_BITS; p++) {
+    iferret_locset_bits(p, lo, hi, &a, &b);
+    j = iferret_locset_slot(s, p, 0);
+    if (j == IFERRET_LOCSET_NONE || (page = s->page[j]) == NULL) continue;
+    if (!(a == 0 && b == IFERRET_LOCSET_PAGE_SIZE)) {
+      if (page == FULL) {
+        page = s->page[j] = (uint64_t *) malloc(IFERRET_LOCSET_PAGE_WORDS * sizeof(uint64_t));
+        assert (page != NULL);
+        memset(page, 0xff, IFERRET_LOCSET_PAGE_WORDS * sizeof(uint64_t));
+      }
+      for (w = a / 64; w <= (b - 1) / 64; w++)
+        page[w] &= ~iferret_locset_mask(w, a, b);
+      for (any = 0, w = 0; w < IFERRET_LOCSET_PAGE_WORDS; w++)
+        any |= page[w];
+      if (any) continue;
+    }
+    if (page != FULL) free(page);
+    s->page[j] = NULL;
+    s->num_pages --;
+  }
+}
+
+void iferret_locset_free(iferret_locset_t *s) {
+  uint64_t i;
+
+  for (i=0; i<s->size; i++) {
+    if (s->page[i] != FULL)
+      free(s->page[i]);
+  }
+  free(s->key);
+  free(s->page);
+  memset(s, 0, sizeof(iferret_locset_t));
+}
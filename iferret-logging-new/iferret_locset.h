@@ -0,0 +1,34 @@
+#ifndef __IFERRET_LOCSET_H_
+#define __IFERRET_LOCSET_H_
+
+#include <stdint.h>
+
+// Location sets, for the slicer's working set.
+// Locations are 64-bit ids.  They are kept a page of 4096 at a time:
+// a page that's partly in the set has a bitmap, and one that's all in
+// it (a big buffer, say) is just marked full.  Adding, taking away or
+// looking for a run of locations works a page at a time, and a word of
+// the bitmap at a time within one.
+
+#define IFERRET_LOCSET_PAGE_BITS 12
+#define IFERRET_LOCSET_PAGE_SIZE (1 << IFERRET_LOCSET_PAGE_BITS)
+#define IFERRET_LOCSET_PAGE_WORDS (IFERRET_LOCSET_PAGE_SIZE / 64)
+
+typedef struct iferret_locset_struct_t {
+  uint64_t *key;                // page numbers.  ~0 for an empty slot
+  uint64_t **page;              // page[j] goes with key[j].  NULL if none
+                                // of it is in the set
+  uint64_t size;                // number of slots, a power of 2
+  uint64_t num;                 // number of keys
+  uint64_t num_pages;           // number of pages with anything in the set
+  uint64_t last;                // slot last looked at
+} iferret_locset_t;
+
+int iferret_locset_any(iferret_locset_t *s, uint64_t lo, uint64_t hi);
+void iferret_locset_add(iferret_locset_t *s, uint64_t lo, uint64_t hi);
+void iferret_locset_del(iferret_locset_t *s, uint64_t lo, uint64_t hi);
+void iferret_locset_free(iferret_locset_t *s);
+
+#define iferret_locset_empty(s) ((s)->num_pages == 0)
+
+#endif
@@ -8,6 +8,13 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#ifndef IFERRET_BACKEND
+#include <pthread.h>
+#include <sys/time.h>
+#include <signal.h>
+#endif
 
 #include "iferret_log.h"
 #include "target-i386/iferret_log_arg_fmt.h"
@@ -27,6 +34,14 @@ char *iferret_log_ptr_op_start = NULL;
 
 uint32_t iferret_log_rollup_count = 0;  
 
+// see iferret_log.h for what formats 1 and 2 are
+uint64_t iferret_log_delta_prev[IFLO_DUMMY_LAST][IFERRET_LOG_DELTA_ARGS];
+uint32_t iferret_log_delta_gen[IFLO_DUMMY_LAST];
+uint32_t iferret_log_block_gen = 1;
+
+// ptr to header of block currently being written (format 2 only)
+char *iferret_log_block_start = NULL;
+
 char *iferret_keyboard_label=NULL;
 uint8_t iferret_keyboard_label_changed = 0;
 
@@ -47,6 +62,8 @@ uint32_t iferret_log_inc = 0;
 
 uint32_t iferret_max_overflow = 0;
 
+uint8_t iferret_log_full = 0;
+
 uint64_t FAKE_EIP;
 uint64_t FAKE_EAX;
 uint64_t FAKE_ECX;
@@ -94,10 +111,12 @@ void iferret_log_socketcall_write_va(iferret_syscall_t *sc, iferret_log_op_enum_
 
 void iferret_log_op_args_write(iferret_log_op_enum_t op_num, va_list op_args) {
   char *op_fmt, *p;
+  uint8_t slot;
 
   op_fmt = iferret_log_arg_format[op_num].fmt;
   //  va_start(op_args, op_num);
   for (p=op_fmt; *p!='\0'; p++) {
+    slot = p - op_fmt;
     switch (*p) {
     case IFLAT_NONE: // no args at all
       break;
@@ -105,32 +124,32 @@ void iferret_log_op_args_write(iferret_log_op_enum_t op_num, va_list op_args) {
       {
 	//	uint8_t ui8 = va_arg(op_args,uint8_t);
 	uint8_t ui8 = (uint8_t) va_arg(op_args,uint32_t);
-	iferret_log_uint8_t_write(ui8);
+	iferret_log_arg_write_1(op_num, slot, ui8);
       }
       break;
     case IFLAT_UI16:     // uint16_t
       {
 	//	uint16_t ui16 = va_arg(op_args,uint16_t);
 	uint16_t ui16 = (uint16_t) va_arg(op_args,uint32_t);
-	iferret_log_uint16_t_write(ui16);      
+	iferret_log_arg_write_2(op_num, slot, ui16);      
       }
       break;
     case IFLAT_UI32:     // uint32_t
       {
 	uint32_t ui32 = va_arg(op_args,uint32_t);
-	iferret_log_uint32_t_write(ui32);
+	iferret_log_arg_write_4(op_num, slot, ui32);
       }
       break;
     case IFLAT_UI64:     // uint64_t
       {
 	uint64_t ui64 = va_arg(op_args,uint64_t);
-	iferret_log_uint64_t_write(ui64);
+	iferret_log_arg_write_8(op_num, slot, ui64);
       }
       break;
     case IFLAT_STR:      // string
       {
 	char *str = va_arg(op_args,char *);
-	iferret_log_string_write(str);
+	iferret_log_arg_write_s(op_num, slot, str);
       }
       break;
     }
@@ -142,9 +161,44 @@ void iferret_log_op_args_write(iferret_log_op_enum_t op_num, va_list op_args) {
 // read an info-flow op and all its args from the log
 // op_fmt is a string telling us how to interpret the elements in op_args
 // op_args is a va_list containing the *addresses* of the arguments.
-void iferret_log_op_args_read(iferret_op_t *op) {
+// read arg i of op from the log
+static void iferret_log_op_arg_read(iferret_log_reader_t *r, iferret_op_t *op, int i) {
+  char *buf;
+
+  switch (iferret_log_arg_format[op->num].fmt[i]) {
+    case '1':      // a 1-byte unsigned int
+      op->arg[i].type = IFLAT_UI8;
+      op->arg[i].val.u8 = iferret_log_arg_read_1(r, op->num, i);
+      break;
+    case '2':     // a 2-byte unsigned int
+      op->arg[i].type = IFLAT_UI16;
+      op->arg[i].val.u16 = iferret_log_arg_read_2(r, op->num, i);
+      break;
+    case '4':     // a 4-byte unsigned int
+    case 'p':     // a guest ptr (32-bit) 
+      op->arg[i].type = IFLAT_UI32;
+      op->arg[i].val.u32 = iferret_log_arg_read_4(r, op->num, i);
+      break;
+    case '8':     // an 8-byte unsigned int
+      op->arg[i].type = IFLAT_UI64;
+      op->arg[i].val.u64 = iferret_log_arg_read_8(r, op->num, i);
+      break;
+    case 's':      // a string
+      op->arg[i].type = IFLAT_STR;
+      buf = r->str[r->str_next];
+      r->str_next = (r->str_next + 1) % IFERRET_LOG_READER_STRS;
+      iferret_log_arg_read_s(r, op->num, i, buf);
+      op->arg[i].val.str = buf;
+      break;
+    default: 
+      break;
+  }
+}
+
+
+void iferret_log_op_args_read(iferret_log_reader_t *r, iferret_op_t *op) {
   char *p;
-  char buf[MAX_STRING_LEN];
+  uint32_t page;
   int i;
 
   // NB: we've already read the op and checked the sentinel...
@@ -153,13 +207,13 @@ void iferret_log_op_args_read(iferret_op_t *op) {
 
   if (op->num >= IFLO_SYS_CALLS_START) {
     // its a syscall.  read in the other stuff.
-    op->syscall->is_sysenter = iferret_log_uint8_t_read();
-    op->syscall->is_enter = iferret_log_uint8_t_read();
-    op->syscall->pid = iferret_log_uint32_t_read();
-    op->syscall->callsite_eip = iferret_log_uint32_t_read();
-    op->syscall->eax = iferret_log_uint32_t_read();
-    op->syscall->ebx = iferret_log_uint32_t_read();
-    iferret_log_string_read(op->syscall->command);
+    op->syscall->is_sysenter = iferret_log_arg_read_1(r, op->num, IFERRET_LOG_NO_DELTA);
+    op->syscall->is_enter = iferret_log_arg_read_1(r, op->num, IFERRET_LOG_NO_DELTA);
+    op->syscall->pid = iferret_log_arg_read_4(r, op->num, IFERRET_LOG_NO_DELTA);
+    op->syscall->callsite_eip = iferret_log_arg_read_4(r, op->num, IFERRET_LOG_NO_DELTA);
+    op->syscall->eax = iferret_log_arg_read_4(r, op->num, IFERRET_LOG_NO_DELTA);
+    op->syscall->ebx = iferret_log_arg_read_4(r, op->num, IFERRET_LOG_NO_DELTA);
+    iferret_log_arg_read_s(r, op->num, IFERRET_LOG_NO_DELTA, op->syscall->command);
   }
 
   // now we iterate through the fmt string for this op
@@ -169,40 +223,87 @@ void iferret_log_op_args_read(iferret_op_t *op) {
   i=0;
   if(iferret_log_arg_format[op->num].fmt[0] == '0') {
     op->num_args = 0;
-    op->arg = NULL;
   }
   else {
     op->num_args = strlen(iferret_log_arg_format[op->num].fmt);
-    op->arg = (iferret_op_arg_t *) malloc(op->num_args*sizeof(iferret_op_arg_t));
   }
+  page = iferret_log_reader_op_page(r, op->num);
+  for (i=0; i < op->num_args; i++) {
+    if (!(page & (1 << i))) {
+      iferret_log_op_arg_read(r, op, i);
+    }
+  }
+  if (page) {
+    iferret_log_page_ctx_read(r, op);
+  }
+}
+
+
+// read the next op of a tb template instance. 
+// tmpl is the same op from the tb's schema. 
+// static args come from it, dynamic ones from the log.
+void iferret_log_op_args_read_templated(iferret_log_reader_t *r, iferret_op_t *op, 
+                                        iferret_op_t *tmpl) {
+  uint32_t st, page;
+  int i;
+
+  op->num = tmpl->num;
+  op->flags = 1;
+  op->num_args = tmpl->num_args;
+  iferret_log_reader_delta_row_check(r, op->num);
+  st = iferret_log_arg_static[op->num];
+  page = iferret_log_reader_op_page(r, op->num);
   for (i=0; i < op->num_args; i++) {
-    switch (iferret_log_arg_format[op->num].fmt[i]) {
-      case '1':      // a 1-byte unsigned int
-        op->arg[i].type = IFLAT_UI8;
-        op->arg[i].val.u8 = iferret_log_uint8_t_read();
-        break;
-      case '2':     // a 2-byte unsigned int
-        op->arg[i].type = IFLAT_UI16;
-        op->arg[i].val.u16 = iferret_log_uint16_t_read();
-        break;
-      case '4':     // a 4-byte unsigned int
-      case 'p':     // a guest ptr (32-bit) 
-        op->arg[i].type = IFLAT_UI32;
-        op->arg[i].val.u32 = iferret_log_uint32_t_read();
-        break;
-      case '8':     // an 8-byte unsigned int
-        op->arg[i].type = IFLAT_UI64;
-        op->arg[i].val.u64 = iferret_log_uint64_t_read();
-        break;
-      case 's':      // a string
-        op->arg[i].type = IFLAT_STR;
-        iferret_log_string_read(buf);
-        op->arg[i].val.str = strdup(buf);
-        break;
-      default: 
-        break;
+    if (st & (1 << i)) {
+      // strings too.  the schema outlives the op
+      op->arg[i] = tmpl->arg[i];
+    }
+    else if (!(page & (1 << i))) {
+      iferret_log_op_arg_read(r, op, i);
     }
   }
+  if (page) {
+    iferret_log_page_ctx_read(r, op);
+  }
+}
+
+
+// format string of op's args.  "0" if it has none
+char *iferret_log_arg_fmt(iferret_log_op_enum_t op) {
+  return (iferret_log_arg_format[op].fmt);
+}
+
+
+// page contexts.  see iferret_log.h
+iferret_page_ctx_t iferret_log_page_ctx[IFERRET_PAGE_CTX_SIZE];
+
+void iferret_log_page_ctx_reset() {
+  memset(iferret_log_page_ctx, 0, sizeof(iferret_log_page_ctx));
+}
+
+// read the page context byte (and context) after a memory op's args,
+// and fill in the args it stands for.  
+void iferret_log_page_ctx_read(iferret_log_reader_t *r, iferret_op_t *op) {
+  iferret_page_ctx_t *c;
+  uint32_t virt;
+
+  virt = op->arg[2].val.u32;
+  c = &(r->page_ctx[(virt >> 12) % IFERRET_PAGE_CTX_SIZE]);
+  if (iferret_log_arg_read_1(r, op->num, IFERRET_LOG_NO_DELTA)) {
+    c->vpage = virt >> 12;
+    c->pbase = iferret_log_arg_read_4(r, op->num, IFERRET_LOG_NO_DELTA);
+    c->pdpe = iferret_log_arg_read_4(r, op->num, IFERRET_LOG_NO_DELTA);
+    c->pde = iferret_log_arg_read_4(r, op->num, IFERRET_LOG_NO_DELTA);
+    c->pte = iferret_log_arg_read_4(r, op->num, IFERRET_LOG_NO_DELTA);
+  }
+  op->arg[1].type = IFLAT_UI32;
+  op->arg[1].val.u32 = c->pbase + (virt & 0xfff);
+  op->arg[3].type = IFLAT_UI32;
+  op->arg[3].val.u32 = c->pdpe;
+  op->arg[4].type = IFLAT_UI32;
+  op->arg[4].val.u32 = c->pde;
+  op->arg[5].type = IFLAT_UI32;
+  op->arg[5].val.u32 = c->pte;
 }
 
 void iferret_spit_op(iferret_op_t *op) {
@@ -273,6 +374,9 @@ void iferret_set_network_label(const char *label) {
 // need to save the register base addresses to start of every log.  
 void iferret_log_preamble() {
   int i;
+#if IFERRET_LOG_FORMAT == 2
+  iferret_log_uint64_t_write(IFERRET_LOG_V2_MAGIC);
+#endif
   iferret_log_uint64_t_write((uint64_t) phys_ram_base);
   iferret_log_uint64_t_write((uint64_t) iferret_target_os);
   iferret_log_uint64_t_write(ifregaddr[IFRN_EAX]);
@@ -292,39 +396,787 @@ void iferret_log_preamble() {
   iferret_log_uint64_t_write(ifregaddr[IFRN_Q2]);
   iferret_log_uint64_t_write(ifregaddr[IFRN_Q3]);
   iferret_log_uint64_t_write(ifregaddr[IFRN_Q4]);
+  iferret_log_page_ctx_reset();
+#if IFERRET_LOG_FORMAT == 2
+  iferret_log_block_open();
+#endif
 }
 #else
 // we are compiling the back-end, i.e. the bit that reads the log and analyzes it.
 // need to read the register base addresses from the start of every log.  
-void iferret_log_preamble() {
-  //int i;
-  phys_ram_base = (uint8_t *) iferret_log_uint64_t_read();
-  iferret_target_os = (uint32_t) iferret_log_uint64_t_read();
-  ifregaddr[IFRN_EAX] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_ECX] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_EDX] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_EBX] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_ESP] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_EBP] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_ESI] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_EDI] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_EIP] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_T0] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_T1] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_A0] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_Q0] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_Q1] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_Q2] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_Q3] = iferret_log_uint64_t_read();
-  ifregaddr[IFRN_Q4] = iferret_log_uint64_t_read();
+// they go in r, as other chunks may be being read at the same time.
+void iferret_log_preamble_read(iferret_log_reader_t *r) {
+  uint64_t first;
+  // format 2 logs start with a magic number.  format 1 with phys_ram_base.
+  iferret_log_reader_need(r, sizeof(uint64_t));
+  first = iferret_log_uint64_t_read(r);
+  if (first == IFERRET_LOG_V2_MAGIC) {
+    r->format = 2;
+    iferret_log_reader_need(r, IFERRET_LOG_PREAMBLE_SIZE);
+    first = iferret_log_uint64_t_read(r);
+  }
+  else {
+    r->format = 1;
+    iferret_log_reader_need(r, IFERRET_LOG_PREAMBLE_SIZE - sizeof(uint64_t));
+  }
+  r->phys_ram_base = first;
+  r->target_os = (uint32_t) iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_EAX] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_ECX] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_EDX] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_EBX] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_ESP] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_EBP] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_ESI] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_EDI] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_EIP] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_T0] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_T1] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_A0] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_Q0] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_Q1] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_Q2] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_Q3] = iferret_log_uint64_t_read(r);
+  r->ifregaddr[IFRN_Q4] = iferret_log_uint64_t_read(r);
+  memset(r->page_ctx, 0, sizeof(r->page_ctx));
+}
+#endif
+
+
+// codec "none": plain bytes
+static int64_t iferret_log_none_write(char *filename, char *buf, uint64_t len) {
+  FILE *fp;
+  fp = fopen (filename, "w");
+  if (fp == NULL) return -1;
+  if (fwrite(buf, 1, len, fp) != len) {
+    fclose(fp);
+    return -1;
+  }
+  fclose(fp);
+  return len;
+}
+
+// map it read-only and shared, so we decode straight out of the page cache 
+// and everyone reading this chunk gets the same pages.
+static int iferret_log_none_open(iferret_log_reader_t *r, char *filename) {
+  int fd;
+  struct stat fs;
+  char *p;
+
+  fd = open (filename, O_RDONLY);
+  if (fd < 0) return -1;
+  if (fstat(fd, &fs) != 0 || fs.st_size == 0) {
+    close(fd);
+    return -1;
+  }
+  p = (char *) mmap(NULL, fs.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return -1;
+  madvise(p, fs.st_size, MADV_SEQUENTIAL);
+  r->base = p;
+  r->end = p + fs.st_size;
+  r->map_len = fs.st_size;
+  return 0;
+}
+
+static int iferret_log_none_head(char *filename, uint8_t *buf, uint32_t n) {
+  FILE *fp;
+  int got;
+
+  fp = fopen (filename, "r");
+  if (fp == NULL) return -1;
+  got = fread(buf, 1, n, fp);
+  fclose(fp);
+  return got;
+}
+
+static int iferret_log_none_recognize(uint8_t *hdr, uint32_t n) {
+  // anything no other codec claims
+  return 1;
+}
+
+// codec "zlib": gzip stream, compressed a piece at a time.
+// fastest compression level, since the writer has to keep up with the guest.
+#define IFERRET_LOG_ZLIB_CHUNK (1 << 20)
+
+static int64_t iferret_log_zlib_write(char *filename, char *buf, uint64_t len) {
+  gzFile gz;
+  uint64_t off, n;
+  struct stat fs;
+
+  gz = gzopen (filename, "wb1");
+  if (gz == NULL) return -1;
+  for (off=0; off<len; off+=n) {
+    n = len - off;
+    if (n > IFERRET_LOG_ZLIB_CHUNK) n = IFERRET_LOG_ZLIB_CHUNK;
+    if (gzwrite(gz, buf + off, n) != n) {
+      gzclose(gz);
+      return -1;
+    }
+  }
+  if (gzclose(gz) != Z_OK) return -1;
+  if (stat(filename, &fs) != 0) return -1;
+  return fs.st_size;
+}
+
+// no telling how big it is until it's all decoded, so grow as we go.
+static int iferret_log_zlib_open(iferret_log_reader_t *r, char *filename) {
+  gzFile gz;
+  uint64_t off, max;
+  char *buf;
+  int n;
+
+  gz = gzopen (filename, "rb");
+  if (gz == NULL) return -1;
+  max = 16 * IFERRET_LOG_ZLIB_CHUNK;
+  buf = (char *) malloc(max);
+  off = 0;
+  while (1) {
+    if (off == max) {
+      max *= 2;
+      buf = (char *) realloc(buf, max);
+    }
+    assert (buf != NULL);
+    n = gzread(gz, buf + off, 
+	       (max - off > IFERRET_LOG_ZLIB_CHUNK) ? IFERRET_LOG_ZLIB_CHUNK : max - off);
+    if (n < 0) {
+      gzclose(gz);
+      free(buf);
+      return -1;
+    }
+    if (n == 0) break;
+    off += n;
+  }
+  gzclose(gz);
+  r->base = buf;
+  r->end = buf + off;
+  r->map_len = 0;
+  return 0;
+}
+
+static int iferret_log_zlib_head(char *filename, uint8_t *buf, uint32_t n) {
+  gzFile gz;
+  int got;
+
+  gz = gzopen (filename, "rb");
+  if (gz == NULL) return -1;
+  got = gzread(gz, buf, n);
+  gzclose(gz);
+  return got;
+}
+
+static int iferret_log_zlib_recognize(uint8_t *hdr, uint32_t n) {
+  // gzip magic
+  return (n >= 2 && hdr[0] == 0x1f && hdr[1] == 0x8b);
+}
+
+iferret_log_codec_t iferret_log_codecs[IFERRET_LOG_NUM_CODECS] = {
+  { "none", iferret_log_none_write, iferret_log_none_open, iferret_log_none_head, 
+    iferret_log_none_recognize },
+  { "zlib", iferret_log_zlib_write, iferret_log_zlib_open, iferret_log_zlib_head, 
+    iferret_log_zlib_recognize },
+};
+
+uint32_t iferret_log_codec = IFERRET_LOG_CODEC_NONE;
+
+// pick codec for writing log chunks by name.  returns 0 if no such codec. 
+int iferret_log_codec_select(const char *name) {
+  int i;
+  for (i=0; i<IFERRET_LOG_NUM_CODECS; i++) {
+    if (strcmp(name, iferret_log_codecs[i].name) == 0) {
+      iferret_log_codec = i;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void iferret_log_reader_truncated(iferret_log_reader_t *r) {
+  printf ("log chunk is truncated at offset %lu\n", (unsigned long) (r->ptr - r->base));
+  exit(1);
+}
+
+// which codec wrote filename, or -1 if it can't be read.
+// plain logs never start with anything a codec would claim: 
+// they start with a magic number or phys_ram_base.
+static int iferret_log_codec_of(char *filename) {
+  FILE *fp;
+  uint8_t hdr[16];
+  uint32_t n;
+  int i;
+
+  fp = fopen (filename, "r");
+  if (fp == NULL) return -1;
+  n = fread(hdr, 1, sizeof(hdr), fp);
+  fclose(fp);
+  // none comes first in the table and claims everything, so check it last
+  for (i=IFERRET_LOG_NUM_CODECS-1; i>=0; i--) {
+    if (iferret_log_codecs[i].recognize(hdr, n)) break;
+  }
+  return i;
+}
+
+uint32_t iferret_log_chunk_format(char *filename) {
+  uint64_t first;
+  int i;
+
+  i = iferret_log_codec_of(filename);
+  if (i < 0 
+      || iferret_log_codecs[i].head(filename, (uint8_t *) &first, sizeof(first)) != sizeof(first)) 
+    return 0;
+  return ((first == IFERRET_LOG_V2_MAGIC) ? 2 : 1);
+}
+
+// open a log chunk for reading, whichever codec wrote it.
+// returns NULL if it can't be read.
+iferret_log_reader_t *iferret_log_reader_open(char *filename) {
+  iferret_log_reader_t *r;
+  int i;
+
+  i = iferret_log_codec_of(filename);
+  // zeroed, so every delta row starts out stale
+  r = (iferret_log_reader_t *) calloc(1, sizeof(iferret_log_reader_t));
+  assert (r != NULL);
+  if (i < 0 || iferret_log_codecs[i].open(r, filename) != 0) {
+    free(r);
+    return NULL;
+  }
+  r->ptr = r->base;
+  r->block_gen = 1;
+  return r;
+}
+
+void iferret_log_reader_close(iferret_log_reader_t *r) {
+  if (r->map_len) {
+    munmap(r->base, r->map_len);
+  }
+  else {
+    free(r->base);
+  }
+  free(r);
+}
+
+
+// format 2: start a new block.  header is filled in when it is closed.  
+// bumping the generation makes every op's delta row stale, and bumping 
+// the epoch makes tbs learn their schemas (and instructions log their 
+// disassembly) again.  with the page contexts cleared too, 
+// each block can be decoded on its own.
+void iferret_log_block_open() {
+  iferret_log_block_start = iferret_log_ptr;
+  iferret_log_ptr += IFERRET_LOG_BLOCK_HEADER_SIZE;
+  iferret_log_block_gen ++;
+#ifndef IFERRET_BACKEND
+  iferret_log_tb_epoch ++;
+  iferret_log_page_ctx_reset();
+#endif
+}
+
+// format 2: close current block by recording its length.
+// the checksum is computed later, off the emulation thread.
+void iferret_log_block_close() {
+  uint32_t len;
+  if (iferret_log_block_start == NULL) return;
+  len = iferret_log_ptr - (iferret_log_block_start + IFERRET_LOG_BLOCK_HEADER_SIZE);
+  if (len == 0) {
+    // nothing in it.  don't bother writing it.
+    iferret_log_ptr = iferret_log_block_start;
+  }
+  else {
+    ((uint32_t *) iferret_log_block_start)[0] = len;
+    ((uint32_t *) iferret_log_block_start)[1] = 0;
+  }
+  iferret_log_block_start = NULL;
+}
+
+// format 2: fill in the checksum of every block in a log of len bytes
+void iferret_log_block_checksum(char *base, uint64_t len) {
+  char *p, *end;
+  uint32_t n;
+
+  if (*((uint64_t *) base) != IFERRET_LOG_V2_MAGIC) return;
+  p = base + sizeof(uint64_t) + IFERRET_LOG_PREAMBLE_SIZE;
+  end = base + len;
+  while (p + IFERRET_LOG_BLOCK_HEADER_SIZE <= end) {
+    n = ((uint32_t *) p)[0];
+    ((uint32_t *) p)[1] = adler32(adler32(0L, Z_NULL, 0), 
+				  (Bytef *) (p + IFERRET_LOG_BLOCK_HEADER_SIZE), n);
+    p += IFERRET_LOG_BLOCK_HEADER_SIZE + n;
+  }
+}
+
+
+#ifndef IFERRET_BACKEND
+
+// tb templates.  see iferret_log.h
+uint8_t iferret_log_tb_state = IFERRET_TB_NONE;
+iferret_tb_schema_t *iferret_log_tb_cur = NULL;
+uint32_t iferret_log_tb_pos = 0;
+uint32_t iferret_log_tb_epoch = 1;
+char *iferret_log_tb_count_ptr = NULL;
+
+static iferret_tb_schema_t *iferret_log_tb_schemas = NULL;
+// id 0 is IFERRET_TB_NO_SCHEMA
+static uint32_t iferret_log_tb_num_schemas = 1;
+static uint32_t iferret_log_tb_max_schemas = 0;
+
+// new schema id for a tb being translated
+uint32_t iferret_log_tb_schema_new() {
+  iferret_tb_schema_t *schema;
+  uint32_t n;
+
+  if (iferret_log_tb_num_schemas >= iferret_log_tb_max_schemas) {
+    // array is about to move.  can't be in the middle of a schema or instance.
+    iferret_log_tb_leave_check();
+    n = (iferret_log_tb_max_schemas == 0) ? 1024 : 2 * iferret_log_tb_max_schemas;
+    iferret_log_tb_schemas = (iferret_tb_schema_t *) 
+      realloc(iferret_log_tb_schemas, n * sizeof(iferret_tb_schema_t));
+    assert (iferret_log_tb_schemas != NULL);
+    memset(&(iferret_log_tb_schemas[iferret_log_tb_max_schemas]), 0, 
+           (n - iferret_log_tb_max_schemas) * sizeof(iferret_tb_schema_t));
+    iferret_log_tb_max_schemas = n;
+  }
+  // a recycled one keeps its ops array.  learning reuses it.
+  schema = &(iferret_log_tb_schemas[iferret_log_tb_num_schemas]);
+  schema->epoch = 0;
+  schema->num_ops = 0;
+  return (iferret_log_tb_num_schemas ++);
+}
+
+// every tb is about to go.  so do their schema ids.  
+// the new tbs' ids start again from 1, so the next ones logged could 
+// clash with the ones in the current block.  start a new one.
+// (format 1 has no blocks, and the back end keys schemas by id for 
+// the whole chunk, so its ids are never recycled.)
+void iferret_log_tb_flush() {
+#if IFERRET_LOG_FORMAT == 2
+  iferret_log_tb_leave_check();
+  iferret_log_block_close();
+  iferret_log_block_open();
+  iferret_log_tb_num_schemas = 1;
+#endif
 }
+
+iferret_tb_schema_t *iferret_log_tb_schema_get(uint32_t id) {
+  assert (id != IFERRET_TB_NO_SCHEMA && id < iferret_log_tb_num_schemas);
+  return (&(iferret_log_tb_schemas[id]));
+}
+
+// start learning schema from the ops that follow.
+// count byte of the IFLO_TB_SCHEMA record just written gets patched at the end.
+void iferret_log_tb_learn(iferret_tb_schema_t *schema) {
+  schema->ops = (iferret_log_op_enum_t *) 
+    realloc(schema->ops, IFERRET_TB_MAX_OPS * sizeof(iferret_log_op_enum_t));
+  assert (schema->ops != NULL);
+  schema->num_ops = 0;
+  iferret_log_tb_cur = schema;
+  iferret_log_tb_pos = 0;
+  iferret_log_tb_count_ptr = iferret_log_ptr - 1;
+  iferret_log_tb_state = IFERRET_TB_LEARNING;
+}
+
+// start matching the ops that follow against schema.
+// count byte of the IFLO_TB_INSTANCE record just written gets patched at the end.
+void iferret_log_tb_instance(iferret_tb_schema_t *schema) {
+  iferret_log_tb_cur = schema;
+  iferret_log_tb_pos = 0;
+  iferret_log_tb_count_ptr = iferret_log_ptr - 1;
+  iferret_log_tb_state = IFERRET_TB_MATCHING;
+}
+
+// end current tb schema or instance.  
+void iferret_log_tb_leave() {
+  if (iferret_log_tb_state == IFERRET_TB_LEARNING) {
+    iferret_log_tb_cur->num_ops = iferret_log_tb_pos;
+    iferret_log_tb_cur->epoch = iferret_log_tb_epoch;
+    if (iferret_log_tb_pos > 0) {
+      iferret_log_tb_cur->ops = (iferret_log_op_enum_t *) 
+	realloc(iferret_log_tb_cur->ops, iferret_log_tb_pos * sizeof(iferret_log_op_enum_t));
+    }
+  }
+  *((uint8_t *) iferret_log_tb_count_ptr) = iferret_log_tb_pos;
+  iferret_log_tb_state = IFERRET_TB_NONE;
+}
+
+
+// interned instruction disassembly.  see iferret_log.h
+typedef struct iferret_insn_dis_struct_t {
+  uint32_t phys_page;
+  uint32_t pc;
+  uint8_t len;
+  uint8_t bytes[IFERRET_INSN_MAX_LEN];
+  uint32_t id;
+  uint32_t epoch;               // chunk its IFLO_INSN_DIS_STR was last logged in
+  struct iferret_insn_dis_struct_t *next;
+} iferret_insn_dis_t;
+
+static iferret_insn_dis_t *iferret_insn_dis_hash[IFERRET_INSN_DIS_HASH_SIZE];
+static uint32_t iferret_insn_dis_num = 0;
+
+static inline uint32_t iferret_insn_dis_hash_fn(uint32_t phys_page, uint32_t pc, 
+                                                uint8_t *bytes, int len) {
+  uint32_t h;
+  int i;
+  h = phys_page ^ (pc * 2654435761U);
+  for (i=0; i<len; i++) {
+    h = (h * 31) + bytes[i];
+  }
+  return (h % IFERRET_INSN_DIS_HASH_SIZE);
+}
+
+// id for the disassembly of this instruction.  
+// *is_new is set if its string isn't in this log chunk yet, 
+// in which case the caller has to log an IFLO_INSN_DIS_STR for it.
+uint32_t iferret_log_insn_dis_id(uint32_t phys_page, uint32_t pc, uint8_t *bytes, int len, 
+                                 int *is_new) {
+  iferret_insn_dis_t *d;
+  uint32_t h;
+
+  h = iferret_insn_dis_hash_fn(phys_page, pc, bytes, len);
+  for (d = iferret_insn_dis_hash[h]; d != NULL; d = d->next) {
+    if (d->phys_page == phys_page && d->pc == pc && d->len == len
+        && memcmp(d->bytes, bytes, len) == 0) {
+      break;
+    }
+  }
+  if (d == NULL) {
+    // not seen before.  
+    d = (iferret_insn_dis_t *) malloc(sizeof(iferret_insn_dis_t));
+    assert (d != NULL);
+    d->phys_page = phys_page;
+    d->pc = pc;
+    d->len = len;
+    memcpy(d->bytes, bytes, len);
+    d->id = iferret_insn_dis_num ++;
+    d->epoch = 0;
+    d->next = iferret_insn_dis_hash[h];
+    iferret_insn_dis_hash[h] = d;
+  }
+  // each chunk has to be readable on its own
+  *is_new = (d->epoch != iferret_log_tb_epoch);
+  d->epoch = iferret_log_tb_epoch;
+  return d->id;
+}
+
+
+// the log is a ring of IFERRET_LOG_NUM_BUFS buffers.
+// when the one we are writing into fills up, it gets handed to a
+// writer thread and emulation carries on in the next one.  we only
+// block if every buffer is still waiting to go to disk.
+#if IFERRET_LOG_NUM_BUFS < 2
+#error IFERRET_LOG_NUM_BUFS must be at least 2
+#endif
+
+typedef struct iferret_log_buf_struct_t {
+  char *base;
+  uint64_t len;                 // number of bytes to write out
+  uint8_t pending;              // TRUE means writer hasn't gotten to it yet
+  char filename[1024];
+  int fd;                       // mmap mode: file backing this buffer
+  char mapname[1024];           // mmap mode: what that file is called till it's done
+} iferret_log_buf_t;
+
+// TRUE means log buffers are shared mappings of the chunk files themselves,
+// rather than calloc'd memory that gets copied out at rollup.
+uint8_t iferret_log_mmap = 0;
+static uint32_t iferret_log_mmap_seq = 0;
+
+static iferret_log_buf_t iferret_log_buf[IFERRET_LOG_NUM_BUFS];
+
+// buffer emulation is currently writing into
+static uint32_t iferret_log_buf_cur = 0;
+// next buffer the writer thread will write out
+static uint32_t iferret_log_buf_next_write = 0;
+
+static pthread_mutex_t iferret_log_buf_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t iferret_log_buf_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t iferret_log_writer;
+
+// rollup stats, reported by "info iferret" in the monitor
+uint64_t iferret_log_rollups = 0;
+uint64_t iferret_log_bytes_written = 0;
+uint64_t iferret_log_disk_bytes_written = 0;
+uint64_t iferret_log_stalls = 0;
+uint64_t iferret_log_stall_usec = 0;
+uint64_t iferret_log_stall_max_usec = 0;
+
+
+static uint64_t iferret_log_usec_since(struct timeval *start) {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return ((uint64_t) (now.tv_sec - start->tv_sec)) * 1000000
+    + (now.tv_usec - start->tv_usec);
+}
+
+
+// guard pages.  
+// rather than checking for room before every write, or even every tb,
+// the page at which we next need to hear about the log is made PROT_NONE.
+// that's the end of the current block (format 2) or the start of the 
+// cushion, whichever comes first.  the write that hits it faults, the 
+// handler opens the page back up and sets iferret_log_full, and the write
+// goes through.  the next tb boundary looks at iferret_log_full and rolls
+// up or starts a new block.  each tb logs at most IFERRET_LOG_TB_BUDGET, 
+// so the cushion only has to hold the rest of one tb, the translation 
+// of the next and a syscall record (see IFERRET_LOG_CUSHION).
+// every buffer also ends in a page that is never opened up, so anything
+// that runs through the cushion stops there rather than trashing memory.
+static char *iferret_log_guard = NULL;
+static uintptr_t iferret_log_page_size;
+static struct sigaction iferret_log_old_segv;
+
+#define IFERRET_LOG_PAGE_DOWN(p) ((char *) ((uintptr_t) (p) & ~(iferret_log_page_size - 1)))
+#define IFERRET_LOG_PAGE_UP(p) IFERRET_LOG_PAGE_DOWN((char *) (p) + iferret_log_page_size - 1)
+
+// what a buffer maps: the log itself, rounded up to pages, and the hard guard page
+static inline uint64_t iferret_log_map_len(void) {
+  return (uintptr_t) IFERRET_LOG_PAGE_UP(IFERRET_LOG_SIZE) + iferret_log_page_size;
+}
+
+static inline char *iferret_log_hard_guard(char *base) {
+  return (base + iferret_log_map_len() - iferret_log_page_size);
+}
+
+static void iferret_log_segv(int sig, siginfo_t *si, void *ctx) {
+  char *addr = (char *) si->si_addr;
+
+  if (iferret_log_guard != NULL 
+      && addr >= iferret_log_guard && addr < iferret_log_guard + iferret_log_page_size) {
+    mprotect(iferret_log_guard, iferret_log_page_size, PROT_READ | PROT_WRITE);
+    iferret_log_guard = NULL;
+    iferret_log_full = 1;
+    return;
+  }
+  if (iferret_log_base != NULL) {
+    char *hard = iferret_log_hard_guard(iferret_log_base);
+    if (addr >= hard && addr < hard + iferret_log_page_size) {
+      static const char msg[] = "iferret log ran through its cushion.  raise IFERRET_LOG_CUSHION.\n";
+      write(2, msg, sizeof(msg) - 1);
+      abort();
+    }
+  }
+  // not ours
+  if (iferret_log_old_segv.sa_flags & SA_SIGINFO) {
+    iferret_log_old_segv.sa_sigaction(sig, si, ctx);
+  }
+  else if (iferret_log_old_segv.sa_handler != SIG_DFL 
+           && iferret_log_old_segv.sa_handler != SIG_IGN) {
+    iferret_log_old_segv.sa_handler(sig);
+  }
+  else {
+    // put the default back.  the access faults again and we die the usual way.
+    sigaction(SIGSEGV, &iferret_log_old_segv, NULL);
+  }
+}
+
+static void iferret_log_guard_disarm(void) {
+  if (iferret_log_guard != NULL) {
+    mprotect(iferret_log_guard, iferret_log_page_size, PROT_READ | PROT_WRITE);
+    iferret_log_guard = NULL;
+  }
+}
+
+// called whenever iferret_log_full has been dealt with
+void iferret_log_guard_arm() {
+  char *g;
+
+  iferret_log_guard_disarm();
+  // first page wholly inside the cushion.  a little of the cushion goes,
+  // but once the guard is hit iferret_log_room() is sure to be <= 0.
+  g = IFERRET_LOG_PAGE_UP(iferret_log_base + IFERRET_LOG_SIZE - IFERRET_LOG_CUSHION);
+#if IFERRET_LOG_FORMAT == 2
+  {
+    // first page whose every byte is past the point the block is big enough
+    char *b = IFERRET_LOG_PAGE_UP(iferret_log_block_start + IFERRET_LOG_BLOCK_SIZE + 1);
+    if (b < g) g = b;
+  }
+#endif
+  if (iferret_log_ptr >= g) {
+    // already there
+    iferret_log_full = 1;
+    return;
+  }
+  iferret_log_full = 0;
+  iferret_log_guard = g;
+  mprotect(iferret_log_guard, iferret_log_page_size, PROT_NONE);
+}
+
+// fresh buffer: make its last page the hard guard
+static void iferret_log_buf_guard(iferret_log_buf_t *buf) {
+  mprotect(iferret_log_hard_guard(buf->base), iferret_log_page_size, PROT_NONE);
+}
+
+
+// mmap mode: make buf a window onto a fresh chunk file.  
+// file is sparse, so this costs next to nothing till we write into it.
+// it gets its real name once we know it, at rollup.
+static void iferret_log_buf_map(iferret_log_buf_t *buf) {
+  snprintf (buf->mapname, 1024, "%s.mmap-%d-%d", 
+	    iferret_log_prefix, getpid(), iferret_log_mmap_seq++);
+  buf->fd = open (buf->mapname, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (buf->fd < 0 || ftruncate(buf->fd, IFERRET_LOG_SIZE) != 0) {
+    printf ("iferret_log_buf_map: can't create %s\n", buf->mapname);
+    exit(1);
+  }
+  buf->base = (char *) mmap(NULL, iferret_log_map_len(), PROT_READ | PROT_WRITE, 
+			    MAP_SHARED, buf->fd, 0);
+  if (buf->base == MAP_FAILED) {
+    printf ("iferret_log_buf_map: can't mmap %s\n", buf->mapname);
+    exit(1);
+  }
+  iferret_log_buf_guard(buf);
+}
+
+// mmap mode: done with buf.  the kernel writes back dirty pages on its own,
+// so all that's left is trimming the file and giving it its real name.
+static int64_t iferret_log_buf_unmap(iferret_log_buf_t *buf) {
+  munmap(buf->base, iferret_log_map_len());
+  buf->base = NULL;
+  if (ftruncate(buf->fd, buf->len) != 0) {
+    close(buf->fd);
+    return -1;
+  }
+  close(buf->fd);
+  if (rename(buf->mapname, buf->filename) != 0) {
+    return -1;
+  }
+  return buf->len;
+}
+
+
+// writer thread.  writes out buffers in the order they were handed over.
+static void *iferret_log_writer_thread(void *arg) {
+  iferret_log_buf_t *buf;
+  int64_t n;
+
+  while (1) {
+    pthread_mutex_lock(&iferret_log_buf_mutex);
+    buf = &(iferret_log_buf[iferret_log_buf_next_write]);
+    while (!buf->pending) {
+      pthread_cond_wait(&iferret_log_buf_cond, &iferret_log_buf_mutex);
+    }
+    pthread_mutex_unlock(&iferret_log_buf_mutex);
+
+    iferret_log_block_checksum(buf->base, buf->len);
+    if (iferret_log_mmap) {
+      n = iferret_log_buf_unmap(buf);
+    }
+    else {
+      n = iferret_log_codecs[iferret_log_codec].write(buf->filename, buf->base, buf->len);
+    }
+    if (n < 0) {
+      printf ("iferret_log_writer_thread: can't write %s\n", buf->filename);
+      n = 0;
+    }
+    else {
+      printf ("wrote if log to %s (%s, %Lu bytes)\n", buf->filename, 
+	      iferret_log_codecs[iferret_log_codec].name, (unsigned long long) n);
+    }
+
+    pthread_mutex_lock(&iferret_log_buf_mutex);
+    iferret_log_bytes_written += buf->len;
+    iferret_log_disk_bytes_written += n;
+    buf->pending = 0;
+    iferret_log_buf_next_write = (iferret_log_buf_next_write + 1) % IFERRET_LOG_NUM_BUFS;
+    pthread_cond_broadcast(&iferret_log_buf_cond);
+    pthread_mutex_unlock(&iferret_log_buf_mutex);
+  }
+  return NULL;
+}
+
+
+// number of buffers handed over but not yet on disk
+uint32_t iferret_log_bufs_pending() {
+  uint32_t i, n;
+
+  n = 0;
+  pthread_mutex_lock(&iferret_log_buf_mutex);
+  for (i=0; i<IFERRET_LOG_NUM_BUFS; i++) {
+    if (iferret_log_buf[i].pending) n++;
+  }
+  pthread_mutex_unlock(&iferret_log_buf_mutex);
+  return n;
+}
+
+
+// wait for the writer thread to get everything it has been given to disk
+void iferret_log_sync() {
+  uint32_t i;
+
+  pthread_mutex_lock(&iferret_log_buf_mutex);
+  for (i=0; i<IFERRET_LOG_NUM_BUFS; i++) {
+    while (iferret_log_buf[i].pending) {
+      pthread_cond_wait(&iferret_log_buf_cond, &iferret_log_buf_mutex);
+    }
+  }
+  pthread_mutex_unlock(&iferret_log_buf_mutex);
+}
+
+
+// at exit: wait for writer.  
+// in mmap mode, also get rid of the chunk that never got rolled up.
+static void iferret_log_exit(void) {
+  iferret_log_buf_t *buf;
+
+  iferret_log_sync();
+  if (iferret_log_mmap) {
+    buf = &(iferret_log_buf[iferret_log_buf_cur]);
+    if (buf->base != NULL) {
+      munmap(buf->base, iferret_log_map_len());
+      close(buf->fd);
+      unlink(buf->mapname);
+    }
+  }
+}
+
 #endif
 
 
 void iferret_log_create() {
+#ifdef IFERRET_BACKEND
   // initial info flow log allocation.
   iferret_log_ptr = iferret_log_base = (char *) calloc (IFERRET_LOG_SIZE,1);
-#ifndef IFERRET_BACKEND 
+#else
+  int i;
+  struct sigaction act;
+
+  iferret_log_page_size = sysconf(_SC_PAGESIZE);
+  if (iferret_log_mmap && iferret_log_codec != IFERRET_LOG_CODEC_NONE) {
+    printf ("iferret_log_create: can't compress an mmap'd log.  writing it uncompressed.\n");
+    iferret_log_codec = IFERRET_LOG_CODEC_NONE;
+  }
+  for (i=0; i<IFERRET_LOG_NUM_BUFS; i++) {
+    iferret_log_buf[i].pending = 0;
+    if (iferret_log_mmap) {
+      // mapped on demand
+      iferret_log_buf[i].base = NULL;
+      continue;
+    }
+    // not calloc: the guard pages have to be pages of their own
+    iferret_log_buf[i].base = (char *) mmap(NULL, iferret_log_map_len(), PROT_READ | PROT_WRITE,
+                                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (iferret_log_buf[i].base == MAP_FAILED) {
+      printf ("iferret_log_create: can't allocate log buffer %d\n", i);
+      exit(1);
+    }
+    iferret_log_buf_guard(&(iferret_log_buf[i]));
+  }
+  memset(&act, 0, sizeof(act));
+  act.sa_sigaction = iferret_log_segv;
+  act.sa_flags = SA_SIGINFO;
+  sigemptyset(&act.sa_mask);
+  sigaction(SIGSEGV, &act, &iferret_log_old_segv);
+  iferret_log_buf_cur = 0;
+  if (iferret_log_mmap) {
+    iferret_log_buf_map(&(iferret_log_buf[0]));
+  }
+  iferret_log_ptr = iferret_log_base = iferret_log_buf[0].base;
+  if (pthread_create(&iferret_log_writer, NULL, iferret_log_writer_thread, NULL) != 0) {
+    printf ("iferret_log_create: can't start log writer thread\n");
+    exit(1);
+  }
+  // don't lose whatever is still queued when qemu exits
+  atexit(iferret_log_exit);
   iferret_set_keyboard_label("keyboard_startup");
   iferret_set_network_label("network_startup");
   // set up ifregaddr array.
@@ -346,9 +1198,11 @@ void iferret_log_create() {
   ifregaddr[IFRN_Q3] =  (uint64_t) &(FAKE_Q3);
   ifregaddr[IFRN_Q4] =  (uint64_t) &(FAKE_Q4);
   iferret_log_preamble();
+  iferret_log_guard_arm();
 #endif
 }
 
+#ifdef IFERRET_BACKEND
 // save current if log to a file for some reason    
 void iferret_log_write_to_file(char *label) {
   char filename[1024];
@@ -361,6 +1215,8 @@ void iferret_log_write_to_file(char *label) {
   snprintf (filename, 1024, "%s.%d-%d-%d", 
 	    iferret_log_prefix, iferret_log_inc, getpid(), iferret_log_rollup_count);
 
+  iferret_log_block_close();
+  iferret_log_block_checksum(iferret_log_base, iferret_log_ptr-iferret_log_base);
   fp = fopen (filename, "w");
 
   fwrite(iferret_log_base, 1, iferret_log_ptr-iferret_log_base, fp);
@@ -372,13 +1228,70 @@ void iferret_log_write_to_file(char *label) {
 
   // processing complete; ready to write over old log.  
   iferret_log_ptr = iferret_log_base; 
-  iferret_log_preamble();
 
 }
+#else
+// hand the current if log to the writer thread and switch to the next 
+// buffer in the ring.  only blocks if that one hasn't been written yet.
+void iferret_log_write_to_file(char *label) {
+  iferret_log_buf_t *buf;
+  uint32_t next;
+
+  printf ("iferret_log_write_to_file [%s]: iferret_log_ptr - iferret_log_base = %Lu\n", 
+	  label, (unsigned long long) (iferret_log_ptr - iferret_log_base));
+
+  // writer thread is about to get at the whole buffer
+  iferret_log_guard_disarm();
+  iferret_log_tb_leave_check();
+  iferret_log_block_close();
+  // tb schemas have to be learned again in the next chunk, 
+  // so it can be read without this one.
+  iferret_log_tb_epoch ++;
+
+  pthread_mutex_lock(&iferret_log_buf_mutex);
+  buf = &(iferret_log_buf[iferret_log_buf_cur]);
+  snprintf (buf->filename, 1024, "%s.%d-%d-%d", 
+	    iferret_log_prefix, iferret_log_inc, getpid(), iferret_log_rollup_count);
+  buf->len = iferret_log_ptr - iferret_log_base;
+  buf->pending = 1;
+  pthread_cond_broadcast(&iferret_log_buf_cond);
+  iferret_log_rollup_count ++;
+  iferret_log_rollups ++;
+
+  next = (iferret_log_buf_cur + 1) % IFERRET_LOG_NUM_BUFS;
+  if (iferret_log_buf[next].pending) {
+    // writer has fallen behind.  nothing for it but to wait.
+    struct timeval start;
+    uint64_t usec;
+    gettimeofday(&start, NULL);
+    while (iferret_log_buf[next].pending) {
+      pthread_cond_wait(&iferret_log_buf_cond, &iferret_log_buf_mutex);
+    }
+    usec = iferret_log_usec_since(&start);
+    iferret_log_stalls ++;
+    iferret_log_stall_usec += usec;
+    if (usec > iferret_log_stall_max_usec) {
+      iferret_log_stall_max_usec = usec;
+    }
+    printf ("iferret_log_write_to_file: stalled %Lu usec waiting for log writer\n",
+	    (unsigned long long) usec);
+  }
+  iferret_log_buf_cur = next;
+  pthread_mutex_unlock(&iferret_log_buf_mutex);
+
+  if (iferret_log_mmap) {
+    iferret_log_buf_map(&(iferret_log_buf[next]));
+  }
+
+  // ready to write into fresh buffer.
+  iferret_log_ptr = iferret_log_base = iferret_log_buf[next].base; 
+  iferret_log_preamble();
+  iferret_log_guard_arm();
+}
+#endif
 
 
 // info-flow log is full.  Dump it to a file. 
 void iferret_log_rollup(char *label) {
   iferret_log_write_to_file(label);
 }
-
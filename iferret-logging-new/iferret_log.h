@@ -10,11 +10,41 @@
 
 #define THE_SENTINEL 0x42424242
 #define USE_SENTINEL 1
+
+// Log format 1 is the original one: 4-byte op number, sentinel, fixed-width args.
+// Log format 2 is compact: LEB128 op number, args delta-encoded against the
+// same arg of the previous op of the same kind, and ops grouped into blocks 
+// each of which carries a length and a checksum instead of per-op sentinels.
+// A format 2 log starts with IFERRET_LOG_V2_MAGIC ahead of the preamble.  
+// The back end reads both.  
+#ifndef IFERRET_LOG_FORMAT
+#define IFERRET_LOG_FORMAT 2
+#endif
+#define IFERRET_LOG_V2_MAGIC 0x32474f4c54524546ULL   // "FERTLOG2"
+#define IFERRET_LOG_DELTA_ARGS 8          // only this many args per op are delta-encoded
+#define IFERRET_LOG_NO_DELTA 0xff         // arg slot meaning "don't delta-encode"
+#define IFERRET_LOG_BLOCK_SIZE 1000000    // start a new block once one gets this big
+#define IFERRET_LOG_BLOCK_HEADER_SIZE 8   // uint32 payload length + uint32 adler32
+#define IFERRET_LOG_PREAMBLE_SIZE (19*8)
 #define MAX_STRING_LEN 2048
 #define IFERRET_MAX_KEYBOARD_LABEL_LEN 1024
 #define IFERRET_MAX_NETWORK_LABEL_LEN 2048
 #define IFERRET_LOG_SIZE    500000000  // 50 MB
-#define IFERRET_LOG_CUSHION 100000000   // 1 MB
+// most a tb may log, when it is translated and when it runs.  
+// the translator ends tbs before they could log more.
+#define IFERRET_LOG_TB_BUDGET 32768
+// syscall records are written by the helpers of instructions that end 
+// a tb, so there's at most one between tb boundaries.  they can be big.
+#define IFERRET_LOG_SYSCALL_MAX (16 * MAX_STRING_LEN)
+// room past the guard page (see iferret_log.c) for the rest of the tb 
+// that hits it, the translation of the next one, a syscall record, 
+// plus a few records from devices
+#define IFERRET_LOG_CUSHION (2 * IFERRET_LOG_TB_BUDGET + IFERRET_LOG_SYSCALL_MAX + 8192)
+// number of log buffers in the ring.  
+// full ones are written out by a separate thread.
+#ifndef IFERRET_LOG_NUM_BUFS
+#define IFERRET_LOG_NUM_BUFS 2
+#endif
 
 // We're pretending that real memeory, registers, io_buffer, and the hard drive are 
 // all in one continuous block of memory.  
@@ -147,13 +177,22 @@ typedef struct iferret_op_struct_t {
 extern char *iferret_log_ptr;      
 extern char *iferret_log_base;      
 extern uint32_t iferret_max_overflow;
+// TRUE once the log has run into its guard page.  see iferret_log.c
+extern uint8_t iferret_log_full;
+
+// previous value of each delta-encoded arg, per op, as written.
+// a row is only valid if its generation matches that of the current block.
+// (the back end keeps its own in each iferret_log_reader_t)
+extern uint64_t iferret_log_delta_prev[IFLO_DUMMY_LAST][IFERRET_LOG_DELTA_ARGS];
+extern uint32_t iferret_log_delta_gen[IFLO_DUMMY_LAST];
+extern uint32_t iferret_log_block_gen;
+extern char *iferret_log_block_start;
 
 extern uint8_t iferret_info_flow_on;
 
 
 void iferret_log_op_args_write(iferret_log_op_enum_t op_num, va_list op_args);
 
-void iferret_log_op_args_read(iferret_op_t *op);
 
 void iferret_set_keyboard_label(const char *label);
 void iferret_set_network_label(const char *label);
@@ -187,44 +226,163 @@ static inline void iferret_log_uint64_t_write(uint64_t i) {
 #define iferret_log_write_8 iferret_log_uint64_t_write
 #define iferret_log_write_s iferret_log_string_write
 
-// read various unsigned ints from the log
+// page contexts.  see below
+#define IFERRET_PAGE_CTX_SIZE 256
+// most string args any op has
+#define IFERRET_LOG_READER_STRS 4
+
+typedef struct iferret_page_ctx_struct_t {
+  uint32_t vpage;
+  uint32_t pbase;               // phys - offset in page
+  uint32_t pdpe;
+  uint32_t pde;
+  uint32_t pte;
+} iferret_page_ctx_t;
+
+// The back end reads each log chunk through one of these. 
+// It holds the chunk and all the state needed to decode it, 
+// so chunks can be read independently of each other.  
+// An uncompressed chunk is mapped read-only straight from its file, 
+// so it is decoded in place, it can be any size, and its pages are 
+// shared with anyone else reading the same trace.
+typedef struct iferret_log_reader_struct_t {
+  char *base;                   // first byte of the chunk
+  char *ptr;                    // next byte to be read
+  char *end;                    // one past the last byte
+  uint64_t map_len;             // length of mapping at base, or 0 if it was malloc'd
+  uint32_t format;              // see iferret_log_preamble_read
+  // the rest of the chunk's preamble
+  uint64_t phys_ram_base;
+  uint32_t target_os;
+  uint64_t ifregaddr[IFRN_Q4+1];
+  uint32_t block_gen;
+  uint64_t delta_prev[IFLO_DUMMY_LAST][IFERRET_LOG_DELTA_ARGS];
+  uint32_t delta_gen[IFLO_DUMMY_LAST];
+  iferret_page_ctx_t page_ctx[IFERRET_PAGE_CTX_SIZE];
+  // string args of the op just read point in here.  
+  // good until the next op is read.
+  char str[IFERRET_LOG_READER_STRS][MAX_STRING_LEN+1];
+  uint32_t str_next;
+} iferret_log_reader_t;
+
+iferret_log_reader_t *iferret_log_reader_open(char *filename);
+void iferret_log_reader_close(iferret_log_reader_t *r);
+
+// these fill in op->arg, which must have room for IFERRET_OP_MAX_NUM_ARGS.
+void iferret_log_op_args_read(iferret_log_reader_t *r, iferret_op_t *op);
+void iferret_log_op_args_read_templated(iferret_log_reader_t *r, iferret_op_t *op, 
+                                        iferret_op_t *tmpl);
+char *iferret_log_arg_fmt(iferret_log_op_enum_t op);
+
+// format 1 has no blocks to check the length of, so its reads make sure 
+// there are n more bytes in the chunk.  
+void iferret_log_reader_truncated(iferret_log_reader_t *r);
+
+static inline void iferret_log_reader_need(iferret_log_reader_t *r, int64_t n) {
+  if (r->end - r->ptr < n) {
+    iferret_log_reader_truncated(r);
+  }
+}
+
+// read various unsigned ints from a log chunk
 // and advance the pointer
-static inline uint8_t iferret_log_uint8_t_read(void) {
-  uint8_t i = *((uint8_t *)iferret_log_ptr);
-  iferret_log_ptr += sizeof(uint8_t);  
+static inline uint8_t iferret_log_uint8_t_read(iferret_log_reader_t *r) {
+  uint8_t i = *((uint8_t *)r->ptr);
+  r->ptr += sizeof(uint8_t);  
   return(i);
 }
 
-static inline uint16_t iferret_log_uint16_t_read(void) {
-  uint16_t i = *((uint16_t *)iferret_log_ptr);
-  iferret_log_ptr += sizeof(uint16_t);  
+static inline uint16_t iferret_log_uint16_t_read(iferret_log_reader_t *r) {
+  uint16_t i = *((uint16_t *)r->ptr);
+  r->ptr += sizeof(uint16_t);  
   return(i);
 }
 
-static inline uint32_t iferret_log_uint32_t_read(void) {
-  uint32_t i = *((uint32_t *)iferret_log_ptr);
-  iferret_log_ptr += sizeof(uint32_t);  
+static inline uint32_t iferret_log_uint32_t_read(iferret_log_reader_t *r) {
+  uint32_t i = *((uint32_t *)r->ptr);
+  r->ptr += sizeof(uint32_t);  
   return(i);
 }
 
-static inline uint64_t iferret_log_uint64_t_read(void) {
-  uint64_t i = *((uint64_t *)iferret_log_ptr);
-  iferret_log_ptr += sizeof(uint64_t);  
+static inline uint64_t iferret_log_uint64_t_read(iferret_log_reader_t *r) {
+  uint64_t i = *((uint64_t *)r->ptr);
+  r->ptr += sizeof(uint64_t);  
   return(i);
 }
 
 
 
 
+// LEB128: 7 bits per byte, high bit set means more to come
+static inline void iferret_log_uleb128_write(uint64_t v) {
+  while (v >= 0x80) {
+    *((uint8_t *)iferret_log_ptr) = (v & 0x7f) | 0x80;
+    iferret_log_ptr ++;
+    v >>= 7;
+  }
+  *((uint8_t *)iferret_log_ptr) = v;
+  iferret_log_ptr ++;
+}
 
-static inline iferret_log_op_enum_t iferret_log_op_only_read(void) {
+static inline uint64_t iferret_log_uleb128_read(iferret_log_reader_t *r) {
+  uint64_t v = 0;
+  uint32_t shift = 0;
+  uint8_t b;
+  do {
+    b = *((uint8_t *)r->ptr);
+    r->ptr ++;
+    if (shift < 64) {
+      v |= ((uint64_t) (b & 0x7f)) << shift;
+    }
+    shift += 7;
+  } while (b & 0x80);
+  return (v);
+}
+
+// zigzag maps small negative deltas to small unsigned ints
+#define IFERRET_ZIGZAG32(d) ((((uint32_t) (d)) << 1) ^ ((uint32_t) ((int32_t) (d) >> 31)))
+#define IFERRET_ZIGZAG64(d) ((((uint64_t) (d)) << 1) ^ ((uint64_t) ((int64_t) (d) >> 63)))
+#define IFERRET_UNZIGZAG(z) (((z) >> 1) ^ -((z) & 1))
+
+// make sure delta row for this op belongs to the current block
+static inline void iferret_log_delta_row_check(iferret_log_op_enum_t op) {
+  if (iferret_log_delta_gen[op] != iferret_log_block_gen) {
+    memset(iferret_log_delta_prev[op], 0, sizeof(iferret_log_delta_prev[op]));
+    iferret_log_delta_gen[op] = iferret_log_block_gen;
+  }
+}
+
+// same, for a reader
+static inline void iferret_log_reader_delta_row_check(iferret_log_reader_t *r, 
+                                                      iferret_log_op_enum_t op) {
+  if (r->delta_gen[op] != r->block_gen) {
+    memset(r->delta_prev[op], 0, sizeof(r->delta_prev[op]));
+    r->delta_gen[op] = r->block_gen;
+  }
+}
+
+static inline iferret_log_op_enum_t iferret_log_op_only_read(iferret_log_reader_t *r) {
   iferret_log_op_enum_t op;
-  op = iferret_log_uint32_t_read();
+  if (r->format == 2) {
+    op = iferret_log_uleb128_read(r);
+    if (op < IFLO_DUMMY_LAST) {
+      iferret_log_reader_delta_row_check(r, op);
+    }
+  }
+  else {
+    iferret_log_reader_need(r, sizeof(uint32_t));
+    op = iferret_log_uint32_t_read(r);
+  }
   return (op);
 }
 
 static inline void iferret_log_op_only_write(iferret_log_op_enum_t op) {
+#if IFERRET_LOG_FORMAT == 2
+  iferret_log_uleb128_write(op);
+  iferret_log_delta_row_check(op);
+#else
   iferret_log_uint32_t_write(op);
+#endif
 }
 
 
@@ -235,10 +393,11 @@ static inline void iferret_log_sentinel_write(void) {
 #endif
 }
 
-static inline int iferret_log_sentinel_check(void) { 
+static inline int iferret_log_sentinel_check(iferret_log_reader_t *r) { 
 #ifdef USE_SENTINEL
   uint32_t sent;
-  sent = iferret_log_uint32_t_read();
+  iferret_log_reader_need(r, sizeof(uint32_t));
+  sent = iferret_log_uint32_t_read(r);
   //  assert (sent == THE_SENTINEL);
   return (sent == THE_SENTINEL);
 #endif
@@ -273,36 +432,333 @@ static inline void iferret_log_string_write(char *str) {
 
 // read a string from the log
 // NB: assumes s is allocated 
-static inline void iferret_log_string_read(char *str) {
+static inline void iferret_log_string_read(iferret_log_reader_t *r, char *str) {
   int i,n;			
-  n = iferret_log_uint32_t_read();
+  iferret_log_reader_need(r, sizeof(uint32_t));
+  n = iferret_log_uint32_t_read(r);
+  iferret_log_reader_need(r, n);
   for (i=0; i<n; i++) {
     if (i >= MAX_STRING_LEN) break;
-    str[i] = iferret_log_uint8_t_read();
+    str[i] = iferret_log_uint8_t_read(r);
   }
   str[i] = 0;
 }
 
 
 
+// write / read args of an op.  
+// slot is the position of the arg in the op's format, which 
+// determines what it gets delta-encoded against in format 2.
+static inline void iferret_log_arg_write_1(iferret_log_op_enum_t op, uint8_t slot, uint8_t x) {
+  iferret_log_uint8_t_write(x);
+}
+
+static inline void iferret_log_arg_write_2(iferret_log_op_enum_t op, uint8_t slot, uint16_t x) {
+#if IFERRET_LOG_FORMAT == 2
+  iferret_log_uleb128_write(x);
+#else
+  iferret_log_uint16_t_write(x);
+#endif
+}
+
+static inline void iferret_log_arg_write_4(iferret_log_op_enum_t op, uint8_t slot, uint32_t x) {
+#if IFERRET_LOG_FORMAT == 2
+  if (slot < IFERRET_LOG_DELTA_ARGS) {
+    int32_t d = (int32_t) (x - (uint32_t) iferret_log_delta_prev[op][slot]);
+    iferret_log_delta_prev[op][slot] = x;
+    iferret_log_uleb128_write(IFERRET_ZIGZAG32(d));
+  }
+  else {
+    iferret_log_uleb128_write(x);
+  }
+#else
+  iferret_log_uint32_t_write(x);
+#endif
+}
+
+static inline void iferret_log_arg_write_8(iferret_log_op_enum_t op, uint8_t slot, uint64_t x) {
+#if IFERRET_LOG_FORMAT == 2
+  if (slot < IFERRET_LOG_DELTA_ARGS) {
+    int64_t d = (int64_t) (x - iferret_log_delta_prev[op][slot]);
+    iferret_log_delta_prev[op][slot] = x;
+    iferret_log_uleb128_write(IFERRET_ZIGZAG64(d));
+  }
+  else {
+    iferret_log_uleb128_write(x);
+  }
+#else
+  iferret_log_uint64_t_write(x);
+#endif
+}
+
+static inline void iferret_log_arg_write_s(iferret_log_op_enum_t op, uint8_t slot, char *str) {
+#if IFERRET_LOG_FORMAT == 2
+  uint32_t n;
+  n = safe_strlen(str);
+  iferret_log_uleb128_write(n);
+  memcpy(iferret_log_ptr, str, n);
+  iferret_log_ptr += n;
+#else
+  iferret_log_string_write(str);
+#endif
+}
+
+#define iferret_log_arg_write_p iferret_log_arg_write_4
+
+static inline uint8_t iferret_log_arg_read_1(iferret_log_reader_t *r, iferret_log_op_enum_t op, 
+                                             uint8_t slot) {
+  if (r->format != 2) {
+    iferret_log_reader_need(r, sizeof(uint8_t));
+  }
+  return (iferret_log_uint8_t_read(r));
+}
+
+static inline uint16_t iferret_log_arg_read_2(iferret_log_reader_t *r, iferret_log_op_enum_t op, 
+                                              uint8_t slot) {
+  if (r->format == 2) {
+    return ((uint16_t) iferret_log_uleb128_read(r));
+  }
+  iferret_log_reader_need(r, sizeof(uint16_t));
+  return (iferret_log_uint16_t_read(r));
+}
+
+static inline uint32_t iferret_log_arg_read_4(iferret_log_reader_t *r, iferret_log_op_enum_t op, 
+                                              uint8_t slot) {
+  if (r->format == 2) {
+    uint32_t z = (uint32_t) iferret_log_uleb128_read(r);
+    if (slot < IFERRET_LOG_DELTA_ARGS) {
+      uint32_t x = (uint32_t) r->delta_prev[op][slot] + IFERRET_UNZIGZAG(z);
+      r->delta_prev[op][slot] = x;
+      return (x);
+    }
+    return (z);
+  }
+  iferret_log_reader_need(r, sizeof(uint32_t));
+  return (iferret_log_uint32_t_read(r));
+}
+
+static inline uint64_t iferret_log_arg_read_8(iferret_log_reader_t *r, iferret_log_op_enum_t op, 
+                                              uint8_t slot) {
+  if (r->format == 2) {
+    uint64_t z = iferret_log_uleb128_read(r);
+    if (slot < IFERRET_LOG_DELTA_ARGS) {
+      uint64_t x = r->delta_prev[op][slot] + IFERRET_UNZIGZAG(z);
+      r->delta_prev[op][slot] = x;
+      return (x);
+    }
+    return (z);
+  }
+  iferret_log_reader_need(r, sizeof(uint64_t));
+  return (iferret_log_uint64_t_read(r));
+}
+
+// NB: assumes str is allocated (MAX_STRING_LEN+1)
+static inline void iferret_log_arg_read_s(iferret_log_reader_t *r, iferret_log_op_enum_t op, 
+                                          uint8_t slot, char *str) {
+  if (r->format == 2) {
+    uint32_t i, n;
+    n = iferret_log_uleb128_read(r);
+    for (i=0; i<n; i++) {
+      uint8_t c = iferret_log_uint8_t_read(r);
+      if (i < MAX_STRING_LEN) str[i] = c;
+    }
+    str[(n < MAX_STRING_LEN) ? n : MAX_STRING_LEN] = 0;
+    return;
+  }
+  iferret_log_string_read(r, str);
+}
+
+
+// Per-tb record templates.
+// The first time a tb executes in a log block (format 2) or chunk (format 1), 
+// its info-flow ops are logged in full after an IFLO_TB_SCHEMA(id,n) record, 
+// and the op sequence becomes that tb's template.  After that, each execution logs IFLO_TB_INSTANCE(id,n) 
+// followed by just the dynamic args of the first n ops, as long as they 
+// follow the template.  Anything else ends the instance and is logged normally.
+// n is patched in when the schema or instance ends.  
+// Args that are static (see iferret_log_arg_static, generated) come from the 
+// schema when the back end expands an instance.
+#define IFERRET_TB_NONE 0
+#define IFERRET_TB_LEARNING 1
+#define IFERRET_TB_MATCHING 2
+#define IFERRET_TB_MAX_OPS 255          // n has to fit in a byte
+#define IFERRET_TB_NO_SCHEMA 0          // schema id of tbs that don't log
+
+typedef struct iferret_tb_schema_struct_t {
+  uint32_t epoch;                 // log chunk it was learned in.  stale otherwise.
+  uint32_t num_ops;
+  iferret_log_op_enum_t *ops;
+} iferret_tb_schema_t;
+
+// bitmask of static args for each op.  in iferret_op_str.c (generated)
+extern uint32_t iferret_log_arg_static[];
+
+extern uint8_t iferret_log_tb_state;
+extern iferret_tb_schema_t *iferret_log_tb_cur;
+extern uint32_t iferret_log_tb_pos;
+extern uint32_t iferret_log_tb_epoch;
+extern char *iferret_log_tb_count_ptr;
+
+uint32_t iferret_log_tb_schema_new(void);
+void iferret_log_tb_flush(void);
+iferret_tb_schema_t *iferret_log_tb_schema_get(uint32_t id);
+void iferret_log_tb_learn(iferret_tb_schema_t *schema);
+void iferret_log_tb_instance(iferret_tb_schema_t *schema);
+void iferret_log_tb_leave(void);
+
+static inline void iferret_log_tb_leave_check(void) {
+#ifndef IFERRET_BACKEND
+  // back end never writes templates
+  if (iferret_log_tb_state != IFERRET_TB_NONE) {
+    iferret_log_tb_leave();
+  }
+#endif
+}
+
+// called by info-flow op writers.
+// returns TRUE if this op is the next one in the tb template, 
+// in which case only its dynamic args need to be written.
+static inline int iferret_log_tb_op(iferret_log_op_enum_t op) {
+#ifndef IFERRET_BACKEND
+  // back end never writes templates
+  if (iferret_log_tb_state == IFERRET_TB_MATCHING) {
+    if (iferret_log_tb_pos < iferret_log_tb_cur->num_ops
+        && iferret_log_tb_cur->ops[iferret_log_tb_pos] == op) {
+      iferret_log_tb_pos ++;
+      iferret_log_delta_row_check(op);
+      return 1;
+    }
+    iferret_log_tb_leave();
+  }
+  else if (iferret_log_tb_state == IFERRET_TB_LEARNING) {
+    if (iferret_log_tb_pos < IFERRET_TB_MAX_OPS) {
+      iferret_log_tb_cur->ops[iferret_log_tb_pos] = op;
+      iferret_log_tb_pos ++;
+    }
+    else {
+      iferret_log_tb_leave();
+    }
+  }
+#endif
+  return 0;
+}
+
+// write the op and the sentinel, without disturbing a tb schema or instance.
+// only for info-flow op writers, which have already called iferret_log_tb_op.
+static inline void iferret_log_op_write_prologue_in_tb(iferret_log_op_enum_t op_num) {
+  iferret_log_op_only_write(op_num);
+#if IFERRET_LOG_FORMAT != 2
+  iferret_log_sentinel_write();
+#endif
+}
+
+// Interned instruction disassembly.
+// The translator logs IFLO_INSN_DIS(pc,id) for each instruction, and the 
+// string itself once per log chunk in an IFLO_INSN_DIS_STR(id,str) record.
+// Ids are per (physical page, pc, code bytes).  The back end keeps the 
+// strings in a table and iferret_insn_dis_str(id) looks them up on demand.
+#define IFERRET_INSN_MAX_LEN 16
+#define IFERRET_INSN_DIS_HASH_SIZE 65536
+
+uint32_t iferret_log_insn_dis_id(uint32_t phys_page, uint32_t pc, uint8_t *bytes, int len, 
+                                 int *is_new);
+char *iferret_insn_dis_str(uint32_t id);
+
+// Page contexts.
+// Memory ops log phys_a0() and the page walk for A0 (pdpe, pde, pte), which 
+// hardly ever change for a given virtual page.  Those args (marked in the 
+// generated iferret_log_arg_page) are left out of the op, which is followed 
+// instead by a byte saying whether the context for A0's page changed and, if 
+// so, the new context.  The back end fills the args back in from its copy.
+// Both ends start each log chunk with a zeroed table.  
+// The front end's is iferret_log_page_ctx, the back end's is in its reader.
+// Format 1 logs those args in full, as it always has.
+// bitmask of page context args for each op.  in iferret_op_str.c (generated)
+extern uint32_t iferret_log_arg_page[];
+
+// page context args of op, as this build logs it
+#if IFERRET_LOG_FORMAT == 2
+#define iferret_log_op_page(op) (iferret_log_arg_page[op])
+#else
+#define iferret_log_op_page(op) 0
+#endif
+
+// page context args of op, as r's log has it
+static inline uint32_t iferret_log_reader_op_page(iferret_log_reader_t *r, 
+                                                  iferret_log_op_enum_t op) {
+  return ((r->format == 2) ? iferret_log_arg_page[op] : 0);
+}
+
+extern iferret_page_ctx_t iferret_log_page_ctx[IFERRET_PAGE_CTX_SIZE];
+
+void iferret_log_page_ctx_reset(void);
+void iferret_log_page_ctx_read(iferret_log_reader_t *r, iferret_op_t *op);
+
+static inline void iferret_log_page_ctx_write(iferret_log_op_enum_t op, uint32_t phys, uint32_t virt,
+                                              uint32_t pdpe, uint32_t pde, uint32_t pte) {
+  iferret_page_ctx_t *c;
+  uint32_t vpage, pbase;
+
+  vpage = virt >> 12;
+  pbase = phys - (virt & 0xfff);
+  c = &(iferret_log_page_ctx[vpage % IFERRET_PAGE_CTX_SIZE]);
+  if (c->vpage == vpage && c->pbase == pbase 
+      && c->pdpe == pdpe && c->pde == pde && c->pte == pte) {
+    iferret_log_arg_write_1(op, IFERRET_LOG_NO_DELTA, 0);
+    return;
+  }
+  c->vpage = vpage;
+  c->pbase = pbase;
+  c->pdpe = pdpe;
+  c->pde = pde;
+  c->pte = pte;
+  iferret_log_arg_write_1(op, IFERRET_LOG_NO_DELTA, 1);
+  iferret_log_arg_write_4(op, IFERRET_LOG_NO_DELTA, pbase);
+  iferret_log_arg_write_4(op, IFERRET_LOG_NO_DELTA, pdpe);
+  iferret_log_arg_write_4(op, IFERRET_LOG_NO_DELTA, pde);
+  iferret_log_arg_write_4(op, IFERRET_LOG_NO_DELTA, pte);
+}
+
 static inline void iferret_log_op_write_prologue(iferret_log_op_enum_t op_num) {
+  // any other op ends current tb schema or instance.
+  iferret_log_tb_leave_check();
   // write the op and the sentinel
   iferret_log_op_only_write(op_num);
+#if IFERRET_LOG_FORMAT != 2
   iferret_log_sentinel_write();
+#endif
 }
 
 static inline void iferret_log_syscall_commoner(iferret_syscall_t *sc) {
   // write the std syscall other args.
-  iferret_log_uint8_t_write(sc->is_sysenter);  
-  iferret_log_uint8_t_write(sc->is_enter);  
-  iferret_log_uint32_t_write(sc->pid);
-  iferret_log_uint32_t_write(sc->callsite_eip);
-  iferret_log_uint32_t_write(sc->eax);
-  iferret_log_uint32_t_write(sc->ebx);
-  iferret_log_string_write(sc->command);
+  iferret_log_arg_write_1(sc->op_num, IFERRET_LOG_NO_DELTA, sc->is_sysenter);  
+  iferret_log_arg_write_1(sc->op_num, IFERRET_LOG_NO_DELTA, sc->is_enter);  
+  iferret_log_arg_write_4(sc->op_num, IFERRET_LOG_NO_DELTA, sc->pid);
+  iferret_log_arg_write_4(sc->op_num, IFERRET_LOG_NO_DELTA, sc->callsite_eip);
+  iferret_log_arg_write_4(sc->op_num, IFERRET_LOG_NO_DELTA, sc->eax);
+  iferret_log_arg_write_4(sc->op_num, IFERRET_LOG_NO_DELTA, sc->ebx);
+  iferret_log_arg_write_s(sc->op_num, IFERRET_LOG_NO_DELTA, sc->command);
 
 }  
 
+// format 2 blocks.  see iferret_log.c
+void iferret_log_block_open(void);
+void iferret_log_block_close(void);
+void iferret_log_block_checksum(char *base, uint64_t len);
+
+// start a new block if the current one is big enough.
+// called at tb boundaries, from check_rollup, once the guard page 
+// at the end of the block has been hit.
+static inline void iferret_log_block_check(void) {
+#if IFERRET_LOG_FORMAT == 2
+  if (iferret_log_ptr - iferret_log_block_start > IFERRET_LOG_BLOCK_SIZE) {
+    iferret_log_tb_leave_check();
+    iferret_log_block_close();
+    iferret_log_block_open();
+  }
+#endif
+}
+
 
 static inline void iferret_log_syscall_common(iferret_syscall_t *sc, va_list op_args) {
   // write the std syscall other args.
@@ -469,10 +925,65 @@ char *iferret_op_num_to_str(iferret_log_op_enum_t op_num);
 
 void iferret_log_rollup(char *label);
 
+// guard page.  see iferret_log.c
+void iferret_log_guard_arm(void);
+
+// bytes left before the cushion
+static inline int64_t iferret_log_room(void) {
+  return (iferret_log_base + IFERRET_LOG_SIZE - IFERRET_LOG_CUSHION) - iferret_log_ptr;
+}
+
+// codecs for rolled-up log chunks.  
+// to add one, give it a number here and an entry in iferret_log_codecs[].
+#define IFERRET_LOG_CODEC_NONE 0
+#define IFERRET_LOG_CODEC_ZLIB 1
+#define IFERRET_LOG_NUM_CODECS 2
+
+typedef struct iferret_log_codec_struct_t {
+  char *name;
+  // write len bytes at buf to filename.  
+  // returns number of bytes that hit the disk or -1 on failure.
+  int64_t (*write)(char *filename, char *buf, uint64_t len);
+  // point r->base and r->end at the decoded contents of filename, 
+  // setting r->map_len if they are mapped rather than malloc'd.
+  // returns 0 on success or -1 on failure.
+  int (*open)(iferret_log_reader_t *r, char *filename);
+  // read the first n decoded bytes of filename into buf.
+  // returns how many it got or -1 on failure.
+  int (*head)(char *filename, uint8_t *buf, uint32_t n);
+  // TRUE iff a file starting with these n bytes was written by this codec
+  int (*recognize)(uint8_t *hdr, uint32_t n);
+} iferret_log_codec_t;
+
+extern iferret_log_codec_t iferret_log_codecs[IFERRET_LOG_NUM_CODECS];
+// codec used when writing log chunks
+extern uint32_t iferret_log_codec;
+
+int iferret_log_codec_select(const char *name);
+
+// which format a log chunk is in (see iferret_log_preamble_read), 
+// without decoding all of it.  0 if it can't be read.
+uint32_t iferret_log_chunk_format(char *filename);
+
+#ifndef IFERRET_BACKEND
+// rollup / writer thread stats
+extern uint64_t iferret_log_rollups;
+extern uint64_t iferret_log_bytes_written;
+extern uint64_t iferret_log_disk_bytes_written;
+extern uint64_t iferret_log_stalls;
+extern uint64_t iferret_log_stall_usec;
+extern uint64_t iferret_log_stall_max_usec;
+
+extern uint8_t iferret_log_mmap;
+
+uint32_t iferret_log_bufs_pending(void);
+void iferret_log_sync(void);
+#endif
+
 void iferret_spit_op(iferret_op_t *op);
 
 #ifdef IFERRET_BACKEND 
-void iferret_log_preamble();
+void iferret_log_preamble_read(iferret_log_reader_t *r);
 #endif
 
 #endif
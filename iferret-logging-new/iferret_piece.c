@@ -0,0 +1,190 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "iferret_piece.h"
+
+#define P(n) (t->p[n])
+#define SIZE(n) ((n) ? t->p[n].size : 0)
+
+
+static uint32_t iferret_piece_new(iferret_piece_tab_t *t, uint64_t start, uint64_t len) {
+  uint32_t n;
+
+  if (t->free) {
+    n = t->free;
+    t->free = P(n).left;
+  }
+  else {
+    if (t->num == t->max) {
+      t->max *= 2;
+      t->p = (iferret_piece_t *) realloc(t->p, t->max * sizeof(iferret_piece_t));
+      assert (t->p != NULL);
+    }
+    n = t->num++;
+  }
+  // xorshift
+  t->seed ^= t->seed << 13;
+  t->seed ^= t->seed >> 17;
+  t->seed ^= t->seed << 5;
+  P(n).start = start;
+  P(n).len = len;
+  P(n).size = len;
+  P(n).prio = t->seed;
+  P(n).left = P(n).right = 0;
+  return n;
+}
+
+static void iferret_piece_free(iferret_piece_tab_t *t, uint32_t n) {
+  if (n == 0) return;
+  iferret_piece_free(t, P(n).right);
+  iferret_piece_free(t, P(n).left);
+  P(n).left = t->free;
+  t->free = n;
+}
+
+static inline void iferret_piece_update(iferret_piece_tab_t *t, uint32_t n) {
+  P(n).size = P(n).len + SIZE(P(n).left) + SIZE(P(n).right);
+}
+
+// a followed by b
+static uint32_t iferret_piece_merge(iferret_piece_tab_t *t, uint32_t a, uint32_t b) {
+  uint32_t m;
+
+  if (a == 0) return b;
+  if (b == 0) return a;
+  if (P(a).prio > P(b).prio) {
+    m = iferret_piece_merge(t, P(a).right, b);
+    P(a).right = m;
+    iferret_piece_update(t, a);
+    return a;
+  }
+  m = iferret_piece_merge(t, a, P(b).left);
+  P(b).left = m;
+  iferret_piece_update(t, b);
+  return b;
+}
+
+// the first k of n into *l, the rest into *r.
+// a piece with the cut in it is cut in two.
+static void iferret_piece_split(iferret_piece_tab_t *t, uint32_t n, uint64_t k, 
+                                uint32_t *l, uint32_t *r) {
+  uint64_t ls, cut;
+  uint32_t m, x;
+
+  if (n == 0) {
+    *l = *r = 0;
+    return;
+  }
+  ls = SIZE(P(n).left);
+  if (k <= ls) {
+    iferret_piece_split(t, P(n).left, k, l, &x);
+    P(n).left = x;
+    iferret_piece_update(t, n);
+    *r = n;
+  }
+  else if (k >= ls + P(n).len) {
+    iferret_piece_split(t, P(n).right, k - ls - P(n).len, &x, r);
+    P(n).right = x;
+    iferret_piece_update(t, n);
+    *l = n;
+  }
+  else {
+    // the tail of n's piece, and everything after it, go right.
+    // same prio as n, so it's still a treap
+    cut = k - ls;
+    m = iferret_piece_new(t, P(n).start + cut, P(n).len - cut);
+    P(m).prio = P(n).prio;
+    P(n).len = cut;
+    P(m).right = P(n).right;
+    P(n).right = 0;
+    iferret_piece_update(t, m);
+    iferret_piece_update(t, n);
+    *l = n;
+    *r = m;
+  }
+}
+
+
+// positions 0..n-1 of the store, in order
+iferret_piece_tab_t *iferret_piece_tab_create(uint64_t n) {
+  iferret_piece_tab_t *t;
+
+  t = (iferret_piece_tab_t *) calloc(1, sizeof(iferret_piece_tab_t));
+  assert (t != NULL);
+  t->max = 64;
+  t->p = (iferret_piece_t *) calloc(t->max, sizeof(iferret_piece_t));
+  assert (t->p != NULL);
+  t->num = 1;
+  t->seed = 2463534242U;
+  t->root = (n > 0) ? iferret_piece_new(t, 0, n) : 0;
+  return t;
+}
+
+void iferret_piece_tab_destroy(iferret_piece_tab_t *t) {
+  free(t->p);
+  free(t);
+}
+
+uint64_t iferret_piece_len(iferret_piece_tab_t *t) {
+  return SIZE(t->root);
+}
+
+// store position at sequence position i, which has to be < the length.
+// *before is how many positions before i are in the same piece, so 
+// i-d is at store position (that) - d for d up to *before.
+uint64_t iferret_piece_at_run(iferret_piece_tab_t *t, uint64_t i, uint64_t *before) {
+  uint32_t n = t->root;
+  uint64_t ls;
+
+  while (1) {
+    ls = SIZE(P(n).left);
+    if (i < ls) {
+      n = P(n).left;
+    }
+    else if (i < ls + P(n).len) {
+      *before = i - ls;
+      return P(n).start + (i - ls);
+    }
+    else {
+      i -= ls + P(n).len;
+      n = P(n).right;
+    }
+  }
+}
+
+// same, without the run
+uint64_t iferret_piece_at(iferret_piece_tab_t *t, uint64_t i) {
+  uint64_t before;
+
+  return iferret_piece_at_run(t, i, &before);
+}
+
+// replace positions s..e-1 with n from the store, starting at start
+void iferret_piece_splice(iferret_piece_tab_t *t, uint64_t s, uint64_t e, 
+                          uint64_t start, uint64_t n) {
+  uint32_t a, b, c, m;
+
+  iferret_piece_split(t, t->root, s, &a, &b);
+  iferret_piece_split(t, b, e - s, &b, &c);
+  iferret_piece_free(t, b);
+  m = (n > 0) ? iferret_piece_new(t, start, n) : 0;
+  t->root = iferret_piece_merge(t, iferret_piece_merge(t, a, m), c);
+}
+
+// put n from the store, starting at start, on the end.
+// usually they carry on from the last piece, which just gets longer.
+void iferret_piece_append(iferret_piece_tab_t *t, uint64_t start, uint64_t n) {
+  uint32_t m;
+
+  for (m = t->root; m != 0 && P(m).right != 0; m = P(m).right);
+  if (m != 0 && P(m).start + P(m).len == start) {
+    for (m = t->root; m != 0; m = P(m).right) 
+      P(m).size += n;
+    for (m = t->root; P(m).right != 0; m = P(m).right);
+    P(m).len += n;
+    return;
+  }
+  t->root = iferret_piece_merge(t, t->root, iferret_piece_new(t, start, n));
+}
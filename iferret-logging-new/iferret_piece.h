@@ -0,0 +1,39 @@
+#ifndef __IFERRET_PIECE_H_
+#define __IFERRET_PIECE_H_
+
+#include <stdint.h>
+
+// Piece tables, for splicing the back end's op store.
+// A sequence made of runs ("pieces") of consecutive positions in some
+// store, which is only ever appended to.  The pieces are kept in a treap
+// in sequence order, each node knowing how long the sequence under it
+// is, so finding what's at position i, or cutting and joining the
+// sequence anywhere, takes O(log pieces).
+
+typedef struct iferret_piece_struct_t {
+  uint64_t start;               // in the store
+  uint64_t len;
+  uint64_t size;                // length of the sequence under here
+  uint32_t prio;                // bigger ones are nearer the root
+  uint32_t left, right;         // 0 for none
+} iferret_piece_t;
+
+typedef struct iferret_piece_tab_struct_t {
+  iferret_piece_t *p;           // p[0] is never used, so 0 can mean none
+  uint32_t num;                 // p[1..num-1] have been handed out
+  uint32_t max;                 // room in p
+  uint32_t free;                // ones given back, linked through left
+  uint32_t root;
+  uint32_t seed;
+} iferret_piece_tab_t;
+
+iferret_piece_tab_t *iferret_piece_tab_create(uint64_t n);
+void iferret_piece_tab_destroy(iferret_piece_tab_t *t);
+uint64_t iferret_piece_len(iferret_piece_tab_t *t);
+uint64_t iferret_piece_at(iferret_piece_tab_t *t, uint64_t i);
+uint64_t iferret_piece_at_run(iferret_piece_tab_t *t, uint64_t i, uint64_t *before);
+void iferret_piece_splice(iferret_piece_tab_t *t, uint64_t s, uint64_t e, 
+                          uint64_t start, uint64_t n);
+void iferret_piece_append(iferret_piece_tab_t *t, uint64_t start, uint64_t n);
+
+#endif
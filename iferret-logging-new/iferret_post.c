@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "iferret_post.h"
+
+#define IFERRET_POST_INIT_SIZE 64
+#define IFERRET_POST_TAB_INIT_SIZE 1024
+
+
+static inline uint64_t iferret_post_varint(uint8_t *buf, uint64_t *off) {
+  uint64_t x = 0;
+  int shift = 0;
+  uint8_t b;
+
+  do {
+    b = buf[(*off)++];
+    x |= ((uint64_t) (b & 0x7f)) << shift;
+    shift += 7;
+  } while (b & 0x80);
+  return x;
+}
+
+// x has to be bigger than anything already in p
+void iferret_post_add(iferret_post_t *p, uint64_t x) {
+  uint64_t d;
+
+  assert (p->num == 0 || x > p->last);
+  if ((p->num % IFERRET_POST_BLOCK) == 0) {
+    if (p->num_skip == p->max_skip) {
+      p->max_skip = (p->max_skip == 0) ? IFERRET_POST_INIT_SIZE : 2 * p->max_skip;
+      p->skip = (iferret_post_skip_t *) realloc(p->skip, p->max_skip * sizeof(iferret_post_skip_t));
+      assert (p->skip != NULL);
+    }
+    p->skip[p->num_skip].first = x;
+    p->skip[p->num_skip].off = p->len;
+    p->num_skip ++;
+  }
+  else {
+    // 10 bytes is as long as a varint gets
+    if (p->len + 10 > p->max) {
+      p->max = (p->max == 0) ? IFERRET_POST_INIT_SIZE : 2 * p->max;
+      p->buf = (uint8_t *) realloc(p->buf, p->max);
+      assert (p->buf != NULL);
+    }
+    for (d = x - p->last; d >= 0x80; d >>= 7)
+      p->buf[p->len++] = (d & 0x7f) | 0x80;
+    p->buf[p->len++] = d;
+  }
+  p->last = x;
+  p->num ++;
+}
+
+// last block whose first position is <= i.  p can't be empty,
+// and i can't be before its first position.
+static uint64_t iferret_post_block(iferret_post_t *p, uint64_t i) {
+  uint64_t lo = 0, hi = p->num_skip, mid;
+
+  while (hi - lo > 1) {
+    mid = (lo + hi) / 2;
+    if (p->skip[mid].first <= i) lo = mid;
+    else hi = mid;
+  }
+  return lo;
+}
+
+static inline uint64_t iferret_post_block_end(iferret_post_t *p, uint64_t b) {
+  return (b + 1 < p->num_skip) ? p->skip[b+1].off : p->len;
+}
+
+// first position >= i, or IFERRET_POST_NONE
+uint64_t iferret_post_next(iferret_post_t *p, uint64_t i) {
+  uint64_t b, x, off, end;
+
+  if (p->num == 0 || i > p->last) return IFERRET_POST_NONE;
+  if (i <= p->skip[0].first) return p->skip[0].first;
+  b = iferret_post_block(p, i);
+  x = p->skip[b].first;
+  off = p->skip[b].off;
+  end = iferret_post_block_end(p, b);
+  while (x < i && off < end)
+    x += iferret_post_varint(p->buf, &off);
+  if (x >= i) return x;
+  // i is after everything in block b, but not after last
+  return p->skip[b+1].first;
+}
+
+// last position <= i, or IFERRET_POST_NONE
+uint64_t iferret_post_prev(iferret_post_t *p, uint64_t i) {
+  uint64_t b, x, y, off, end;
+
+  if (p->num == 0 || i < p->skip[0].first) return IFERRET_POST_NONE;
+  if (i >= p->last) return p->last;
+  b = iferret_post_block(p, i);
+  x = y = p->skip[b].first;
+  off = p->skip[b].off;
+  end = iferret_post_block_end(p, b);
+  while (off < end) {
+    x += iferret_post_varint(p->buf, &off);
+    if (x > i) break;
+    y = x;
+  }
+  return y;
+}
+
+void iferret_post_free(iferret_post_t *p) {
+  free(p->buf);
+  free(p->skip);
+  memset(p, 0, sizeof(iferret_post_t));
+}
+
+
+// Fibonacci hashing
+static inline uint64_t iferret_post_hash(iferret_post_tab_t *t, uint64_t key) {
+  return (key * 11400714819323198485ULL) & (t->size - 1);
+}
+
+static void iferret_post_tab_grow(iferret_post_tab_t *t) {
+  uint64_t *old_key;
+  iferret_post_t *old_post;
+  uint64_t old_size, i, j;
+
+  old_key = t->key;
+  old_post = t->post;
+  old_size = t->size;
+  t->size = (old_size == 0) ? IFERRET_POST_TAB_INIT_SIZE : 2 * old_size;
+  t->key = (uint64_t *) malloc(t->size * sizeof(uint64_t));
+  t->post = (iferret_post_t *) calloc(t->size, sizeof(iferret_post_t));
+  assert (t->key != NULL && t->post != NULL);
+  memset(t->key, 0xff, t->size * sizeof(uint64_t));
+  for (i=0; i<old_size; i++) {
+    if (old_key[i] == IFERRET_POST_NONE) continue;
+    for (j = iferret_post_hash(t, old_key[i]); t->key[j] != IFERRET_POST_NONE; j = (j + 1) & (t->size - 1));
+    t->key[j] = old_key[i];
+    t->post[j] = old_post[i];
+  }
+  free(old_key);
+  free(old_post);
+}
+
+// key's list, or NULL if it hasn't got one
+iferret_post_t *iferret_post_tab_find(iferret_post_tab_t *t, uint64_t key) {
+  uint64_t j;
+
+  if (t->size == 0) return NULL;
+  for (j = iferret_post_hash(t, key); t->key[j] != IFERRET_POST_NONE; j = (j + 1) & (t->size - 1)) {
+    if (t->key[j] == key)
+      return &t->post[j];
+  }
+  return NULL;
+}
+
+// key's list, which starts out empty.
+// good until the next new key.
+iferret_post_t *iferret_post_tab_get(iferret_post_tab_t *t, uint64_t key) {
+  uint64_t j;
+
+  // keep it at most half full
+  if (2 * (t->num + 1) > t->size) {
+    iferret_post_tab_grow(t);
+  }
+  for (j = iferret_post_hash(t, key); t->key[j] != IFERRET_POST_NONE; j = (j + 1) & (t->size - 1)) {
+    if (t->key[j] == key)
+      return &t->post[j];
+  }
+  t->key[j] = key;
+  t->num ++;
+  return &t->post[j];
+}
+
+void iferret_post_tab_free(iferret_post_tab_t *t) {
+  uint64_t i;
+
+  for (i=0; i<t->size; i++) {
+    if (t->key[i] != IFERRET_POST_NONE)
+      iferret_post_free(&t->post[i]);
+  }
+  free(t->key);
+  free(t->post);
+  memset(t, 0, sizeof(iferret_post_tab_t));
+}
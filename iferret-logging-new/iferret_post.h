@@ -0,0 +1,51 @@
+#ifndef __IFERRET_POST_H_
+#define __IFERRET_POST_H_
+
+#include <stdint.h>
+
+// Posting lists, for finding ops in the back end's op store without
+// scanning for them.
+// A posting list is an increasing list of positions.  It is kept as
+// varint deltas in blocks of IFERRET_POST_BLOCK, with the first position
+// of each block, and where its deltas start, on the side.  So the block
+// anything would be in is a binary search away, and then at most a
+// block's worth of deltas get decoded.
+
+#define IFERRET_POST_BLOCK 64
+#define IFERRET_POST_NONE (~((uint64_t) 0))
+
+typedef struct iferret_post_skip_struct_t {
+  uint64_t first;               // first position in the block
+  uint64_t off;                 // where the rest of the block starts in buf
+} iferret_post_skip_t;
+
+typedef struct iferret_post_struct_t {
+  uint8_t *buf;                 // deltas
+  uint64_t len, max;
+  iferret_post_skip_t *skip;    // one per block
+  uint64_t num_skip, max_skip;
+  uint64_t num;                 // number of positions
+  uint64_t last;                // the biggest one
+} iferret_post_t;
+
+void iferret_post_add(iferret_post_t *p, uint64_t x);
+uint64_t iferret_post_next(iferret_post_t *p, uint64_t i);
+uint64_t iferret_post_prev(iferret_post_t *p, uint64_t i);
+void iferret_post_free(iferret_post_t *p);
+
+
+// Posting lists by key.
+// Open addressing.  A slot whose key is IFERRET_POST_NONE is empty,
+// so that can't be a key.
+typedef struct iferret_post_tab_struct_t {
+  uint64_t *key;
+  iferret_post_t *post;         // post[j] goes with key[j]
+  uint64_t size;                // number of slots, a power of 2
+  uint64_t num;                 // number of keys
+} iferret_post_tab_t;
+
+iferret_post_t *iferret_post_tab_find(iferret_post_tab_t *t, uint64_t key);
+iferret_post_t *iferret_post_tab_get(iferret_post_tab_t *t, uint64_t key);
+void iferret_post_tab_free(iferret_post_tab_t *t);
+
+#endif
@@ -0,0 +1,406 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "iferret_log.h"
+#include "iferret_shadow.h"
+
+#define IFERRET_SHADOW_INIT_SIZE 64
+
+#define PAGE_MASK ((uint64_t) (IFERRET_SHADOW_PAGE_SIZE - 1))
+#define TABLE_MASK ((uint64_t) (IFERRET_SHADOW_TABLE_SIZE - 1))
+
+// every clean page points here.  never written.
+static uint32_t iferret_shadow_zero[IFERRET_SHADOW_PAGE_SIZE];
+
+#define ZERO iferret_shadow_zero
+
+
+static void iferret_shadow_space_add(iferret_shadow_t *s, uint64_t base, uint64_t size) {
+  iferret_shadow_space_t *sp;
+  uint32_t i;
+
+  if (s->num_spaces == s->max_spaces) {
+    s->max_spaces = (s->max_spaces == 0) ? IFERRET_SHADOW_INIT_SIZE : 2 * s->max_spaces;
+    s->space = (iferret_shadow_space_t *) realloc(s->space, s->max_spaces * sizeof(iferret_shadow_space_t));
+    assert (s->space != NULL);
+  }
+  for (i = s->num_spaces; i > 0 && s->space[i-1].base > base; i--)
+    s->space[i] = s->space[i-1];
+  sp = &s->space[i];
+  sp->base = base;
+  sp->max_pages = size >> IFERRET_SHADOW_PAGE_BITS;
+  sp->num_tables = (sp->max_pages + TABLE_MASK) >> IFERRET_SHADOW_TABLE_BITS;
+  sp->table_size = (sp->max_pages < IFERRET_SHADOW_TABLE_SIZE) ? sp->max_pages : IFERRET_SHADOW_TABLE_SIZE;
+  sp->dir = (uint32_t ***) calloc(sp->num_tables, sizeof(uint32_t **));
+  assert (sp->dir != NULL);
+  s->num_spaces ++;
+  s->last = i;
+}
+
+iferret_shadow_t *iferret_shadow_new(void) {
+  iferret_shadow_t *s;
+
+  s = (iferret_shadow_t *) calloc(1, sizeof(iferret_shadow_t));
+  assert (s != NULL);
+  iferret_shadow_space_add(s, 0, IFERRET_SHADOW_RAM_SIZE);
+  iferret_shadow_space_add(s, HD_BASE_ADDR, IFERRET_SHADOW_HD_SIZE);
+  // the empty set
+  s->max_sets = IFERRET_SHADOW_INIT_SIZE;
+  s->set = (iferret_shadow_set_t *) calloc(s->max_sets, sizeof(iferret_shadow_set_t));
+  assert (s->set != NULL);
+  s->num_sets = 1;
+  s->label_num = vslht_new();
+  return s;
+}
+
+void iferret_shadow_free(iferret_shadow_t *s) {
+  iferret_shadow_space_t *sp;
+  uint64_t i, j, k;
+
+  for (i=0; i<s->num_spaces; i++) {
+    sp = &s->space[i];
+    for (j=0; j<sp->num_tables; j++) {
+      if (sp->dir[j] == NULL) continue;
+      for (k=0; k<sp->table_size; k++) {
+        if (sp->dir[j][k] != ZERO)
+          free(sp->dir[j][k]);
+      }
+      free(sp->dir[j]);
+    }
+    free(sp->dir);
+  }
+  free(s->space);
+  for (i=0; i<s->num_sets; i++)
+    free(s->set[i].label);
+  free(s->set);
+  free(s->intern);
+  free(s->scratch);
+  for (i=0; i<s->num_labels; i++)
+    free(s->label_name[i]);
+  free(s->label_name);
+  vslht_free(s->label_num);
+  free(s);
+}
+
+
+// space p is in, or NULL if there isn't one and we weren't asked to make it
+static inline iferret_shadow_space_t *iferret_shadow_space(iferret_shadow_t *s, uint64_t p, int make) {
+  iferret_shadow_space_t *sp;
+  uint32_t lo, hi, mid;
+
+  // runs of lookups tend to be in the same space
+  sp = &s->space[s->last];
+  if (p >= sp->base && ((p - sp->base) >> IFERRET_SHADOW_PAGE_BITS) < sp->max_pages)
+    return sp;
+  // last space whose base is <= p
+  lo = 0;
+  hi = s->num_spaces;
+  while (hi - lo > 1) {
+    mid = (lo + hi) / 2;
+    if (s->space[mid].base <= p) lo = mid;
+    else hi = mid;
+  }
+  sp = &s->space[lo];
+  if (p >= sp->base && ((p - sp->base) >> IFERRET_SHADOW_PAGE_BITS) < sp->max_pages) {
+    s->last = lo;
+    return sp;
+  }
+  if (!make)
+    return NULL;
+  iferret_shadow_space_add(s, p & ~(IFERRET_SHADOW_STRAY_SIZE - 1), IFERRET_SHADOW_STRAY_SIZE);
+  return &s->space[s->last];
+}
+
+// page p is in.  the zero page if it's clean, unless make is set, in
+// which case it gets a page of its own.
+static inline uint32_t *iferret_shadow_page(iferret_shadow_t *s, uint64_t p, int make) {
+  iferret_shadow_space_t *sp;
+  uint32_t **table;
+  uint64_t i, k;
+
+  if ((sp = iferret_shadow_space(s, p, make)) == NULL)
+    return ZERO;
+  i = (p - sp->base) >> IFERRET_SHADOW_PAGE_BITS;
+  table = sp->dir[i >> IFERRET_SHADOW_TABLE_BITS];
+  if (table == NULL) {
+    if (!make)
+      return ZERO;
+    table = (uint32_t **) malloc(sp->table_size * sizeof(uint32_t *));
+    assert (table != NULL);
+    for (k=0; k<sp->table_size; k++)
+      table[k] = ZERO;
+    sp->dir[i >> IFERRET_SHADOW_TABLE_BITS] = table;
+  }
+  i &= TABLE_MASK;
+  if (table[i] == ZERO && make) {
+    table[i] = (uint32_t *) calloc(IFERRET_SHADOW_PAGE_SIZE, sizeof(uint32_t));
+    assert (table[i] != NULL);
+    s->num_pages ++;
+  }
+  return table[i];
+}
+
+// how much of p..p+n-1 is in p's page
+static inline size_t iferret_shadow_chunk(uint64_t p, size_t n) {
+  size_t m = IFERRET_SHADOW_PAGE_SIZE - (p & PAGE_MASK);
+  return (n < m) ? n : m;
+}
+
+uint32_t iferret_shadow_get(iferret_shadow_t *s, uint64_t p) {
+  return iferret_shadow_page(s, p, 0)[p & PAGE_MASK];
+}
+
+
+// Label sets.
+// A set is a sorted array of label numbers, and there's only ever one
+// set with a given array, so sets are equal iff their ids are.  Unions
+// go through a small direct-mapped memo first, since a trace tends to
+// union the same few pairs over and over.
+
+iferret_shadow_set_t *iferret_shadow_set(iferret_shadow_t *s, uint32_t id) {
+  assert (id < s->num_sets);
+  return &s->set[id];
+}
+
+static inline uint32_t iferret_shadow_set_hash(uint32_t *label, uint32_t num) {
+  uint64_t h = 14695981039346656037ULL;
+  uint32_t i;
+
+  // FNV-1a, a label at a time
+  for (i=0; i<num; i++)
+    h = (h ^ label[i]) * 1099511628211ULL;
+  return (uint32_t) (h ^ (h >> 32));
+}
+
+static void iferret_shadow_intern_grow(iferret_shadow_t *s) {
+  uint32_t i, j;
+
+  free(s->intern);
+  s->intern_size = (s->intern_size == 0) ? IFERRET_SHADOW_INIT_SIZE : 2 * s->intern_size;
+  s->intern = (uint32_t *) calloc(s->intern_size, sizeof(uint32_t));
+  assert (s->intern != NULL);
+  for (i=1; i<s->num_sets; i++) {
+    for (j = s->set[i].hash & (s->intern_size - 1); s->intern[j] != 0; j = (j + 1) & (s->intern_size - 1));
+    s->intern[j] = i;
+  }
+}
+
+// id of the set with these labels.  they're copied if it's a new one.
+static uint32_t iferret_shadow_intern(iferret_shadow_t *s, uint32_t *label, uint32_t num) {
+  iferret_shadow_set_t *x;
+  uint32_t h, j;
+
+  if (num == 0) return 0;
+  // keep it at most half full
+  if (2 * s->num_sets > s->intern_size)
+    iferret_shadow_intern_grow(s);
+  h = iferret_shadow_set_hash(label, num);
+  // slot 0 is never a set's, because set 0 isn't in here
+  for (j = h & (s->intern_size - 1); s->intern[j] != 0; j = (j + 1) & (s->intern_size - 1)) {
+    x = &s->set[s->intern[j]];
+    if (x->hash == h && x->num == num && memcmp(x->label, label, num * sizeof(uint32_t)) == 0)
+      return s->intern[j];
+  }
+  if (s->num_sets == s->max_sets) {
+    s->max_sets *= 2;
+    s->set = (iferret_shadow_set_t *) realloc(s->set, s->max_sets * sizeof(iferret_shadow_set_t));
+    assert (s->set != NULL);
+  }
+  x = &s->set[s->num_sets];
+  x->num = num;
+  x->hash = h;
+  x->label = (uint32_t *) malloc(num * sizeof(uint32_t));
+  assert (x->label != NULL);
+  memcpy(x->label, label, num * sizeof(uint32_t));
+  s->intern[j] = s->num_sets;
+  return s->num_sets ++;
+}
+
+// the set that's just label
+static uint32_t iferret_shadow_label_set(iferret_shadow_t *s, char *label) {
+  uint32_t l, id;
+
+  if (vslht_mem(s->label_num, label))
+    return vslht_find(s->label_num, label);
+  if (s->num_labels == s->max_labels) {
+    s->max_labels = (s->max_labels == 0) ? IFERRET_SHADOW_INIT_SIZE : 2 * s->max_labels;
+    s->label_name = (char **) realloc(s->label_name, s->max_labels * sizeof(char *));
+    assert (s->label_name != NULL);
+  }
+  s->label_name[s->num_labels] = strdup(label);
+  l = s->num_labels ++;
+  id = iferret_shadow_intern(s, &l, 1);
+  vslht_add(s->label_num, label, id);
+  return id;
+}
+
+uint32_t iferret_shadow_union(iferret_shadow_t *s, uint32_t a, uint32_t b) {
+  iferret_shadow_set_t *x, *y;
+  iferret_shadow_memo_t *m;
+  uint32_t *l, i, j, n, u;
+
+  if (a == b || b == 0) return a;
+  if (a == 0) return b;
+  if (a > b) {
+    u = a; a = b; b = u;
+  }
+  m = &s->memo[(((uint64_t) a << 32 | b) * 11400714819323198485ULL) >> (64 - IFERRET_SHADOW_MEMO_BITS)];
+  if (m->a == a && m->b == b) {
+    s->memo_hits ++;
+    return m->u;
+  }
+  s->memo_misses ++;
+  x = &s->set[a];
+  y = &s->set[b];
+  if (x->num + y->num > s->max_scratch) {
+    s->max_scratch = 2 * (x->num + y->num);
+    s->scratch = (uint32_t *) realloc(s->scratch, s->max_scratch * sizeof(uint32_t));
+    assert (s->scratch != NULL);
+  }
+  l = s->scratch;
+  for (i = j = n = 0; i < x->num || j < y->num; ) {
+    if (j == y->num || (i < x->num && x->label[i] < y->label[j]))
+      l[n++] = x->label[i++];
+    else if (i == x->num || y->label[j] < x->label[i])
+      l[n++] = y->label[j++];
+    else {
+      l[n++] = x->label[i++];
+      j++;
+    }
+  }
+  // one had the other in it, or it's a set we've seen
+  if (n == x->num) u = a;
+  else if (n == y->num) u = b;
+  else u = iferret_shadow_intern(s, l, n);
+  m->a = a;
+  m->b = b;
+  m->u = u;
+  return u;
+}
+
+
+// Ranges.
+
+// every byte of p..p+n-1 gets id
+static void iferret_shadow_fill(iferret_shadow_t *s, uint64_t p, size_t n, uint32_t id) {
+  uint32_t *page;
+  size_t m, i;
+
+  for (; n > 0; p += m, n -= m) {
+    m = iferret_shadow_chunk(p, n);
+    page = iferret_shadow_page(s, p, id != 0);
+    if (page == ZERO) continue;
+    for (i=0; i<m; i++)
+      page[(p & PAGE_MASK) + i] = id;
+  }
+}
+
+// every byte of p..p+n-1 gets id added to its set
+static void iferret_shadow_add(iferret_shadow_t *s, uint64_t p, size_t n, uint32_t id) {
+  uint32_t *page, *d, last_in, last_out;
+  size_t m, i;
+
+  if (id == 0) return;
+  last_in = 0;
+  last_out = id;
+  for (; n > 0; p += m, n -= m) {
+    m = iferret_shadow_chunk(p, n);
+    page = iferret_shadow_page(s, p, 1);
+    for (d = &page[p & PAGE_MASK], i=0; i<m; i++) {
+      // neighbouring bytes tend to have the same set
+      if (d[i] != last_in) {
+        last_in = d[i];
+        last_out = iferret_shadow_union(s, last_in, id);
+      }
+      d[i] = last_out;
+    }
+  }
+}
+
+void iferret_shadow_label(iferret_shadow_t *s, uint64_t p, size_t n, char *label) {
+  iferret_shadow_fill(s, p, n, iferret_shadow_label_set(s, label));
+}
+
+void iferret_shadow_add_label(iferret_shadow_t *s, uint64_t p, size_t n, char *label) {
+  iferret_shadow_add(s, p, n, iferret_shadow_label_set(s, label));
+}
+
+void iferret_shadow_delete(iferret_shadow_t *s, uint64_t p, size_t n) {
+  iferret_shadow_fill(s, p, n, 0);
+}
+
+uint8_t iferret_shadow_exists(iferret_shadow_t *s, uint64_t p, size_t n) {
+  uint32_t *page, *d;
+  size_t m, i;
+
+  for (; n > 0; p += m, n -= m) {
+    m = iferret_shadow_chunk(p, n);
+    page = iferret_shadow_page(s, p, 0);
+    if (page == ZERO) continue;
+    for (d = &page[p & PAGE_MASK], i=0; i<m; i++) {
+      if (d[i] != 0)
+        return 1;
+    }
+  }
+  return 0;
+}
+
+// p2..p2+n-1 to p1..p1+n-1
+void iferret_shadow_copy(iferret_shadow_t *s, uint64_t p1, uint64_t p2, size_t n) {
+  uint32_t *from, *to, *tmp;
+  size_t m, i;
+
+  if (p1 == p2) return;
+  // overlapping and p1 later, so going forward would read what we wrote
+  if (p1 > p2 && p1 - p2 < n
+      && (iferret_shadow_chunk(p1, n) < n || iferret_shadow_chunk(p2, n) < n)) {
+    tmp = (uint32_t *) malloc(n * sizeof(uint32_t));
+    assert (tmp != NULL);
+    for (i=0; i<n; i++)
+      tmp[i] = iferret_shadow_get(s, p2 + i);
+    for (i=0; i<n; i += m) {
+      m = iferret_shadow_chunk(p1 + i, n - i);
+      to = iferret_shadow_page(s, p1 + i, 1);
+      memcpy(&to[(p1 + i) & PAGE_MASK], &tmp[i], m * sizeof(uint32_t));
+    }
+    free(tmp);
+    return;
+  }
+  for (; n > 0; p1 += m, p2 += m, n -= m) {
+    m = iferret_shadow_chunk(p1, n);
+    m = iferret_shadow_chunk(p2, m);
+    from = iferret_shadow_page(s, p2, 0);
+    to = iferret_shadow_page(s, p1, 0);
+    if (from == ZERO) {
+      if (to == ZERO) continue;
+      memset(&to[p1 & PAGE_MASK], 0, m * sizeof(uint32_t));
+      continue;
+    }
+    if (to == ZERO)
+      to = iferret_shadow_page(s, p1, 1);
+    memmove(&to[p1 & PAGE_MASK], &from[p2 & PAGE_MASK], m * sizeof(uint32_t));
+  }
+}
+
+// a non-obliting compute: everything in p2..p2+n2-1 gets added to
+// every byte of p1..p1+n1-1
+void iferret_shadow_compute(iferret_shadow_t *s, uint64_t p1, size_t n1, uint64_t p2, size_t n2) {
+  uint32_t *page, *d, u, last;
+  size_t m, i;
+
+  for (u = last = 0; n2 > 0; p2 += m, n2 -= m) {
+    m = iferret_shadow_chunk(p2, n2);
+    page = iferret_shadow_page(s, p2, 0);
+    if (page == ZERO) continue;
+    for (d = &page[p2 & PAGE_MASK], i=0; i<m; i++) {
+      if (d[i] != 0 && d[i] != last) {
+        last = d[i];
+        u = iferret_shadow_union(s, u, last);
+      }
+    }
+  }
+  iferret_shadow_add(s, p1, n1, u);
+}
@@ -0,0 +1,108 @@
+#ifndef __IFERRET_SHADOW_H_
+#define __IFERRET_SHADOW_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "vslht.h"
+
+// Shadow memory for the info-flow back end.
+// Every byte of the address space iferret_info_flow.c works in -- guest
+// physical ram with the io buffer just past it, the fake addresses in
+// ifregaddr, and the hard drive up at HD_BASE_ADDR -- has a 32-bit
+// label-set id.  0 is the empty set.
+//
+// It's a two-level page directory per space: a space is a run of the
+// address space with a fixed directory of tables, each of which points
+// to IFERRET_SHADOW_TABLE_SIZE pages of ids.  Tables are only made when
+// something in them is labeled, so a write far into the hard drive
+// costs one table, not a directory out to there.  A page nothing
+// in has ever been labeled points to one shared page of zeros, so
+// reading clean memory costs nothing and the first write to a page
+// gets it a copy of its own.  Ram and the hard drive get a space each
+// up front.  Anything else (the register slots, mostly) gets a small
+// space the first time it's written.
+//
+// So copying a 4-byte register is a page lookup on each side and a
+// 16-byte move.
+
+#define IFERRET_SHADOW_PAGE_BITS 12
+#define IFERRET_SHADOW_PAGE_SIZE (1 << IFERRET_SHADOW_PAGE_BITS)
+
+#define IFERRET_SHADOW_TABLE_BITS 14
+#define IFERRET_SHADOW_TABLE_SIZE (1 << IFERRET_SHADOW_TABLE_BITS)
+
+// ram and the io buffer after it are under this
+#define IFERRET_SHADOW_RAM_SIZE (((uint64_t) 1) << 32)
+// biggest disk we'll follow
+#define IFERRET_SHADOW_HD_SIZE (((uint64_t) 1) << 40)
+// spaces made for addresses in neither of those are this big, and
+// aligned to it
+#define IFERRET_SHADOW_STRAY_SIZE (((uint64_t) 1) << 20)
+
+typedef struct iferret_shadow_space_struct_t {
+  uint64_t base;                // first address
+  uint64_t max_pages;           // how many pages it covers
+  uint64_t num_tables;          // how many dir has room for
+  uint32_t table_size;          // pages per table.  less than IFERRET_SHADOW_TABLE_SIZE in small spaces
+  // page i holds the ids for base + i*IFERRET_SHADOW_PAGE_SIZE..., and is 
+  // dir[i >> IFERRET_SHADOW_TABLE_BITS][i & (IFERRET_SHADOW_TABLE_SIZE - 1)].
+  // a NULL table's pages are all clean
+  uint32_t ***dir;
+} iferret_shadow_space_t;
+
+// unions remembered
+#define IFERRET_SHADOW_MEMO_BITS 12
+#define IFERRET_SHADOW_MEMO_SIZE (1 << IFERRET_SHADOW_MEMO_BITS)
+
+typedef struct iferret_shadow_set_struct_t {
+  uint32_t num;
+  uint32_t hash;
+  uint32_t *label;              // label numbers, increasing
+} iferret_shadow_set_t;
+
+// a union of a and b (a < b) was u.  a is 0 if the entry is empty.
+typedef struct iferret_shadow_memo_struct_t {
+  uint32_t a, b, u;
+} iferret_shadow_memo_t;
+
+typedef struct iferret_shadow_struct_t {
+  iferret_shadow_space_t *space;        // by base
+  uint32_t num_spaces, max_spaces;
+  uint32_t last;                        // space last looked in
+  uint64_t num_pages;                   // pages that aren't the zero page
+
+  // label sets, hash-consed.  set 0 is empty
+  iferret_shadow_set_t *set;
+  uint32_t num_sets, max_sets;
+  uint32_t *intern;                     // set ids by hash.  0 for an empty slot
+  uint32_t intern_size;
+  iferret_shadow_memo_t memo[IFERRET_SHADOW_MEMO_SIZE];
+  uint64_t memo_hits, memo_misses;
+  uint32_t *scratch;                    // for making unions in
+  uint32_t max_scratch;
+
+  // labels, by number
+  char **label_name;
+  uint32_t num_labels, max_labels;
+  vslht *label_num;
+} iferret_shadow_t;
+
+iferret_shadow_t *iferret_shadow_new(void);
+void iferret_shadow_free(iferret_shadow_t *s);
+
+// set id at p
+uint32_t iferret_shadow_get(iferret_shadow_t *s, uint64_t p);
+// sets are interned, so these never change and equal ids are equal sets
+iferret_shadow_set_t *iferret_shadow_set(iferret_shadow_t *s, uint32_t id);
+uint32_t iferret_shadow_union(iferret_shadow_t *s, uint32_t a, uint32_t b);
+
+// these take the destination first, like info_flow_copy &c
+void iferret_shadow_label(iferret_shadow_t *s, uint64_t p, size_t n, char *label);
+void iferret_shadow_add_label(iferret_shadow_t *s, uint64_t p, size_t n, char *label);
+void iferret_shadow_delete(iferret_shadow_t *s, uint64_t p, size_t n);
+uint8_t iferret_shadow_exists(iferret_shadow_t *s, uint64_t p, size_t n);
+void iferret_shadow_copy(iferret_shadow_t *s, uint64_t p1, uint64_t p2, size_t n);
+void iferret_shadow_compute(iferret_shadow_t *s, uint64_t p1, size_t n1, uint64_t p2, size_t n2);
+
+#endif
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "iferret_log.h"
+#include "iferret_taint_event.h"
+
+#define IFERRET_TAINT_EVENT_RING_MASK (IFERRET_TAINT_EVENT_RING_SIZE - 1)
+
+
+static char *iferret_taint_event_kind_name[IFERRET_TAINT_EVENT_NUM_KINDS] = {
+  "exfiltration",
+  "tainted hard drive",
+  "tainted pointer"
+};
+
+
+iferret_taint_event_sink_t *iferret_taint_event_new() {
+  iferret_taint_event_sink_t *k;
+
+  k = (iferret_taint_event_sink_t *) calloc(1, sizeof(iferret_taint_event_sink_t));
+  assert (k != NULL);
+  return k;
+}
+
+
+void iferret_taint_event_free(iferret_taint_event_sink_t *k) {
+  iferret_taint_event_stop(k);
+  free(k);
+}
+
+
+void iferret_taint_event_put(iferret_taint_event_sink_t *k, iferret_taint_event_kind_t kind,
+                             uint64_t p, uint64_t p2, uint32_t n, uint32_t set) {
+  iferret_taint_event_t *e;
+  uint64_t h;
+
+  k->count[kind] ++;
+  h = k->head;
+  if (h - k->tail == IFERRET_TAINT_EVENT_RING_SIZE) {
+    k->dropped ++;
+    return;
+  }
+  e = &(k->ring[h & IFERRET_TAINT_EVENT_RING_MASK]);
+  e->p = p;
+  e->p2 = p2;
+  e->n = n;
+  e->set = set;
+  e->kind = kind;
+  e->op = k->op;
+  // the record has to be there before the consumer can see it is
+  __sync_synchronize();
+  k->head = h + 1;
+}
+
+
+char *iferret_taint_event_kind_str(iferret_taint_event_kind_t kind) {
+  if (kind >= IFERRET_TAINT_EVENT_NUM_KINDS)
+    return "unknown";
+  return iferret_taint_event_kind_name[kind];
+}
+
+
+void iferret_taint_event_print(FILE *out, iferret_taint_event_t *e) {
+  fprintf (out, "iferret_info_flow %s: %s (%llx,%u)",
+           iferret_taint_event_kind_str(e->kind),
+           iferret_op_num_to_str(e->op),
+           (unsigned long long) e->p, e->n);
+  if (e->p2 != 0)
+    fprintf (out, " from %llx", (unsigned long long) e->p2);
+  fprintf (out, " set %u\n", e->set);
+}
+
+
+uint64_t iferret_taint_event_drain(iferret_taint_event_sink_t *k, FILE *out) {
+  uint64_t h, t;
+
+  h = k->head;
+  // and don't read records before we've seen head move past them
+  __sync_synchronize();
+  for (t = k->tail; t != h; t++)
+    iferret_taint_event_print(out, &(k->ring[t & IFERRET_TAINT_EVENT_RING_MASK]));
+  // done with them before the producer can have the slots back
+  __sync_synchronize();
+  h -= k->tail;
+  k->tail = t;
+  return h;
+}
+
+
+static void *iferret_taint_event_thread(void *arg) {
+  iferret_taint_event_sink_t *k = (iferret_taint_event_sink_t *) arg;
+  struct timespec nap;
+
+  nap.tv_sec = 0;
+  nap.tv_nsec = IFERRET_TAINT_EVENT_NAP_USEC * 1000;
+  while (!k->stop) {
+    if (iferret_taint_event_drain(k, k->out) == 0) {
+      fflush(k->out);
+      nanosleep(&nap, NULL);
+    }
+  }
+  iferret_taint_event_drain(k, k->out);
+  fflush(k->out);
+  return NULL;
+}
+
+
+void iferret_taint_event_start(iferret_taint_event_sink_t *k, FILE *out) {
+  if (k->running)
+    return;
+  k->out = out;
+  k->stop = 0;
+  if (pthread_create(&(k->thread), NULL, iferret_taint_event_thread, k) != 0) {
+    printf ("iferret_taint_event_start: can't start taint event thread\n");
+    exit(1);
+  }
+  k->running = 1;
+}
+
+
+void iferret_taint_event_stop(iferret_taint_event_sink_t *k) {
+  if (!k->running)
+    return;
+  k->stop = 1;
+  pthread_join(k->thread, NULL);
+  k->running = 0;
+}
+
+
+void iferret_taint_event_finish(iferret_taint_event_sink_t *k, FILE *out) {
+  int i;
+
+  iferret_taint_event_stop(k);
+  iferret_taint_event_drain(k, out);
+  fprintf (out, "taint events:");
+  for (i=0; i<IFERRET_TAINT_EVENT_NUM_KINDS; i++) 
+    fprintf (out, "%s %s %llu", (i == 0) ? "" : ",", 
+             iferret_taint_event_kind_str(i), (unsigned long long) k->count[i]);
+  fprintf (out, ".  %llu dropped, as the ring was full\n", (unsigned long long) k->dropped);
+  fflush(out);
+}
@@ -0,0 +1,81 @@
+#ifndef __IFERRET_TAINT_EVENT_H_
+#define __IFERRET_TAINT_EVENT_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "target-i386/iferret_ops.h"
+
+// Taint events: things iferret_info_flow.c notices while propagating
+// that someone will want to hear about.  Propagation just drops a
+// fixed-size record into a ring and carries on.  Nothing in there
+// formats, locks or touches stdout.  Whoever wants them takes them out
+// the other end: a thread started with iferret_taint_event_start, or
+// anyone calling iferret_taint_event_drain once propagation is done.
+//
+// One thread puts and one takes, so head and tail each have one
+// writer and no lock is needed.  If the ring is full the event is
+// counted and dropped rather than holding up propagation.
+
+typedef enum {
+  IFERRET_TAINT_EVENT_EXFILTRATION,     // tainted bytes went out the network
+  IFERRET_TAINT_EVENT_HD_WRITE,         // tainted bytes landed on the hard drive
+  IFERRET_TAINT_EVENT_TAINTED_PTR,      // a load went through a tainted pointer
+  IFERRET_TAINT_EVENT_NUM_KINDS
+} iferret_taint_event_kind_t;
+
+typedef struct iferret_taint_event_struct_t {
+  uint64_t p;                   // where
+  uint64_t p2;                  // from where.  the pointer, for a tainted pointer.  0 if nowhere
+  uint32_t n;                   // bytes at p
+  uint32_t set;                 // label set id of the first tainted byte
+  uint16_t kind;                // iferret_taint_event_kind_t
+  uint16_t op;                  // op being processed
+} iferret_taint_event_t;
+
+#define IFERRET_TAINT_EVENT_RING_BITS 14
+#define IFERRET_TAINT_EVENT_RING_SIZE (1 << IFERRET_TAINT_EVENT_RING_BITS)
+
+// consumer thread naps this long when the ring is empty
+#define IFERRET_TAINT_EVENT_NAP_USEC 1000
+
+typedef struct iferret_taint_event_sink_struct_t {
+  // only the propagating thread writes these
+  volatile uint64_t head;               // next slot to fill
+  iferret_log_op_enum_t op;             // stamped on events
+  uint64_t dropped;                     // ring was full
+  uint64_t count[IFERRET_TAINT_EVENT_NUM_KINDS];
+  // keep the consumer's index off the producer's cache line
+  char pad[64];
+  volatile uint64_t tail;               // next slot to take
+  volatile uint8_t stop;
+  uint8_t running;
+  pthread_t thread;
+  FILE *out;
+  iferret_taint_event_t ring[IFERRET_TAINT_EVENT_RING_SIZE];
+} iferret_taint_event_sink_t;
+
+iferret_taint_event_sink_t *iferret_taint_event_new(void);
+// stops the thread, if there is one.  whatever is left is lost
+void iferret_taint_event_free(iferret_taint_event_sink_t *k);
+
+void iferret_taint_event_put(iferret_taint_event_sink_t *k, iferret_taint_event_kind_t kind,
+                             uint64_t p, uint64_t p2, uint32_t n, uint32_t set);
+
+// format whatever is in the ring to out.  returns how many there were.
+// not while the thread is running
+uint64_t iferret_taint_event_drain(iferret_taint_event_sink_t *k, FILE *out);
+
+// a thread to format events to out as they come
+void iferret_taint_event_start(iferret_taint_event_sink_t *k, FILE *out);
+// stop it, once it has formatted everything put so far
+void iferret_taint_event_stop(iferret_taint_event_sink_t *k);
+// once propagation is done: stop the thread, format what is left to out, 
+// and say how many of each kind there were and how many didn't fit
+void iferret_taint_event_finish(iferret_taint_event_sink_t *k, FILE *out);
+
+char *iferret_taint_event_kind_str(iferret_taint_event_kind_t kind);
+void iferret_taint_event_print(FILE *out, iferret_taint_event_t *e);
+
+#endif
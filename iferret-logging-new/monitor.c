@@ -37,6 +37,7 @@
 #include <dirent.h>
 
 #include "iferret_log.h"
+#include "target-i386/iferret_filter.h"
 
 #ifdef CONFIG_PROFILER
 #include "qemu-timer.h" /* for ticks_per_sec */
@@ -54,6 +55,7 @@ extern uint64_t iferret_syscall_hits;
 extern uint64_t iferret_syscall_misses;
 extern uint32_t iferret_log_inc;
 extern uint32_t iferret_log_rollup_count;
+extern char *iferret_log_prefix;
 
 /*
  * Supported types:
@@ -485,6 +487,38 @@ static void do_newlog(void) {
     iferret_log_rollup_count = 0;
 }
 
+static void do_iferret_filter(const char *spec)
+{
+    if (spec == NULL) {
+        iferret_filter_dump(NULL, monitor_fprintf);
+    }
+    else if (!strcmp(spec, "clear")) {
+        iferret_filter_clear();
+    }
+    else if (!iferret_filter_add(spec)) {
+        term_printf("bad filter '%s'\n", spec);
+        help_cmd("iferret_filter");
+    }
+}
+
+static void do_info_iferret(void)
+{
+    term_printf("log prefix     %s.%d\n", iferret_log_prefix, iferret_log_inc);
+    term_printf("rollups        %" PRIu64 " (%" PRIu64 " bytes written)\n",
+                iferret_log_rollups, iferret_log_bytes_written);
+    term_printf("codec          %s (%" PRIu64 " bytes on disk)\n",
+                iferret_log_codecs[iferret_log_codec].name,
+                iferret_log_disk_bytes_written);
+    term_printf("buffers        %d %s (%d waiting for writer)\n",
+                IFERRET_LOG_NUM_BUFS, iferret_log_mmap ? "mmap'd" : "in memory",
+                iferret_log_bufs_pending());
+    term_printf("writer stalls  %" PRIu64 " (total %0.3f s, max %0.3f s)\n",
+                iferret_log_stalls, iferret_log_stall_usec / 1000000.0,
+                iferret_log_stall_max_usec / 1000000.0);
+    term_printf("filter         ");
+    iferret_filter_dump(NULL, monitor_fprintf);
+}
+
 static void do_stop(void)
 {
     vm_stop(EXCP_INTERRUPT);
@@ -1337,6 +1371,8 @@ static term_cmd_t term_cmds[] = {
       "tag|id", "delete a VM snapshot from its tag or id" },
     { "newlog", "", do_newlog,
        "", "change to a new logfile" },
+    { "iferret_filter", "s?", do_iferret_filter,
+      "[clear|cr3=X,pid=N,va=A-B,...]", "only trace the processes and code the filter picks" },
     { "stop", "", do_stop,
       "", "stop emulation", },
     { "c|cont", "", do_cont,
@@ -1458,6 +1494,8 @@ static term_cmd_t info_cmds[] = {
       "", "show the vnc server status"},
     { "name", "", do_info_name,
       "", "show the current VM name" },
+    { "iferret", "", do_info_iferret,
+      "", "show iferret log rollup and writer stall statistics" },
 #if defined(TARGET_PPC)
     { "cpustats", "", do_info_cpu_stats,
       "", "show CPU statistics", },
@@ -34,7 +34,6 @@
 target_phys_addr_t cpu_get_phys_addr(CPUState *env, target_ulong addr);
 int cpu_virtual_memory_read(CPUState *env, uint32_t addr, char *out, uint32_t length);
 
-extern uint8_t iferret_says_flush;
 extern char *iferret_log_prefix;
 extern uint32_t iferret_log_inc;
 extern uint32_t iferret_log_rollup_count;
@@ -770,7 +769,7 @@ static void do_interrupt_protected(int intno, int is_int, int error_code,
     else
         old_eip = env->eip;
 
-    if(iferret_info_flow)
+    if(iferret_tracing())
         iferret_log_op_write_441(IFLO_INTERRUPT, intno, old_eip, is_int);
 
     dt = &env->idt;
@@ -1806,7 +1805,7 @@ void helper_divl_EAX_T0(void)
         raise_exception(EXCP00_DIVZ);
 
     //  IFLW(DIVL_EAX_T0);
-    if(iferret_info_flow)
+    if(iferret_tracing())
         iferret_log_op_write_0(IFLO_DIVL_EAX_T0);
 
     EAX = (uint32_t)q;
@@ -1833,7 +1832,7 @@ void helper_idivl_EAX_T0(void)
         raise_exception(EXCP00_DIVZ);
 
     //  IFLW(IDIVL_EAX_T0);
-    if(iferret_info_flow)
+    if(iferret_tracing())
         iferret_log_op_write_0(IFLO_IDIVL_EAX_T0);
     
     EAX = (uint32_t)q;
@@ -1850,7 +1849,7 @@ void helper_cmpxchg8b(void)
     if (d == (((uint64_t)EDX << 32) | EAX)) {
 
       //      IFLW(CMPXCHG8B_PART1);
-        if(iferret_info_flow)
+        if(iferret_tracing())
           iferret_log_op_write_4(IFLO_CMPXCHG8B_PART1, phys_a0());
 
         stq(A0, ((uint64_t)ECX << 32) | EBX);
@@ -1863,7 +1862,7 @@ void helper_cmpxchg8b(void)
         EAX = d;
 
 	//	IFLW(CMPXCHG8B_PART2);	
-    if(iferret_info_flow)
+    if(iferret_tracing())
         iferret_log_op_write_4(IFLO_CMPXCHG8B_PART2, phys_a0());
 
 	// no addr necessary here -- we are just setting EDX/EAX to the 64bits that 
@@ -2795,7 +2794,7 @@ static inline void helper_ret_protected(int shift, int is_iret, int addend)
         sp += addend;
     }
 
-    if (is_iret && iferret_info_flow) {
+    if (is_iret && iferret_tracing()) {
         iferret_log_op_write_41(IFLO_IRET_PROTECTED,phys_addr(old_esp),rpl != cpl);
     }
 
@@ -4855,11 +4854,37 @@ void write_eip_to_iferret_log(target_ulong pc) {
 #endif // IFERRET_PHYS_EIP
 }
 
+// head of tb with log template schema.  
+// first time through in this log chunk, learn the template.
+// after that, log an instance of it.
+void iferret_tb_enter(uint32_t schema) {
+  iferret_tb_schema_t *s;
+
+  if (!iferret_info_flow) return;
+  iferret_log_tb_leave_check();
+  s = iferret_log_tb_schema_get(schema);
+  if (s->epoch != iferret_log_tb_epoch) {
+    iferret_log_op_write_41(IFLO_TB_SCHEMA, schema, 0);
+    iferret_log_tb_learn(s);
+  }
+  else if (s->num_ops > 0) {
+    iferret_log_op_write_41(IFLO_TB_INSTANCE, schema, 0);
+    iferret_log_tb_instance(s);
+  }
+  // else nothing in this tb gets logged by info-flow ops.  no point.
+}
+
+// an untraced tb.  a traced one chained into it may have left its
+// template open, and helpers in here shouldn't land in it.
+void iferret_tb_skip(void) {
+  iferret_log_tb_leave_check();
+}
+
 void helper_setlogstate(int state) {
     int oldstate;
-    if(state != iferret_info_flow)
-        iferret_says_flush = 1;
 
+    // nothing to flush.  tbs for the new mode get looked up (or 
+    // translated) from the next tb on.  see iferret_tb_cflags.
     oldstate = iferret_info_flow;
     iferret_info_flow = state;
     if(state == 1) {
@@ -4953,20 +4978,31 @@ void iferret_debug_log_rollup() {
 }
 
 
+// only has anything to do once the log has hit its guard page.
+// see iferret_log.c
 void check_rollup(char *label) { 
-  uint32_t remaining;
-  remaining = IFERRET_LOG_SIZE - (iferret_log_ptr - iferret_log_base);
+  int64_t remaining;
+
+  if (!iferret_log_full) 
+    return;
+  remaining = iferret_log_room();
   //  printf ("label=%s remaining=%d   cushion=%d\n", label, remaining, IFERRET_LOG_CUSHION);
-  if (remaining < IFERRET_LOG_CUSHION) {
+  if (remaining <= 0) {
     uint32_t overflow;
-    overflow = IFERRET_LOG_CUSHION - remaining;
+    overflow = -remaining;
     printf ("calling rollup label=[%s]\n", label);
     if (overflow > iferret_max_overflow) {
       iferret_max_overflow = overflow;
       printf ("max overflow into cushion so far: %d\n", iferret_max_overflow);
     }
+    // arms the guard in the next buffer
     iferret_log_rollup(label);
   }   
+  else {
+    // tb boundary.  good place to end a log block.
+    iferret_log_block_check();
+    iferret_log_guard_arm();
+  }
 } 
 
 void check_rollup_op() {
@@ -0,0 +1,212 @@
+/*
+ * iferret trace filter.
+ *
+ * Picks which tbs get translated with the info-flow logging ops.
+ * Everything else runs the plain dyngen code, so with a filter set
+ * we only pay for logging the program(s) we care about.
+ *
+ * A filter is a set of cr3 values, pids and virtual address ranges,
+ * given as a comma-separated spec, e.g. "pid=1234,va=0x8048000-0x8100000".
+ * cr3s and pids pick processes, ranges pick code (by tb start) within
+ * them.  A kind with nothing in it doesn't restrict, so the empty
+ * filter traces everything.
+ *
+ * A pid is turned into a cr3 the first time iferret_get_current_pid_uid
+ * sees it running, i.e. at its first system call after the filter is set.
+ *
+ * The decision is made at tb lookup.  See iferret_tb_cflags in exec-all.h.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "cpu.h"
+#include "exec-all.h"
+#include "iferret_filter.h"
+
+typedef struct iferret_filter_range_struct_t {
+  target_ulong start;
+  target_ulong end;             // exclusive
+} iferret_filter_range_t;
+
+static target_ulong iferret_filter_cr3s[IFERRET_FILTER_MAX];
+static int iferret_filter_num_cr3s = 0;
+static uint32_t iferret_filter_pids[IFERRET_FILTER_MAX];
+static int iferret_filter_num_pids = 0;
+static iferret_filter_range_t iferret_filter_ranges[IFERRET_FILTER_MAX];
+int iferret_filter_num_ranges = 0;
+
+// TRUE iff the current process is being traced.
+uint8_t iferret_filter_proc = 1;
+static target_ulong iferret_filter_cur_cr3 = 0;
+
+
+static inline int iferret_filter_cr3_match(target_ulong cr3) {
+  int i;
+  for (i=0; i<iferret_filter_num_cr3s; i++) {
+    if (iferret_filter_cr3s[i] == cr3)
+      return 1;
+  }
+  return 0;
+}
+
+static inline void iferret_filter_proc_update(void) {
+  iferret_filter_proc =
+    (iferret_filter_num_cr3s == 0 && iferret_filter_num_pids == 0)
+    || iferret_filter_cr3_match(iferret_filter_cur_cr3);
+}
+
+// existing tbs were translated under the old filter, and their chains
+// encode its decisions.  filter changes are rare; just start over.
+static void iferret_filter_changed(void) {
+  if (first_cpu) {
+    iferret_filter_cur_cr3 = first_cpu->cr[3];
+    tb_flush(first_cpu);
+  }
+  iferret_filter_proc_update();
+}
+
+
+// called by cpu_x86_update_cr3.
+void iferret_filter_cr3(target_ulong cr3) {
+  iferret_filter_cur_cr3 = cr3;
+  iferret_filter_proc_update();
+}
+
+
+// called by iferret_get_current_pid_uid once it knows who's running.
+void iferret_filter_pid(uint32_t pid, target_ulong cr3) {
+  int i;
+
+  if (iferret_filter_num_pids == 0 || iferret_filter_cr3_match(cr3))
+    return;
+  for (i=0; i<iferret_filter_num_pids; i++) {
+    if (iferret_filter_pids[i] == pid) {
+      if (iferret_filter_num_cr3s == IFERRET_FILTER_MAX) {
+        fprintf (stderr, "iferret filter: no room for cr3 of pid %u\n", pid);
+        return;
+      }
+      printf ("iferret filter: pid %u has cr3 0x" TARGET_FMT_lx "\n", pid, cr3);
+      iferret_filter_cr3s[iferret_filter_num_cr3s++] = cr3;
+      // we're in system call entry, between tbs.  the next one gets
+      // looked up as part of this process.
+      iferret_filter_proc_update();
+      return;
+    }
+  }
+}
+
+
+// TRUE iff pc falls in one of the ranges.
+int iferret_filter_pc(target_ulong pc) {
+  int i;
+  for (i=0; i<iferret_filter_num_ranges; i++) {
+    if (pc >= iferret_filter_ranges[i].start && pc < iferret_filter_ranges[i].end)
+      return 1;
+  }
+  return 0;
+}
+
+
+static int iferret_filter_add_item(char *item) {
+  char *val, *end;
+  target_ulong start, stop;
+
+  val = strchr(item, '=');
+  if (val == NULL)
+    return 0;
+  *val++ = '\0';
+  if (!strcmp(item, "cr3")) {
+    if (iferret_filter_num_cr3s == IFERRET_FILTER_MAX)
+      return 0;
+    start = strtoull(val, &end, 0);
+    if (end == val || *end != '\0')
+      return 0;
+    iferret_filter_cr3s[iferret_filter_num_cr3s++] = start;
+  }
+  else if (!strcmp(item, "pid")) {
+    if (iferret_filter_num_pids == IFERRET_FILTER_MAX)
+      return 0;
+    start = strtoul(val, &end, 0);
+    if (end == val || *end != '\0')
+      return 0;
+    iferret_filter_pids[iferret_filter_num_pids++] = start;
+  }
+  else if (!strcmp(item, "va")) {
+    if (iferret_filter_num_ranges == IFERRET_FILTER_MAX)
+      return 0;
+    start = strtoull(val, &end, 0);
+    if (end == val || *end != '-')
+      return 0;
+    val = end + 1;
+    stop = strtoull(val, &end, 0);
+    if (end == val || *end != '\0' || stop <= start)
+      return 0;
+    iferret_filter_ranges[iferret_filter_num_ranges].start = start;
+    iferret_filter_ranges[iferret_filter_num_ranges].end = stop;
+    iferret_filter_num_ranges++;
+  }
+  else {
+    return 0;
+  }
+  return 1;
+}
+
+
+// add the items in spec to the filter.
+// returns 0 if spec doesn't parse, in which case the filter is unchanged.
+int iferret_filter_add(const char *spec) {
+  int num_cr3s, num_pids, num_ranges, ok;
+  char *buf, *item, *save;
+
+  num_cr3s = iferret_filter_num_cr3s;
+  num_pids = iferret_filter_num_pids;
+  num_ranges = iferret_filter_num_ranges;
+  buf = strdup(spec);
+  ok = 1;
+  for (item = strtok_r(buf, ",", &save); item != NULL; item = strtok_r(NULL, ",", &save)) {
+    if (!iferret_filter_add_item(item)) {
+      ok = 0;
+      break;
+    }
+  }
+  free(buf);
+  if (!ok) {
+    iferret_filter_num_cr3s = num_cr3s;
+    iferret_filter_num_pids = num_pids;
+    iferret_filter_num_ranges = num_ranges;
+    return 0;
+  }
+  iferret_filter_changed();
+  return 1;
+}
+
+
+// back to tracing everything.
+void iferret_filter_clear() {
+  iferret_filter_num_cr3s = 0;
+  iferret_filter_num_pids = 0;
+  iferret_filter_num_ranges = 0;
+  iferret_filter_changed();
+}
+
+
+void iferret_filter_dump(FILE *f, int (*cpu_fprintf)(FILE *f, const char *fmt, ...)) {
+  int i;
+
+  if (iferret_filter_num_cr3s == 0 && iferret_filter_num_pids == 0
+      && iferret_filter_num_ranges == 0) {
+    cpu_fprintf(f, "none (everything is traced)\n");
+    return;
+  }
+  for (i=0; i<iferret_filter_num_cr3s; i++)
+    cpu_fprintf(f, "cr3=0x" TARGET_FMT_lx " ", iferret_filter_cr3s[i]);
+  for (i=0; i<iferret_filter_num_pids; i++)
+    cpu_fprintf(f, "pid=%u ", iferret_filter_pids[i]);
+  for (i=0; i<iferret_filter_num_ranges; i++)
+    cpu_fprintf(f, "va=0x" TARGET_FMT_lx "-0x" TARGET_FMT_lx " ",
+                iferret_filter_ranges[i].start, iferret_filter_ranges[i].end);
+  cpu_fprintf(f, "(current process %s)\n", iferret_filter_proc ? "traced" : "not traced");
+}
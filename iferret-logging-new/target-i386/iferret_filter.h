@@ -0,0 +1,19 @@
+#ifndef __IFERRET_FILTER_H_
+#define __IFERRET_FILTER_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+// selective instrumentation.  see iferret_filter.c
+
+#define IFERRET_FILTER_MAX 16
+
+int iferret_filter_add(const char *spec);
+void iferret_filter_clear(void);
+void iferret_filter_dump(FILE *f, int (*cpu_fprintf)(FILE *f, const char *fmt, ...));
+
+// hooks
+void iferret_filter_cr3(target_ulong cr3);
+void iferret_filter_pid(uint32_t pid, target_ulong cr3);
+
+#endif
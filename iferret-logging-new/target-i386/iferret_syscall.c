@@ -29,6 +29,7 @@
 #include "../iferret_log.h"
 #include "iferret_syscall.h"
 #include "iferret_syscall_stack.h"
+#include "iferret_filter.h"
 
 extern struct CPUX86State *env;
 extern pid_t pid;
@@ -412,6 +413,8 @@ void iferret_get_current_pid_uid() {
         iferret_get_current_pid_uid_win();
         break;
   }
+  // trace filter may be waiting to learn this pid's cr3
+  iferret_filter_pid(current_pid, env->cr[3]);
 }
 
 static inline uint32_t get_uint32_t_phys(uint32_t virt_addr) {
@@ -424,22 +427,6 @@ static inline uint32_t get_uint32_t_phys(uint32_t virt_addr) {
   return(retval);
 }
 
-void iferret_check_log_full() {
-  // NB: if we *arent* doing info-flow, then
-  // we can get away with checking the log only
-  // whenever we do any syscall logging.  
-  // but, if we *are* doing info-flow, there's not much point, eh? 
-#ifndef IFERRET_INFO_FLOW
-  // check if info flow log is anywhere near overflow
-  check_rollup("iferret_syscall.c");
-  /*
-  if ((iferret_log_ptr - iferret_log_base) + 10000 > IFERRET_LOG_SIZE) {
-    iferret_log_rollup();
-  }
-  */
-#endif
-}
-
 // write an entry to iferret log to capture
 // context (eip & pid), number, and arguments of 
 // current system call 
@@ -452,7 +439,6 @@ void iferret_log_syscall_enter_lin (uint8_t is_sysenter, uint32_t eip_for_callsi
   }
   */
 
-  iferret_check_log_full();
   iferret_get_current_pid_uid();
 
   //target_phys_addr_t paddr; 
@@ -564,7 +550,6 @@ void iferret_log_syscall_enter_lin (uint8_t is_sysenter, uint32_t eip_for_callsi
 
 void iferret_log_syscall_enter_win (uint8_t is_sysenter, uint32_t eip_for_callsite) {
 #ifdef IFERRET_SYSCALL
-    iferret_check_log_full();
     iferret_get_current_pid_uid();
 
     char command[COMM_SIZE];
@@ -631,7 +616,6 @@ void iferret_log_syscall_ret_linux(uint8_t is_iret, uint32_t callsite_esp, uint3
   }
   */
 
-  iferret_check_log_full();
   iferret_get_current_pid_uid();
     
   // get addr of pointer to current task
@@ -722,7 +706,6 @@ void iferret_log_syscall_ret_win(uint8_t is_iret, uint32_t callsite_esp, uint32_
     // We don't care about INT-based syscalls for now
     if (is_iret) return;
 
-    iferret_check_log_full();
     iferret_get_current_pid_uid();
 
     pid = iferret_get_current_pid_win();
@@ -88,6 +88,9 @@ my @v = ("a1", "a2", "a3", "a4", "a5", "a6", "a7", "a8", "a9", "a10", "a11", "a1
 
 my %iferret_fmts;
 
+# args of a memory op that its page context stands in for.  phys, pdpe, pde, pte.
+my $page_mask = 0x3a;
+
 #mz this will get called by File::Find()
 use File::Find();
 
@@ -662,6 +665,12 @@ EOF
         $enum[$ii]{comment} = $comment;
         $enum[$ii]{format} = $ops{$opname}{format};
         $enum[$ii]{args} = ();
+        if (exists $ops{$opname}{static}) {
+            $enum[$ii]{static} = $ops{$opname}{static};
+        }
+        if (exists $ops{$opname}{page}) {
+            $enum[$ii]{page} = $ops{$opname}{page};
+        }
         $ii++;
     }
     
@@ -798,6 +807,9 @@ my %win_call_names = ();
         print OPS "\n";
     }
     print OPS "} iferret_log_op_enum_t;\n";
+    print OPS "\n";
+    print OPS "// most bytes any one op without string args can take up in the log\n";
+    print OPS "\#define IFERRET_LOG_OP_MAX_SIZE " . &op_max_size(\@enum) . "\n";
     print OPS "\#endif\n";
     close OPS;
 
@@ -869,6 +881,7 @@ my %win_call_names = ();
     print STR "// It contains a large number of functions that take an info-flow\n";
     print STR "// op as input and return a pointer to a string representing it. \n";
     print STR "#include <stdio.h>\n";
+    print STR "#include <stdint.h>\n";
     print STR "#include \"iferret_ops.h\"\n";
     print STR "\n";   
     print STR "char *iferret_op_num_to_str(iferret_log_op_enum_t op_num) {\n";
@@ -883,9 +896,98 @@ my %win_call_names = ();
     print STR "  }\n";
     print STR "  return rv;\n";
     print STR "}\n";
+    print STR "\n";
+    # which args of each op are static, and so left out of tb template instances
+    print STR "uint32_t iferret_log_arg_static[] = {\n";
+    for (my $i=0; $i<scalar @enum; $i++) {
+        my $static = 0;
+        if (exists $enum[$i]{static}) {
+            $static = $enum[$i]{static};
+        }
+        printf STR "  0x%x", $static;
+        if ($i < (scalar @enum)-1) {
+            print STR ",";
+        }
+        print STR " // $enum[$i]{opname}\n";
+    }
+    print STR "};\n";
+    print STR "\n";
+    # which args of each op come from the page context, and so are left out
+    print STR "uint32_t iferret_log_arg_page[] = {\n";
+    for (my $i=0; $i<scalar @enum; $i++) {
+        my $page = 0;
+        if (exists $enum[$i]{page}) {
+            $page = $enum[$i]{page};
+        }
+        printf STR "  0x%x", $page;
+        if ($i < (scalar @enum)-1) {
+            print STR ",";
+        }
+        print STR " // $enum[$i]{opname}\n";
+    }
+    print STR "};\n";
     close STR;
     
 
+# the info-flow back end's dispatch table.  iferret_info_flow.c has an
+# IF_OP(IFLO_A, IFLO_B, ...) line for each handler, named after IFLO_A.
+# handlers inside #if 0 aren't compiled, so they don't count.
+    my %enumNum;
+    for (my $i=0; $i<scalar @enum; $i++) {
+        $enumNum{$enum[$i]{opname}} = $i;
+    }
+    my @handler;
+    open F, "$iferretDir/iferret_info_flow.c";
+    my $if0Depth = 0;
+    while (my $line = <F>) {
+        if ($if0Depth > 0) {
+            if ($line =~ /^\s*\#\s*if/) {
+                $if0Depth ++;
+            }
+            elsif ($line =~ /^\s*\#\s*endif/) {
+                $if0Depth --;
+            }
+            next;
+        }
+        if ($line =~ /^\s*\#\s*if\s+0\b/) {
+            $if0Depth = 1;
+            next;
+        }
+        if (!($line =~ /^IF_OP\((.*)\)\s*\{/)) {
+            next;
+        }
+        my @names = split /\s*,\s*/, $1;
+        foreach my $name (@names) {
+            if (!(exists $enumNum{$name})) {
+                print "iferret_info_flow.c has a handler for $name, which isn't an op\n";
+                next;
+            }
+            if ($enumNum{$name} >= $enumNum{"IFLO_SYS_CALLS_START"}) {
+                print "iferret_info_flow.c has a handler for $name, which isn't an info-flow op\n";
+                next;
+            }
+            $handler[$enumNum{$name}] = "if_op_$names[0]";
+        }
+    }
+    close F;
+    open DIS, ">iferret_info_flow_dispatch.h";
+    print DIS "// NB: This code is auto-generated by make_iferret_code.pl. \n";
+    print DIS "// It maps each info-flow op to its handler in iferret_info_flow.c.\n";
+    print DIS "// Ops without one have no info flow.\n";
+    print DIS "\#ifndef __IFERRET_INFO_FLOW_DISPATCH_H_ \n";
+    print DIS "\#define __IFERRET_INFO_FLOW_DISPATCH_H_ \n";
+    print DIS "\n";
+    print DIS "static const iferret_info_flow_handler_t iferret_info_flow_handler[IFLO_SYS_CALLS_START] = {\n";
+    for (my $i=0; $i<scalar @handler; $i++) {
+        if (defined $handler[$i]) {
+            print DIS "  [$enum[$i]{opname}] = $handler[$i],\n";
+        }
+    }
+    print DIS "};\n";
+    print DIS "\#endif\n";
+    close DIS;
+
+
 # for each format we actually saw in code, create the various required functions
 
     my $fnsfh = do {local *FNS} ;
@@ -906,7 +1008,7 @@ my %win_call_names = ();
         &write_formals($fnsfh, $fmt);
         print $fnsfh ")\n{\n";
         print $fnsfh "  iferret_log_op_write_prologue(op_num);\n";
-        &write_log_calls($fnsfh, $fmt);
+        &write_log_calls($fnsfh, $fmt, "op_num");
         print $fnsfh "}\n\n";
 
         # The info-flow version
@@ -916,8 +1018,13 @@ my %win_call_names = ();
         print $fnsfh ")\n{\n";
         print $fnsfh "\#ifdef IFERRET_LOGTHING_ON\n";
         #print $fnsfh "  if (iferret_info_flow == TRUE) {\n";
-        print $fnsfh "  iferret_log_op_write_prologue(op_num);\n";
-        &write_log_calls($fnsfh, $fmt);
+        print $fnsfh "  if (iferret_log_tb_op(op_num)) {\n";
+        print $fnsfh "    // tb template has this op.  just the dynamic args.\n";
+        &write_dynamic_log_calls($fnsfh, $fmt, "op_num");
+        print $fnsfh "    return;\n";
+        print $fnsfh "  }\n";
+        print $fnsfh "  iferret_log_op_write_prologue_in_tb(op_num);\n";
+        &write_log_calls($fnsfh, $fmt, "op_num");
         #print $fnsfh "  }\n";
         print $fnsfh "\#endif\n";
         print $fnsfh "}\n\n";
@@ -931,7 +1038,7 @@ my %win_call_names = ();
         print $fnsfh "\#ifdef IFERRET_SYSCALL \n";
         print $fnsfh "  iferret_log_op_write_prologue(op_num);\n";
         #print $fnsfh "  iferret_log_syscall_commoner(sc);\n";
-        &write_log_calls($fnsfh, $fmt);
+        &write_log_calls($fnsfh, $fmt, "op_num");
         print $fnsfh "\#endif\n";
         print $fnsfh "}\n\n";
 
@@ -948,7 +1055,7 @@ my %win_call_names = ();
         print $fnsfh "\#ifdef IFERRET_SYSCALL \n";
         print $fnsfh "  iferret_log_op_write_prologue(sc->op_num);\n";
         #print $fnsfh "  iferret_log_syscall_commoner(sc);\n";
-        &write_log_calls($fnsfh, $fmt);
+        &write_log_calls($fnsfh, $fmt, "sc->op_num");
         print $fnsfh "\#endif\n";
         print $fnsfh "}\n\n";
 
@@ -959,7 +1066,7 @@ my %win_call_names = ();
         print $fnsfh ")\n{\n";
         print $fnsfh "\#ifdef IFERRET_SYSCALL \n";
         print $fnsfh "  iferret_log_op_write_prologue(op_num);\n";
-        &write_log_calls($fnsfh, $fmt);
+        &write_log_calls($fnsfh, $fmt, "op_num");
         print $fnsfh "\#endif\n";
         print $fnsfh "}\n\n";
         
@@ -1003,22 +1110,95 @@ sub write_formals() {
 }
 
 
+# $op is the expression for the op number, which, together with the
+# position of the arg, decides what the arg is delta-encoded against.
 sub write_log_calls() {
-    my ($fnsfh, $fmt) = @_;
+    my ($fnsfh, $fmt, $op) = @_;
     
     my $l = length $fmt;
+    my $paged = &page_fmt($fmt);
     for (my $i=0; $i<$l; $i++) {
         my $f = substr($fmt,$i,1);
         if ($f eq "0") { 
             last; 
         }
         if ($f eq "p") {
-            print $fnsfh "  iferret_log_write_4($v[$i]);\n";
+            $f = "4";
+        }
+        if ($paged && ((1 << $i) & $page_mask)) {
+            printf $fnsfh "  if (!(iferret_log_op_page($op) & 0x%x)) iferret_log_arg_write_$f($op, $i, $v[$i]);\n", (1 << $i);
         }
         else {
-            print $fnsfh "  iferret_log_write_$f($v[$i]);\n";
+            print $fnsfh "  iferret_log_arg_write_$f($op, $i, $v[$i]);\n";
         }
     }
+    if ($paged) {
+        &write_page_ctx_call($fnsfh, $op, "  ");
+    }
+}
+
+
+# page-walk args of memory ops.  phys, virt, pdpe, pde, pte in args 1-5.
+# phys and the walk get logged in a page context, only when it changes.
+# worst-case size of an op's record, in either log format, over the ops
+# with no string args.  the translator uses it to bound what a tb can log.
+sub op_max_size() {
+    my ($raEnum) = @_;
+    my %argMax = ("1" => 1, "2" => 3, "4" => 5, "p" => 5, "8" => 10);
+    my $max = 0;
+    for (my $i=0; $i<scalar @{$raEnum}; $i++) {
+        my $fmt = $raEnum->[$i]{format};
+        next if ($fmt =~ /s/);
+        # op number and sentinel
+        my $size = 5 + 4;
+        if ($fmt ne "0") {
+            foreach my $a (split //, $fmt) {
+                $size += $argMax{$a};
+            }
+        }
+        if (exists $raEnum->[$i]{page} && $raEnum->[$i]{page}) {
+            # page context flag and its four words
+            $size += 1 + 4*5;
+        }
+        $max = $size if ($size > $max);
+    }
+    return $max;
+}
+
+sub page_fmt() {
+    my ($fmt) = @_;
+    return (length $fmt >= 6 && substr($fmt,1,5) eq "44444");
+}
+
+sub write_page_ctx_call() {
+    my ($fnsfh, $op, $indent) = @_;
+    print $fnsfh "${indent}if (iferret_log_op_page($op)) iferret_log_page_ctx_write($op, $v[1], $v[2], $v[3], $v[4], $v[5]);\n";
+}
+
+
+# like write_log_calls, but leaves out args the tb template has
+sub write_dynamic_log_calls() {
+    my ($fnsfh, $fmt, $op) = @_;
+    
+    my $l = length $fmt;
+    if ($fmt eq "0") {
+        return;
+    }
+    my $paged = &page_fmt($fmt);
+    print $fnsfh "    uint32_t st = iferret_log_arg_static[$op];\n";
+    if ($paged) {
+        print $fnsfh "    st |= iferret_log_op_page($op);\n";
+    }
+    for (my $i=0; $i<$l; $i++) {
+        my $f = substr($fmt,$i,1);
+        if ($f eq "p") {
+            $f = "4";
+        }
+        printf $fnsfh "    if (!(st & 0x%x)) iferret_log_arg_write_$f($op, $i, $v[$i]);\n", (1 << $i);
+    }
+    if ($paged) {
+        &write_page_ctx_call($fnsfh, $op, "    ");
+    }
 }
 
 
@@ -1232,11 +1412,79 @@ sub add_op() {
     print "$filename\n";
     print "$line\n";
 
+    # which args are the same every time a given tb executes.
+    # only info-flow ops (the ones inside tbs) get tb templates, so only they count.
+    if ($line =~ /iferret_log_info_flow_op_write/) {
+        my $mask = &static_arg_mask($fmt, \@rest);
+        if (exists $rhOps->{$opname}{static}) {
+            $rhOps->{$opname}{static} &= $mask;
+        }
+        else {
+            $rhOps->{$opname}{static} = $mask;
+        }
+    }
+
+    # page-walk args.  every site has to agree, since all writers for 
+    # the format leave them out.
+    my $page = &page_arg_mask($fmt, \@rest);
+    if (exists $rhOps->{$opname}{page}) {
+        $rhOps->{$opname}{page} &= $page;
+    }
+    else {
+        $rhOps->{$opname}{page} = $page;
+    }
 
     $rhOps->{$opname}{format} = $fmt;
 }
 
 
+# bitmask of args that are static, i.e. fixed when the tb is translated.
+# dyngen params, template constants, and register base addresses are.
+# anything we can't make sense of isn't.
+sub static_arg_mask() {
+    my ($fmt, $raArgs) = @_;
+
+    if ($fmt eq "0" || (scalar @{$raArgs}) != length $fmt) {
+        return 0;
+    }
+    my $mask = 0;
+    for (my $i=0; $i<length $fmt; $i++) {
+        my $arg = $raArgs->[$i];
+        $arg =~ s/^\s+//g;
+        $arg =~ s/\s+$//g;
+        if ($arg =~ /^PARAM[1-3]$/
+            || $arg =~ /^PTR_TO_ADDR\(env\)\s*\+\s*PARAM[1-3]$/
+            || $arg =~ /^(SHIFT|MEMSUFFIXNUM)$/
+            || $arg =~ /^[A-Z][A-Z0-9]*_BASE$/
+            || $arg =~ /^(0x[0-9a-fA-F]+|[0-9]+)$/) {
+            $mask |= (1 << $i);
+        }
+    }
+    return $mask;
+}
+
+
+
+# bitmask of args that are covered by the page context (see page_fmt),
+# i.e. phys_a0() and the pinfo_glob page walk.  0 if the op isn't like that.
+sub page_arg_mask() {
+    my ($fmt, $raArgs) = @_;
+
+    if (!&page_fmt($fmt) || (scalar @{$raArgs}) != length $fmt) {
+        return 0;
+    }
+    my @want = ("phys_a0()", "A0", "pinfo_glob.pdpe_addr", "pinfo_glob.pde_addr", "pinfo_glob.pte_addr");
+    for (my $i=0; $i<5; $i++) {
+        my $arg = $raArgs->[$i+1];
+        $arg =~ s/\s+//g;
+        if ($arg ne $want[$i]) {
+            return 0;
+        }
+    }
+    return $page_mask;
+}
+
+
 
 sub add_socketcall() {
     my ($raSocketcalls, $opname, $args, $line, $fmt) = @_;
@@ -38,7 +38,6 @@
 #define IFERRET_LOGTHING
 #endif
 
-extern uint8_t iferret_says_flush;
 extern uint8_t iferret_info_flow;
 
 /* n must be a constant to be efficient */
@@ -2961,6 +2960,8 @@ void OPPROTO glue(op_invlpga,IFERRET_LOGTHING)(void)
 
 void check_rollup_op(void);
 void write_eip_to_iferret_log(target_ulong pc);
+void iferret_tb_enter(uint32_t schema);
+void iferret_tb_skip(void);
 //void helper_manage_pid_stuff(void);
 
 // Note: The fn calls within this op need to take no 
@@ -2968,12 +2969,27 @@ void write_eip_to_iferret_log(target_ulong pc);
 // inside helper.c and involves global variables.
 void OPPROTO glue(op_iferret_prologue,IFERRET_LOGTHING)(void) 
 {
-  // check if info flow log is anywhere near overflow
-  check_rollup_op();
+  // info flow log has hit its guard page.  see iferret_log.c
+  if (iferret_log_full)
+    check_rollup_op();
   // write eip of head of this tb
   write_eip_to_iferret_log(PARAM1);
+  // start logging this tb against its template
+  iferret_tb_enter(PARAM2);
   // manage PID stuff.  
 //  helper_manage_pid_stuff();
 }
 
+// prologue for tbs the trace filter left out.  see iferret_tb_cflags.
+void OPPROTO glue(op_iferret_prologue_untraced,IFERRET_LOGTHING)(void) 
+{
+  // helpers can still log from in here
+  if (iferret_log_full)
+    check_rollup_op();
+  // close the template of a traced tb chained into this one
+  if (iferret_log_tb_state != IFERRET_TB_NONE)
+    iferret_tb_skip();
+  FORCE_RET();
+}
+
 
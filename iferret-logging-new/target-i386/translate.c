@@ -3334,9 +3334,16 @@ static target_ulong disas_insn(DisasContext *s, target_ulong pc_start)
         count = get_instruction_string(&inst, FORMAT_INTEL, pc_start, disas_string, sizeof(disas_string));
     }
 
-    if(iferret_info_flow)
-        iferret_log_op_write_4s(IFLO_INSN_DIS, pc_start, disas_string);
-    gen_op_log_insn(pc_start, inst.length);
+    if(s->tb->cflags & CF_IFERRET_INFO_FLOW) {
+        uint32_t phys_page, dis_id;
+        int dis_new;
+        phys_page = get_phys_addr_code(cpu_single_env, pc_start) & TARGET_PAGE_MASK;
+        dis_id = iferret_log_insn_dis_id(phys_page, pc_start, data, inst.length, &dis_new);
+        if (dis_new)
+            iferret_log_op_write_4s(IFLO_INSN_DIS_STR, dis_id, disas_string);
+        iferret_log_op_write_44(IFLO_INSN_DIS, pc_start, dis_id);
+        gen_op_log_insn(pc_start, inst.length);
+    }
 
     /* Ok, now move on to the real stuff... */
 
@@ -6854,6 +6861,27 @@ static void optimize_flags(uint16_t *opc_buf, int opc_buf_len)
     }
 }
 
+/* what disas_insn logs for an instruction of a traced tb: its
+   IFLO_INSN_DIS, and its IFLO_INSN_DIS_STR if the string is new. The
+   string is under 256 chars (disas_string). */
+#define IFERRET_INSN_DIS_LOG_MAX (2 * IFERRET_LOG_OP_MAX_SIZE + 4 + 256)
+
+/* most the tb could log if it got one more instruction. keeps what a
+   tb logs under IFERRET_LOG_TB_BUDGET, which is what the log's cushion
+   is sized by (see iferret_log.h). Counting a record for every op is
+   generous: most ops log one record or none, the few that log more
+   (in/out, cmpxchg) come with ops that log none, and the prologue logs
+   two. A traced tb also logs each instruction's disassembly while it
+   is being translated. In an untraced tb only helpers log, one record
+   per instruction at most. */
+static inline int iferret_tb_log_max(TranslationBlock *tb, int nb_ops, int num_insns)
+{
+    if (tb->cflags & CF_IFERRET_INFO_FLOW)
+        return (nb_ops + 1 + MAX_OP_PER_INSTR) * IFERRET_LOG_OP_MAX_SIZE
+            + (num_insns + 1) * IFERRET_INSN_DIS_LOG_MAX;
+    return (num_insns + 1) * IFERRET_LOG_OP_MAX_SIZE;
+}
+
 /* generate intermediate code in gen_opc_buf and gen_opparam_buf for
    basic block 'tb'. If search_pc is TRUE, also generate PC
    information for each intermediate instruction. */
@@ -6864,7 +6892,7 @@ static inline int gen_intermediate_code_internal(CPUState *env,
     DisasContext dc1, *dc = &dc1;
     target_ulong pc_ptr;
     uint16_t *gen_opc_end;
-    int j, lj, cflags;
+    int j, lj, cflags, num_insns;
     uint64_t flags;
     target_ulong pc_start;
     target_ulong cs_base;
@@ -6924,11 +6952,16 @@ static inline int gen_intermediate_code_internal(CPUState *env,
     dc->is_jmp = DISAS_NEXT;
     pc_ptr = pc_start;
     lj = -1;
+    num_insns = 0;
     
     // TRL 0901 add a prologue to head of every translation block
     // to manage info-flow stuff. 
     // Look at op.c/op_info_flow_prologue() to know what this contains.
-    gen_op_iferret_prologue(pc_start);
+    // tbs the trace filter left out get a prologue that logs nothing.
+    if (tb->cflags & CF_IFERRET_INFO_FLOW)
+        gen_op_iferret_prologue(pc_start, tb->iferret_schema);
+    else
+        gen_op_iferret_prologue_untraced();
 
     for(;;) {
         if (env->nb_breakpoints > 0) {
@@ -6966,9 +6999,11 @@ static inline int gen_intermediate_code_internal(CPUState *env,
             gen_eob(dc);
             break;
         }
+        num_insns++;
         /* if too long translation, stop generation too */
         if (gen_opc_ptr >= gen_opc_end ||
-            (pc_ptr - pc_start) >= (TARGET_PAGE_SIZE - 32)) {
+            (pc_ptr - pc_start) >= (TARGET_PAGE_SIZE - 32) ||
+            iferret_tb_log_max(tb, gen_opc_ptr - gen_opc_buf, num_insns) > IFERRET_LOG_TB_BUDGET) {
             gen_jmp_im(pc_ptr - dc->cs_base);
             gen_eob(dc);
             break;
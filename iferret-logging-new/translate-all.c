@@ -29,6 +29,7 @@
 #include "cpu.h"
 #include "exec-all.h"
 #include "disas.h"
+#include "iferret_log.h"
 
 extern int dyngen_code(uint8_t *gen_code_buf,
                        uint16_t *label_offsets, uint16_t *jmp_offsets,
@@ -222,6 +223,9 @@ int cpu_gen_code(CPUState *env, TranslationBlock *tb, int *gen_code_size_ptr)
     uint8_t *gen_code_buf;
     int gen_code_size;
 
+    // each tb gets its own log template.  see iferret_log.h
+    tb->iferret_schema = (tb->cflags & CF_IFERRET_INFO_FLOW) ? iferret_log_tb_schema_new() : IFERRET_TB_NO_SCHEMA;
+
     if (gen_intermediate_code(env, tb) < 0)
         return -1;
     
@@ -235,7 +239,7 @@ int cpu_gen_code(CPUState *env, TranslationBlock *tb, int *gen_code_size_ptr)
     tb->tb_jmp_offset[3] = 0xffff;
 #endif
 
-    if (iferret_info_flow) {
+    if (tb->cflags & CF_IFERRET_INFO_FLOW) {
       dyngen_labels__info_flow(gen_labels, nb_gen_labels, gen_code_buf, gen_opc_buf);
       gen_code_size = dyngen_code__info_flow
     (gen_code_buf, tb->tb_next_offset,
@@ -294,7 +298,7 @@ int cpu_restore_state(TranslationBlock *tb,
         c = *opc_ptr;
         if (c == INDEX_op_end)
             return -1;
-        if (iferret_info_flow) {
+        if (tb->cflags & CF_IFERRET_INFO_FLOW) {
             tc_ptr += opc_iferret_info_flow_copy_size[c];
         }
         else {
@@ -53,6 +53,7 @@
 
 // BDG 05/18/2009
 #include "target-i386/iferret_intro.h"
+#include "target-i386/iferret_filter.h"
 
 #ifndef _WIN32
 #include <sys/times.h>
@@ -7582,6 +7583,9 @@ static void help(int exitcode)
 #endif
            "-name string    set the name of the guest\n"
            "-os string      set the target OS for introspection\n"
+           "-iferret_codec c  compress iferret log chunks with codec c [none, zlib]\n"
+           "-iferret_mmap   write iferret log straight into mmap'd chunk files\n"
+           "-iferret_filter spec  only trace what spec picks [cr3=X,pid=N,va=A-B,...]\n"
            "\n"
            "Network options:\n"
            "-net nic[,vlan=n][,macaddr=addr][,model=type]\n"
@@ -7768,7 +7772,13 @@ enum {
     QEMU_OPTION_os,
 
     // TRL 0907
-    QEMU_OPTION_iferret_log
+    QEMU_OPTION_iferret_log,
+
+    QEMU_OPTION_iferret_codec,
+
+    QEMU_OPTION_iferret_mmap,
+
+    QEMU_OPTION_iferret_filter
 
 };
 
@@ -7889,6 +7899,9 @@ const QEMUOption qemu_options[] = {
 
     // TRL 0907
     { "iferret_log", HAS_ARG, QEMU_OPTION_iferret_log },
+    { "iferret_codec", HAS_ARG, QEMU_OPTION_iferret_codec },
+    { "iferret_mmap", 0, QEMU_OPTION_iferret_mmap },
+    { "iferret_filter", HAS_ARG, QEMU_OPTION_iferret_filter },
 
     { NULL },
 };
@@ -8751,6 +8764,24 @@ int main(int argc, char **argv)
 	      }
 	      break;
 
+	    case QEMU_OPTION_iferret_codec:
+	      if (!iferret_log_codec_select(optarg)) {
+		fprintf(stderr, "Unrecognized iferret codec, valid options: [none, zlib]\n");
+		exit(1);
+	      }
+	      break;
+
+	    case QEMU_OPTION_iferret_mmap:
+	      iferret_log_mmap = 1;
+	      break;
+
+	    case QEMU_OPTION_iferret_filter:
+	      if (!iferret_filter_add(optarg)) {
+		fprintf(stderr, "Bad iferret filter '%s', expected items like cr3=X,pid=N,va=A-B\n", optarg);
+		exit(1);
+	      }
+	      break;
+
             
 // TRL 0805 disables tb caching
 /*